@@ -0,0 +1,1192 @@
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <signal.h>
+#include <time.h>
+
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+#include "core/game.h"
+#include "core/config.h"
+#include "core/random.h"
+#include "entities/cell.h"
+#include "system/checkpoint.h"
+#include "system/performance.h"
+
+// Headless training: same simulation as the windowed build, without SDL video,
+// renderer, sprites or frame pacing. Runs the update loop as fast as possible.
+
+typedef struct {
+    int generations;        // Generations to run (0 = until interrupted)
+    unsigned int seed;
+    bool hasSeed;
+    int threads;            // 0 = OpenMP default, 1 = single-threaded
+    const char *outputDir;
+    const char *loadFile;
+    int reportInterval;     // Print a line every N generations (0 = quiet)
+    NeuralKernel kernel;    // Fastest dense layer kernel allowed
+    bool checkKernels;      // Only compare the kernels with the scalar reference
+    NeuralActivation activation;
+    bool checkActivation;   // Only compare the fast tanh with the exact one
+    InferenceBackend backend;
+    InferenceBackend shadow;
+    int shadowInterval;     // Shadow one cell in N per tick (0 = no shadow)
+    bool checkQuant;        // Only compare the int8 networks with the regular ones
+    int decisionInterval;   // Ticks between two decisions of a cell
+    bool benchDecisions;    // Only compare the decision intervals 1 to BENCH_DECISION_MAX
+    double pruneFraction;   // Share of the weight blocks dropped by the pruned backend
+    bool checkPruned;       // Only compare the pruned networks with the regular ones
+} HeadlessOptions;
+
+#define BENCH_DECISION_MAX 8
+#define PRUNE_FRACTIONS { 0.0, 0.25, 0.5, 0.75, 0.9, 0.95 }
+
+static volatile sig_atomic_t g_interrupted = 0;
+
+static void on_interrupt(int signal)
+{
+    (void)signal;
+    g_interrupted = 1;
+}
+
+static void print_usage(const char *program)
+{
+    printf("Usage: %s [options]\n"
+           "  -g, --generations N   Generations to run (default 100, 0 = until Ctrl+C)\n"
+           "  -s, --seed N          Random seed (default: current time)\n"
+           "  -t, --threads N       Worker threads (default: OpenMP default, 1 = no multithreading)\n"
+           "  -o, --output DIR      Directory for checkpoints and best.nn (default %s)\n"
+           "  -l, --load FILE       Start from a saved neural network\n"
+           "  -r, --report N        Print progress every N generations (default 1, 0 = quiet)\n"
+           "  -k, --kernel NAME     Fastest neural network kernel to use: scalar, sse2, avx2, avx512 (default avx512)\n"
+           "      --check-kernels   Compare the neural network kernels with the scalar one and exit\n"
+           "  -a, --activation NAME Neuron activation: exact (libm tanh) or fast (default %s)\n"
+           "      --check-activation Compare the fast tanh with the exact one, and the outputs of the\n"
+           "                        network given with -l (else a random one) under both, then exit\n"
+           "  -b, --backend NAME    Inference backend: reference (scalar kernel), simd, batched, int8\n"
+           "                        (int8 copies of the networks, evaluation runs), pruned (the smallest\n"
+           "                        weights dropped, evaluation runs) (default batched)\n"
+           "      --no-batch        Same as -b simd: each cell's network on its own\n"
+           "  -q, --quantized       Same as -b int8\n"
+           "      --shadow NAME     Also run this backend on sampled cells and report how far it diverges\n"
+           "      --shadow-every N  Sample one cell in N per tick for the shadow (default 16)\n"
+           "      --check-quant     Compare the int8 kernels with each other, and the outputs and speed of the\n"
+           "                        network given with -l (else a random one) in int8 and %s, then exit\n"
+           "      --prune F         Share of the weights dropped by the pruned backend, in [0, 1), required\n"
+           "                        by -b pruned: measure it first with --check-pruned\n"
+           "      --check-pruned    Compare the outputs, decisions, size and speed of the network given with -l\n"
+           "                        (else a random one) pruned at several shares with the unpruned one, then exit\n"
+           "  -d, --decide-every N  Cells sense and run their network every N ticks (default %d)\n"
+           "      --bench-decisions Train the same world with -d 1 to %d for -g generations each, then compare\n"
+           "                        their speed and the scores reached\n"
+           "  -h, --help            Show this help\n",
+           program, CHECKPOINT_DIR, NeuralNetwork_ActivationName(NeuralNetwork_ActiveActivation()),
+           NEURAL_PRECISION_NAME, CELL_DECISION_INTERVAL, BENCH_DECISION_MAX);
+}
+
+static bool parse_int(const char *text, int min, int *value)
+{
+    char *end;
+    long parsed = strtol(text, &end, 10);
+    if (*text == '\0' || *end != '\0' || parsed < min || parsed > 1000000000L)
+        return false;
+    *value = (int)parsed;
+    return true;
+}
+
+static bool parse_fraction(const char *text, double *value)
+{
+    char *end;
+    double parsed = strtod(text, &end);
+    if (*text == '\0' || *end != '\0' || !(parsed >= 0.0 && parsed < 1.0))
+        return false;
+    *value = parsed;
+    return true;
+}
+
+static bool parse_kernel(const char *text, NeuralKernel *kernel)
+{
+    for (int i = 0; i < NEURAL_KERNEL_COUNT; i++)
+    {
+        if (strcmp(text, NeuralNetwork_KernelName((NeuralKernel)i)) == 0)
+        {
+            *kernel = (NeuralKernel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parse_activation(const char *text, NeuralActivation *activation)
+{
+    for (int i = 0; i < NEURAL_ACTIVATION_COUNT; i++)
+    {
+        if (strcmp(text, NeuralNetwork_ActivationName((NeuralActivation)i)) == 0)
+        {
+            *activation = (NeuralActivation)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Returns 0 to run, 1 on error, -1 when only the help was requested
+static int parse_options(int argc, char *argv[], HeadlessOptions *options)
+{
+    options->generations = 100;
+    options->seed = 0;
+    options->hasSeed = false;
+    options->threads = 0;
+    options->outputDir = CHECKPOINT_DIR;
+    options->loadFile = NULL;
+    options->reportInterval = 1;
+    options->kernel = NEURAL_KERNEL_COUNT - 1;
+    options->checkKernels = false;
+    options->activation = NeuralNetwork_ActiveActivation();
+    options->checkActivation = false;
+    options->backend = INFERENCE_BATCHED;
+    options->shadow = INFERENCE_REFERENCE;
+    options->shadowInterval = 0;
+    bool shadowed = false;
+    int shadowInterval = 16;
+    bool pruneGiven = false;
+    options->checkQuant = false;
+    options->decisionInterval = CELL_DECISION_INTERVAL;
+    options->benchDecisions = false;
+    options->pruneFraction = NEURAL_NETWORK_PRUNE_FRACTION;
+    options->checkPruned = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+        bool ok = true;
+
+        if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0)
+        {
+            print_usage(argv[0]);
+            return -1;
+        }
+
+        if (strcmp(arg, "--check-kernels") == 0)
+        {
+            options->checkKernels = true;
+            continue;
+        }
+        if (strcmp(arg, "--check-activation") == 0)
+        {
+            options->checkActivation = true;
+            continue;
+        }
+        if (strcmp(arg, "--no-batch") == 0)
+        {
+            options->backend = INFERENCE_SIMD;
+            continue;
+        }
+        if (strcmp(arg, "-q") == 0 || strcmp(arg, "--quantized") == 0)
+        {
+            options->backend = INFERENCE_QUANTIZED;
+            continue;
+        }
+        if (strcmp(arg, "--check-quant") == 0)
+        {
+            options->checkQuant = true;
+            continue;
+        }
+        if (strcmp(arg, "--bench-decisions") == 0)
+        {
+            options->benchDecisions = true;
+            continue;
+        }
+        if (strcmp(arg, "--check-pruned") == 0)
+        {
+            options->checkPruned = true;
+            continue;
+        }
+
+        if (value == NULL)
+        {
+            fprintf(stderr, "Missing value for option %s\n", arg);
+            return 1;
+        }
+
+        if (strcmp(arg, "-g") == 0 || strcmp(arg, "--generations") == 0)
+            ok = parse_int(value, 0, &options->generations);
+        else if (strcmp(arg, "-s") == 0 || strcmp(arg, "--seed") == 0)
+        {
+            int seed;
+            ok = parse_int(value, 0, &seed);
+            options->seed = (unsigned int)seed;
+            options->hasSeed = true;
+        }
+        else if (strcmp(arg, "-t") == 0 || strcmp(arg, "--threads") == 0)
+            ok = parse_int(value, 1, &options->threads);
+        else if (strcmp(arg, "-o") == 0 || strcmp(arg, "--output") == 0)
+            options->outputDir = value;
+        else if (strcmp(arg, "-l") == 0 || strcmp(arg, "--load") == 0)
+            options->loadFile = value;
+        else if (strcmp(arg, "-r") == 0 || strcmp(arg, "--report") == 0)
+            ok = parse_int(value, 0, &options->reportInterval);
+        else if (strcmp(arg, "-k") == 0 || strcmp(arg, "--kernel") == 0)
+            ok = parse_kernel(value, &options->kernel);
+        else if (strcmp(arg, "-a") == 0 || strcmp(arg, "--activation") == 0)
+            ok = parse_activation(value, &options->activation);
+        else if (strcmp(arg, "-b") == 0 || strcmp(arg, "--backend") == 0)
+            ok = Inference_ParseBackend(value, &options->backend);
+        else if (strcmp(arg, "--shadow") == 0)
+        {
+            ok = Inference_ParseBackend(value, &options->shadow);
+            shadowed = true;
+        }
+        else if (strcmp(arg, "--shadow-every") == 0)
+            ok = parse_int(value, 1, &shadowInterval);
+        else if (strcmp(arg, "-d") == 0 || strcmp(arg, "--decide-every") == 0)
+            ok = parse_int(value, 1, &options->decisionInterval);
+        else if (strcmp(arg, "--prune") == 0)
+        {
+            ok = parse_fraction(value, &options->pruneFraction);
+            pruneGiven = true;
+        }
+        else
+        {
+            fprintf(stderr, "Unknown option %s\n", arg);
+            print_usage(argv[0]);
+            return 1;
+        }
+
+        if (!ok)
+        {
+            fprintf(stderr, "Invalid value for option %s: %s\n", arg, value);
+            return 1;
+        }
+        i++;
+    }
+
+    // No share of pruned weights keeps the decisions of every network, so it is never implied
+    if (options->backend == INFERENCE_PRUNED && !pruneGiven)
+    {
+        fprintf(stderr, "-b pruned needs --prune F, see --check-pruned for how far a share changes the decisions\n");
+        return 1;
+    }
+
+    options->shadowInterval = shadowed ? shadowInterval : 0;
+    return 0;
+}
+
+// Give every cell the saved network
+static bool load_network(Map *map, const char *filename)
+{
+    NeuralNetwork *nn = Game_load(map, (char *)filename);
+    if (nn == NULL)
+    {
+        fprintf(stderr, "Failed to load neural network from %s\n", filename);
+        return false;
+    }
+
+    bool ok = true;
+    for (int i = 0; i < map->population.count && ok; ++i)
+    {
+        if (!NeuralNetwork_Assign(&map->population.cells[i].nn, nn))
+        {
+            fprintf(stderr, "Failed to copy NeuralNetwork !\n");
+            ok = false;
+        }
+        map->population.networkChanged[i] = true;
+    }
+
+    freeNeuralNetwork(nn);
+    return ok;
+}
+
+// Pack a block of random networks and compare the batched outputs with the
+// scalar forward pass of each network. Every other trial leaves the last lane
+// empty, every third input is zero in all lanes (skipped by the first layer).
+static bool check_batch(NeuralKernel kernel, const int *topology, int topologySize, int trials,
+                        double *maxDifference, long long *compared)
+{
+    const int lanes = NEURAL_BATCH_LANES;
+    int inputCount = topology[0];
+    int outputCount = topology[topologySize - 1];
+    NeuralBatch batch;
+    NeuralWorkspace workspace;
+    NeuralNetwork *networks[NEURAL_BATCH_LANES] = { NULL };
+    NeuralScalar *inputs = malloc(lanes * inputCount * sizeof(NeuralScalar));
+    NeuralScalar *reference = malloc(lanes * outputCount * sizeof(NeuralScalar));
+    NeuralScalar *outputs = malloc(lanes * outputCount * sizeof(NeuralScalar));
+    bool ok = inputs != NULL && reference != NULL && outputs != NULL;
+    bool batchReady = ok && NeuralBatch_Init(&batch, topology, topologySize, lanes);
+    bool workspaceReady = batchReady && NeuralWorkspace_Init(&workspace, NeuralBatch_WorkspaceSize(&batch));
+    ok = workspaceReady;
+    for (int lane = 0; lane < lanes && ok; lane++)
+    {
+        networks[lane] = createNeuralNetwork((int *)topology, topologySize);
+        ok = networks[lane] != NULL;
+    }
+    if (!ok)
+        fprintf(stderr, "Failed to allocate memory for the kernel check !\n");
+
+    for (int trial = 0; trial < trials && ok; trial++)
+    {
+        const NeuralScalar *laneInputs[NEURAL_BATCH_LANES];
+        NeuralScalar *laneOutputs[NEURAL_BATCH_LANES];
+        int used = trial % 2 == 0 ? lanes : lanes - 1;
+
+        for (int lane = 0; lane < lanes; lane++)
+        {
+            setRandomWeights(networks[lane], -1, 1);
+            for (int i = 0; i < inputCount; i++)
+                inputs[lane * inputCount + i] = i % 3 == 2 ? 0 : drand(-1, 1);
+            NeuralBatch_Pack(&batch, lane, networks[lane]);
+            laneInputs[lane] = lane < used ? &inputs[lane * inputCount] : NULL;
+            laneOutputs[lane] = lane < used ? &outputs[lane * outputCount] : NULL;
+        }
+
+        NeuralNetwork_SelectKernel(NEURAL_KERNEL_SCALAR);
+        for (int lane = 0; lane < used; lane++)
+            NeuralNetwork_Forward(networks[lane], &inputs[lane * inputCount], &reference[lane * outputCount], &workspace);
+        NeuralNetwork_SelectKernel(kernel);
+        NeuralBatch_Forward(&batch, 0, laneInputs, laneOutputs, &workspace);
+
+        for (int i = 0; i < used * outputCount; i++)
+            *maxDifference = MAX(*maxDifference, fabs(outputs[i] - reference[i]));
+        *compared += used * outputCount;
+    }
+
+    for (int lane = 0; lane < lanes; lane++)
+        if (networks[lane] != NULL)
+            freeNeuralNetwork(networks[lane]);
+    if (workspaceReady)
+        NeuralWorkspace_Free(&workspace);
+    if (batchReady)
+        NeuralBatch_Free(&batch);
+    free(inputs);
+    free(reference);
+    free(outputs);
+    return ok;
+}
+
+// Compare the pass specialized for NEURAL_NETWORK_TOPOLOGY with the generic
+// layer-by-layer pass of the same kernel, and its sparse-input variant with
+// itself: about half the inputs are zero, skipping them must not change a bit
+static bool check_fixed(int trials, double *maxDifference, double *sparseDifference, long long *compared)
+{
+    int topology[] = NEURAL_NETWORK_TOPOLOGY;
+    int topologySize = sizeof(topology) / sizeof(topology[0]);
+    NeuralNetwork *nn = createNeuralNetwork(topology, topologySize);
+    int count = nn != NULL ? NeuralNetwork_ActivationCount(nn) : 0;
+    int outputCount = topology[topologySize - 1];
+    NeuralWorkspace workspace;
+    bool workspaceReady = nn != NULL && NeuralWorkspace_Init(&workspace, NeuralNetwork_MaxWidth(nn));
+    NeuralScalar *inputs = malloc(topology[0] * sizeof(NeuralScalar));
+    NeuralScalar *reference = malloc(count * sizeof(NeuralScalar));
+    NeuralScalar *outputs = malloc(outputCount * sizeof(NeuralScalar));
+    NeuralScalar *sparse = malloc(outputCount * sizeof(NeuralScalar));
+    uint8_t *activeInputs = malloc(topology[0] * sizeof(uint8_t));
+    bool ok = workspaceReady && inputs != NULL && reference != NULL && outputs != NULL && sparse != NULL
+              && activeInputs != NULL && nn->fixedTopology;
+    if (!ok)
+        fprintf(stderr, "Failed to allocate memory for the kernel check !\n");
+
+    for (int trial = 0; trial < trials && ok; trial++)
+    {
+        setRandomWeights(nn, -1, 1);
+        for (int i = 0; i < topology[0]; i++)
+            inputs[i] = drand(0, 1) < 0.5 ? 0 : drand(-1, 1);
+        int activeCount = NeuralNetwork_ActiveInputs(inputs, topology[0], activeInputs);
+
+        NeuralNetwork_ForwardCapture(nn, inputs, reference);
+        NeuralNetwork_Forward(nn, inputs, outputs, &workspace);
+        NeuralNetwork_ForwardSparse(nn, inputs, activeInputs, activeCount, sparse, &workspace);
+
+        for (int j = 0; j < outputCount; j++)
+        {
+            *maxDifference = MAX(*maxDifference, fabs(outputs[j] - reference[count - outputCount + j]));
+            *sparseDifference = MAX(*sparseDifference, fabs(sparse[j] - outputs[j]));
+        }
+        *compared += outputCount;
+    }
+
+    if (workspaceReady)
+        NeuralWorkspace_Free(&workspace);
+    if (nn != NULL)
+        freeNeuralNetwork(nn);
+    free(inputs);
+    free(reference);
+    free(outputs);
+    free(sparse);
+    free(activeInputs);
+    return ok;
+}
+
+// Run random networks through every supported kernel and compare all their
+// activations with the scalar reference. Odd layer widths exercise the tails.
+static int check_kernels(void)
+{
+    int defaultTopology[] = NEURAL_NETWORK_TOPOLOGY;
+    int oddTopology[] = { 13, 45, 7, 3 };
+    int *topologies[] = { defaultTopology, oddTopology };
+    int topologySizes[] = { sizeof(defaultTopology) / sizeof(defaultTopology[0]),
+                            sizeof(oddTopology) / sizeof(oddTopology[0]) };
+    const int trials = 50;
+    int failures = 0;
+
+    for (int kernel = NEURAL_KERNEL_SCALAR; kernel < NEURAL_KERNEL_COUNT; kernel++)
+    {
+        const char *name = NeuralNetwork_KernelName((NeuralKernel)kernel);
+        if ((int)NeuralNetwork_SelectKernel((NeuralKernel)kernel) != kernel)
+        {
+            printf("%-7s not supported by this CPU\n", name);
+            continue;
+        }
+
+        double maxDifference = 0.0;
+        long long compared = 0;
+        for (int t = 0; t < 2 && kernel != NEURAL_KERNEL_SCALAR; t++)
+        {
+            NeuralNetwork *nn = createNeuralNetwork(topologies[t], topologySizes[t]);
+            int count = nn != NULL ? NeuralNetwork_ActivationCount(nn) : 0;
+            NeuralScalar *inputs = malloc(topologies[t][0] * sizeof(NeuralScalar));
+            NeuralScalar *reference = malloc(count * sizeof(NeuralScalar));
+            NeuralScalar *activations = malloc(count * sizeof(NeuralScalar));
+            if (nn == NULL || inputs == NULL || reference == NULL || activations == NULL)
+            {
+                fprintf(stderr, "Failed to allocate memory for the kernel check !\n");
+                if (nn != NULL)
+                    freeNeuralNetwork(nn);
+                free(inputs);
+                free(reference);
+                free(activations);
+                return 1;
+            }
+
+            for (int trial = 0; trial < trials; trial++)
+            {
+                setRandomWeights(nn, -1, 1);
+                for (int i = 0; i < topologies[t][0]; i++)
+                    inputs[i] = drand(-1, 1);
+
+                NeuralNetwork_SelectKernel(NEURAL_KERNEL_SCALAR);
+                NeuralNetwork_ForwardCapture(nn, inputs, reference);
+                NeuralNetwork_SelectKernel((NeuralKernel)kernel);
+                NeuralNetwork_ForwardCapture(nn, inputs, activations);
+
+                for (int i = 0; i < count; i++)
+                    maxDifference = MAX(maxDifference, fabs(activations[i] - reference[i]));
+                compared += count;
+            }
+
+            freeNeuralNetwork(nn);
+            free(inputs);
+            free(reference);
+            free(activations);
+        }
+
+        bool ok = maxDifference <= NEURAL_KERNEL_TOLERANCE;
+        if (kernel != NEURAL_KERNEL_SCALAR)
+        {
+            printf("%-7s max difference %.3g over %lld activations (tolerance %.0e)  %s\n",
+                   name, maxDifference, compared, NEURAL_KERNEL_TOLERANCE, ok ? "OK" : "FAILED");
+            if (!ok)
+                failures++;
+        }
+
+        maxDifference = 0.0;
+        compared = 0;
+        double sparseDifference = 0.0;
+        if (!check_fixed(trials, &maxDifference, &sparseDifference, &compared))
+            return 1;
+        ok = maxDifference <= NEURAL_KERNEL_TOLERANCE;
+        printf("%-7s fixed max difference %.3g over %lld outputs (tolerance %.0e)  %s\n",
+               name, maxDifference, compared, NEURAL_KERNEL_TOLERANCE, ok ? "OK" : "FAILED");
+        if (!ok)
+            failures++;
+        ok = sparseDifference == 0.0;
+        printf("%-7s sparse max difference %.3g over %lld outputs (exact)  %s\n",
+               name, sparseDifference, compared, ok ? "OK" : "FAILED");
+        if (!ok)
+            failures++;
+
+        maxDifference = 0.0;
+        compared = 0;
+        for (int t = 0; t < 2; t++)
+        {
+            if (!check_batch((NeuralKernel)kernel, topologies[t], topologySizes[t], trials,
+                             &maxDifference, &compared))
+                return 1;
+        }
+        ok = maxDifference <= NEURAL_KERNEL_TOLERANCE;
+        printf("%-7s batch max difference %.3g over %lld outputs (tolerance %.0e)  %s\n",
+               name, maxDifference, compared, NEURAL_KERNEL_TOLERANCE, ok ? "OK" : "FAILED");
+        if (!ok)
+            failures++;
+    }
+
+    return failures > 0 ? 1 : 0;
+}
+
+// Network of the check modes: the one given with -l, else a random one
+static NeuralNetwork *check_network(const HeadlessOptions *options)
+{
+    NeuralNetwork *nn = NULL;
+    if (options->loadFile != NULL)
+    {
+        Map *map = calloc(1, sizeof(Map));
+        if (map != NULL)
+            nn = Game_load(map, (char *)options->loadFile);
+        free(map);
+        if (nn == NULL)
+            fprintf(stderr, "Failed to load neural network from %s\n", options->loadFile);
+        return nn;
+    }
+
+    int topology[] = NEURAL_NETWORK_TOPOLOGY;
+    nn = createNeuralNetwork(topology, sizeof(topology) / sizeof(topology[0]));
+    if (nn == NULL)
+    {
+        fprintf(stderr, "Failed to create NeuralNetwork !\n");
+        return NULL;
+    }
+    setRandomWeights(nn, -1, 1);
+    return nn;
+}
+
+// Output differences and changed decisions, the end of a report line
+static void print_divergence(const InferenceDivergence *divergence)
+{
+    printf("max output difference %.3g, mean %.3g, decisions changed: direction %llu, turn %llu, reproduce %llu\n",
+           divergence->maxDifference, divergence->samples > 0 ? divergence->totalDifference / divergence->samples : 0.0,
+           (unsigned long long)divergence->flips[INFERENCE_DECISION_DIRECTION],
+           (unsigned long long)divergence->flips[INFERENCE_DECISION_TURN],
+           (unsigned long long)divergence->flips[INFERENCE_DECISION_REPRODUCE]);
+}
+
+// Compare the outputs of trials observations, trial after trial, with the
+// reference ones and print how far they drift
+static void compare_outputs(const NeuralScalar *reference, const NeuralScalar *outputs, int trials, int outputCount)
+{
+    InferenceDivergence divergence;
+    Inference_ResetDivergence(&divergence);
+    for (int trial = 0; trial < trials; trial++)
+        Inference_CompareOutputs(&divergence, &reference[trial * outputCount], &outputs[trial * outputCount], outputCount);
+    print_divergence(&divergence);
+}
+
+// Check the fast tanh of every supported kernel against libm over [-20, 20],
+// then run a network (the one given with -l, else a random one) on random
+// observations under both activations and count the decisions that change.
+static int check_activation(const HeadlessOptions *options)
+{
+    const int pointCount = 400001;
+    int trials = 10000;
+    int failures = 0;
+    NeuralScalar *points = malloc(pointCount * sizeof(NeuralScalar));
+    if (points == NULL)
+    {
+        fprintf(stderr, "Failed to allocate memory for the activation check !\n");
+        return 1;
+    }
+
+    NeuralNetwork_SetActivation(NEURAL_ACTIVATION_FAST);
+    for (int kernel = NEURAL_KERNEL_SCALAR; kernel < NEURAL_KERNEL_COUNT; kernel++)
+    {
+        const char *name = NeuralNetwork_KernelName((NeuralKernel)kernel);
+        if ((int)NeuralNetwork_SelectKernel((NeuralKernel)kernel) != kernel)
+        {
+            printf("%-7s not supported by this CPU\n", name);
+            continue;
+        }
+
+        for (int i = 0; i < pointCount; i++)
+            points[i] = (NeuralScalar)(-20.0 + 40.0 * i / (pointCount - 1));
+        NeuralNetwork_Activate(points, pointCount);
+
+        double maxError = 0.0;
+        for (int i = 0; i < pointCount; i++)
+        {
+            double x = (NeuralScalar)(-20.0 + 40.0 * i / (pointCount - 1));
+            maxError = MAX(maxError, fabs(points[i] - tanh(x)));
+        }
+
+        bool ok = maxError <= NEURAL_FAST_TANH_MAX_ERROR;
+        printf("%-7s fast tanh max error %.3g over [-20, 20] (bound %.0e)  %s\n",
+               name, maxError, NEURAL_FAST_TANH_MAX_ERROR, ok ? "OK" : "FAILED");
+        if (!ok)
+            failures++;
+    }
+    free(points);
+    NeuralNetwork_SelectKernel(options->kernel);
+
+    // Network under both activations
+    NeuralNetwork *nn = check_network(options);
+    if (nn == NULL)
+        return 1;
+
+    int inputCount = nn->topology[0];
+    int outputCount = nn->topology[nn->topologySize - 1];
+    NeuralWorkspace workspace;
+    NeuralScalar *inputs = malloc(inputCount * sizeof(NeuralScalar));
+    NeuralScalar *exact = malloc((size_t)trials * outputCount * sizeof(NeuralScalar));
+    NeuralScalar *fast = malloc((size_t)trials * outputCount * sizeof(NeuralScalar));
+    bool workspaceReady = NeuralWorkspace_Init(&workspace, NeuralNetwork_MaxWidth(nn));
+    if (!workspaceReady || inputs == NULL || exact == NULL || fast == NULL || outputCount < 3)
+    {
+        fprintf(stderr, "Failed to allocate memory for the activation check !\n");
+        failures++;
+        trials = 0;
+    }
+
+    for (int trial = 0; trial < trials; trial++)
+    {
+        // Observations are normalized to [0, 1], see Cell_encodeInputs
+        for (int i = 0; i < inputCount; i++)
+            inputs[i] = drand(0, 1);
+
+        NeuralNetwork_SetActivation(NEURAL_ACTIVATION_EXACT);
+        NeuralNetwork_Forward(nn, inputs, &exact[trial * outputCount], &workspace);
+        NeuralNetwork_SetActivation(NEURAL_ACTIVATION_FAST);
+        NeuralNetwork_Forward(nn, inputs, &fast[trial * outputCount], &workspace);
+    }
+
+    if (trials > 0)
+    {
+        printf("%s network, fast against exact tanh over %d observations: ",
+               options->loadFile != NULL ? options->loadFile : "Random", trials);
+        compare_outputs(exact, fast, trials, outputCount);
+    }
+
+    if (workspaceReady)
+        NeuralWorkspace_Free(&workspace);
+    free(inputs);
+    free(exact);
+    free(fast);
+    freeNeuralNetwork(nn);
+    return failures > 0 ? 1 : 0;
+}
+
+static double seconds_since(const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Int8 kernel allowed by -k, SSE2 has none
+static NeuralQuantKernel quant_kernel(NeuralKernel kernel)
+{
+    if (kernel >= NEURAL_KERNEL_AVX512)
+        return NEURAL_QUANT_KERNEL_AVX512_VNNI;
+    if (kernel >= NEURAL_KERNEL_AVX2)
+        return NEURAL_QUANT_KERNEL_AVX2;
+    return NEURAL_QUANT_KERNEL_SCALAR;
+}
+
+// Run a network (the one given with -l, else a random one) on random
+// observations in int8 with every supported int8 kernel, which must give the
+// same outputs, then measure how far the int8 outputs and decisions drift
+// from the regular forward pass, and the time per network of both.
+static int check_quant(const HeadlessOptions *options)
+{
+    const int trials = 10000;
+    NeuralNetwork *nn = check_network(options);
+    if (nn == NULL)
+        return 1;
+
+    int inputCount = nn->topology[0];
+    int outputCount = nn->topology[nn->topologySize - 1];
+    NeuralQuant quant;
+    NeuralWorkspace workspace;
+    bool quantReady = NeuralQuant_Init(&quant, nn->topology, nn->topologySize, 1);
+    bool workspaceReady = NeuralWorkspace_Init(&workspace, NeuralNetwork_MaxWidth(nn));
+    NeuralScalar *inputs = malloc((size_t)trials * inputCount * sizeof(NeuralScalar));
+    NeuralScalar *reference = malloc((size_t)trials * outputCount * sizeof(NeuralScalar));
+    NeuralScalar *scalar = malloc((size_t)trials * outputCount * sizeof(NeuralScalar));
+    NeuralScalar *quantized = malloc((size_t)trials * outputCount * sizeof(NeuralScalar));
+    int failures = 0;
+
+    bool ok = quantReady && workspaceReady && inputs != NULL && reference != NULL && scalar != NULL &&
+              quantized != NULL && outputCount >= 3;
+    if (!ok)
+        fprintf(stderr, "Failed to allocate memory for the int8 check !\n");
+    else if (!NeuralQuant_Pack(&quant, 0, nn))
+    {
+        fprintf(stderr, "Int8 networks need the shape of NEURAL_NETWORK_TOPOLOGY\n");
+        ok = false;
+    }
+
+    if (ok)
+    {
+        // Observations are normalized to [0, 1], see Cell_encodeInputs
+        for (int i = 0; i < trials * inputCount; i++)
+            inputs[i] = drand(0, 1);
+
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int trial = 0; trial < trials; trial++)
+            NeuralNetwork_Forward(nn, &inputs[trial * inputCount], &reference[trial * outputCount], &workspace);
+        double regularTime = seconds_since(&start) / trials;
+
+        for (int kernel = NEURAL_QUANT_KERNEL_SCALAR; kernel < NEURAL_QUANT_KERNEL_COUNT; kernel++)
+        {
+            const char *name = NeuralQuant_KernelName((NeuralQuantKernel)kernel);
+            if ((int)NeuralQuant_SelectKernel((NeuralQuantKernel)kernel) != kernel)
+            {
+                printf("%-11s not supported by this CPU\n", name);
+                continue;
+            }
+
+            NeuralScalar *outputs = kernel == NEURAL_QUANT_KERNEL_SCALAR ? scalar : quantized;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int trial = 0; trial < trials; trial++)
+                NeuralQuant_Forward(&quant, 0, &inputs[trial * inputCount], &outputs[trial * outputCount], &workspace);
+            double time = seconds_since(&start) / trials;
+
+            if (kernel == NEURAL_QUANT_KERNEL_SCALAR)
+            {
+                printf("%-11s %.2f us per network (%.1fx the speed of %s)\n",
+                       name, time * 1e6, regularTime / time, NEURAL_PRECISION_NAME);
+                continue;
+            }
+
+            double maxDifference = 0.0;
+            for (int i = 0; i < trials * outputCount; i++)
+                maxDifference = MAX(maxDifference, fabs(quantized[i] - scalar[i]));
+            bool same = maxDifference == 0.0;
+            printf("%-11s %.2f us per network (%.1fx the speed of %s), max difference %.3g from scalar  %s\n",
+                   name, time * 1e6, regularTime / time, NEURAL_PRECISION_NAME, maxDifference, same ? "OK" : "FAILED");
+            if (!same)
+                failures++;
+        }
+        NeuralQuant_SelectKernel(quant_kernel(options->kernel));
+
+        // Drift from the regular pass, decisions of Cell_applyOutputs included
+        printf("%s network: int8 against %s (%s kernel, %.2f us per network) over %d observations: ",
+               options->loadFile != NULL ? options->loadFile : "Random", NEURAL_PRECISION_NAME,
+               NeuralNetwork_KernelName(NeuralNetwork_ActiveKernel()), regularTime * 1e6, trials);
+        compare_outputs(reference, scalar, trials, outputCount);
+    }
+    else
+        failures++;
+
+    if (quantReady)
+        NeuralQuant_Free(&quant);
+    if (workspaceReady)
+        NeuralWorkspace_Free(&workspace);
+    free(inputs);
+    free(reference);
+    free(scalar);
+    free(quantized);
+    freeNeuralNetwork(nn);
+    return failures > 0 ? 1 : 0;
+}
+
+// Run a network (the one given with -l, else a random one) on random
+// observations pruned at each fraction of PRUNE_FRACTIONS. Unpruned, every
+// supported kernel must give the outputs of its dense pass; then, with the
+// kernel of -k, measure how far the outputs and decisions drift from the
+// dense pass, the memory kept and the time per network of both.
+static int check_pruned(const HeadlessOptions *options)
+{
+    static const double fractions[] = PRUNE_FRACTIONS;
+    const int fractionCount = sizeof(fractions) / sizeof(fractions[0]);
+    const int trials = 10000;
+    NeuralNetwork *nn = check_network(options);
+    if (nn == NULL)
+        return 1;
+
+    int inputCount = nn->topology[0];
+    int outputCount = nn->topology[nn->topologySize - 1];
+    NeuralPrune prune;
+    NeuralWorkspace workspace;
+    bool pruneReady = NeuralPrune_Init(&prune, nn->topology, nn->topologySize, 1, 0.0);
+    bool workspaceReady = NeuralWorkspace_Init(&workspace, NeuralNetwork_MaxWidth(nn));
+    NeuralScalar *inputs = malloc((size_t)trials * inputCount * sizeof(NeuralScalar));
+    NeuralScalar *reference = malloc((size_t)trials * outputCount * sizeof(NeuralScalar));
+    NeuralScalar *pruned = malloc((size_t)trials * outputCount * sizeof(NeuralScalar));
+    int failures = 0;
+
+    bool ok = pruneReady && workspaceReady && inputs != NULL && reference != NULL && pruned != NULL &&
+              outputCount >= 3;
+    if (!ok)
+        fprintf(stderr, "Failed to allocate memory for the pruning check !\n");
+    else if (!NeuralPrune_Pack(&prune, 0, nn))
+    {
+        fprintf(stderr, "Failed to prune the network !\n");
+        ok = false;
+    }
+
+    if (ok)
+    {
+        // Observations are normalized to [0, 1], see Cell_encodeInputs
+        for (int i = 0; i < trials * inputCount; i++)
+            inputs[i] = drand(0, 1);
+
+        for (int kernel = NEURAL_KERNEL_SCALAR; kernel < NEURAL_KERNEL_COUNT; kernel++)
+        {
+            const char *name = NeuralNetwork_KernelName((NeuralKernel)kernel);
+            if ((int)NeuralNetwork_SelectKernel((NeuralKernel)kernel) != kernel)
+            {
+                printf("%-7s not supported by this CPU\n", name);
+                continue;
+            }
+
+            double maxDifference = 0.0;
+            for (int trial = 0; trial < trials; trial++)
+            {
+                NeuralNetwork_Forward(nn, &inputs[trial * inputCount], &reference[trial * outputCount], &workspace);
+                NeuralPrune_Forward(&prune, 0, &inputs[trial * inputCount], &pruned[trial * outputCount], &workspace);
+            }
+            for (int i = 0; i < trials * outputCount; i++)
+                maxDifference = MAX(maxDifference, fabs(pruned[i] - reference[i]));
+            bool same = maxDifference == 0.0;
+            printf("%-7s unpruned: max difference %.3g from the dense pass  %s\n",
+                   name, maxDifference, same ? "OK" : "FAILED");
+            if (!same)
+                failures++;
+        }
+        NeuralNetwork_SelectKernel(options->kernel);
+
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        for (int trial = 0; trial < trials; trial++)
+            NeuralNetwork_Forward(nn, &inputs[trial * inputCount], &reference[trial * outputCount], &workspace);
+        double denseTime = seconds_since(&start) / trials;
+        size_t denseBytes = nn->parameterCount * sizeof(NeuralParameter);
+
+        printf("%s network against the dense pass (%s, %s kernel, %.2f us and %zu KiB per network) "
+               "over %d observations:\n",
+               options->loadFile != NULL ? options->loadFile : "Random", NEURAL_PRECISION_NAME,
+               NeuralNetwork_KernelName(NeuralNetwork_ActiveKernel()), denseTime * 1e6, denseBytes / 1024, trials);
+
+        for (int f = 0; f < fractionCount; f++)
+        {
+            if (!NeuralPrune_SetFraction(&prune, fractions[f]) || !NeuralPrune_Pack(&prune, 0, nn))
+            {
+                failures++;
+                break;
+            }
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            for (int trial = 0; trial < trials; trial++)
+                NeuralPrune_Forward(&prune, 0, &inputs[trial * inputCount], &pruned[trial * outputCount], &workspace);
+            double time = seconds_since(&start) / trials;
+
+            // Drift from the dense pass, decisions of Cell_applyOutputs included
+            printf("%3.0f%% pruned: %d weights kept, %zu KiB, %.2f us per network (%.2fx), ",
+                   fractions[f] * 100, NeuralPrune_KeptWeights(&prune), prune.networkSize / 1024, time * 1e6,
+                   denseTime / time);
+            compare_outputs(reference, pruned, trials, outputCount);
+        }
+    }
+    else
+        failures++;
+
+    if (pruneReady)
+        NeuralPrune_Free(&prune);
+    if (workspaceReady)
+        NeuralWorkspace_Free(&workspace);
+    free(inputs);
+    free(reference);
+    free(pruned);
+    freeNeuralNetwork(nn);
+    return failures > 0 ? 1 : 0;
+}
+
+// Backend with its precision and kernel, returns the length written
+static int describe_backend(const Map *map, InferenceBackend backend, char *text, size_t size)
+{
+    const char *kernel = NeuralNetwork_KernelName(NeuralNetwork_ActiveKernel());
+    switch (backend)
+    {
+    case INFERENCE_REFERENCE:
+        return snprintf(text, size, "%s, scalar kernel per cell", NEURAL_PRECISION_NAME);
+    case INFERENCE_SIMD:
+        return snprintf(text, size, "%s, %s kernel per cell", NEURAL_PRECISION_NAME, kernel);
+    case INFERENCE_BATCHED:
+        return snprintf(text, size, "%s, %s kernel batched", NEURAL_PRECISION_NAME, kernel);
+    case INFERENCE_QUANTIZED:
+        return snprintf(text, size, "int8, %s kernel", NeuralQuant_KernelName(NeuralQuant_ActiveKernel()));
+    case INFERENCE_PRUNED:
+        return snprintf(text, size, "%s, %s kernel, %.0f%% of the weights pruned", NEURAL_PRECISION_NAME, kernel,
+                        map->prune.fraction * 100);
+    default:
+        return snprintf(text, size, "%s", Inference_BackendName(backend));
+    }
+}
+
+// Best score of the generation that just ended (last point of the score graph)
+static int last_generation_score(const GraphData *graph)
+{
+    if (graph->historyCount == 0)
+        return 0;
+    int last = (graph->circularIndex + GRAPH_HISTORY_MAX_SIZE - 1) % GRAPH_HISTORY_MAX_SIZE;
+    return graph->scoreHistory[last];
+}
+
+static int run(Map *map, const HeadlessOptions *options)
+{
+    int startGeneration = map->generation;
+    int lastReported = map->generation;
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    long long ticks = 0;
+
+    while (!g_interrupted)
+    {
+        if (options->generations > 0 && map->generation - startGeneration >= options->generations)
+            break;
+
+        int generation = map->generation;
+        Game_update(map);
+        ticks++;
+
+        if (map->generation != generation && options->reportInterval > 0 &&
+            map->generation - lastReported >= options->reportInterval)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            double elapsed = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+            printf("gen %d  frames %d  best %d  best ever %d  max lineage %d  %.2f gen/s  %.0f ticks/s\n",
+                   map->generation - 1, map->previousGenFrames, last_generation_score(&map->graphData),
+                   map->bestCellEver.score, map->maxGeneration,
+                   (map->generation - startGeneration) / elapsed, ticks / elapsed);
+            fflush(stdout);
+            lastReported = map->generation;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%s after %d generations, %lld ticks in %.1f s (%.2f gen/s, %.0f ticks/s)\n",
+           g_interrupted ? "Interrupted" : "Done", map->generation - startGeneration, ticks, elapsed,
+           elapsed > 0.0 ? (map->generation - startGeneration) / elapsed : 0.0,
+           elapsed > 0.0 ? ticks / elapsed : 0.0);
+
+    // The performance timers are shared, so per-call times only mean something single-threaded
+    // (and without a shadow, whose calls would be counted too)
+    const PerfStats *inference = Perf_GetStats(PERF_NEURAL_NETWORK);
+    if (!map->useMultithreading && map->shadowInterval == 0 && inference != NULL && inference->callCount > 0)
+    {
+        char backend[96];
+        describe_backend(map, map->inferenceBackend, backend, sizeof(backend));
+        printf("Inference: %.2f us per %s (%s, %s tanh, %llu calls)\n", inference->avgTime,
+               map->inferenceBackend == INFERENCE_BATCHED ? "block of networks" : "network", backend,
+               NeuralNetwork_ActivationName(NeuralNetwork_ActiveActivation()),
+               (unsigned long long)inference->callCount);
+    }
+
+    const InferenceDivergence *divergence = &map->divergence;
+    if (map->shadowInterval > 0 && divergence->samples > 0)
+    {
+        double samples = (double)divergence->samples;
+        printf("Shadow %s against %s: %llu samples, %.2f us against %.2f us per sample, ",
+               Inference_BackendName(map->shadowBackend), Inference_BackendName(map->inferenceBackend),
+               (unsigned long long)divergence->samples, divergence->shadowTime / samples * 1e6,
+               divergence->backendTime / samples * 1e6);
+        print_divergence(divergence);
+        if (divergence->mismatches > 0)
+            printf("Warning: %s gave other outputs when run again on %llu samples, it is not deterministic\n",
+                   Inference_BackendName(map->inferenceBackend), (unsigned long long)divergence->mismatches);
+    }
+
+    const NeuralPool *pool = &map->population.networks;
+    long deltaCount = 0, deltaCapacity = 0;
+    for (int i = 0; i < pool->networkCount; i++)
+    {
+        deltaCount += pool->networks[i]->deltaCount;
+        deltaCapacity += pool->networks[i]->deltaCapacity;
+    }
+    printf("Networks: %d in use sharing %d block(s), %d free block(s), %d slab(s) of %d (%.1f MB)\n",
+           pool->usedCount, pool->usedBlockCount, pool->freeBlockCount, pool->slabCount, NEURAL_POOL_SLAB_BLOCKS,
+           pool->slabCount * NEURAL_POOL_SLAB_BLOCKS * pool->blockSize / (1024.0 * 1024.0));
+    printf("Deltas: %ld pending (%.1f MB, %.1f MB reserved)\n", deltaCount,
+           deltaCount * sizeof(NeuralDelta) / (1024.0 * 1024.0), deltaCapacity * sizeof(NeuralDelta) / (1024.0 * 1024.0));
+
+    // Save the best network next to the checkpoints
+    char filename[512];
+    Checkpoint_createDir();
+    snprintf(filename, sizeof(filename), "%sbest.nn", Checkpoint_getDir());
+    if (!Game_save(map, filename))
+    {
+        fprintf(stderr, "Failed to save %s\n", filename);
+        return 1;
+    }
+    printf("Best network saved to %s\n", filename);
+
+    return 0;
+}
+
+// Simulation state of a run, with the threads, backend, shadow, decision
+// interval and network given in the options. NULL on error (already reported)
+static Map *create_map(const HeadlessOptions *options)
+{
+    // The map is large, keep it off the stack
+    Map *map = calloc(1, sizeof(Map));
+    if (map == NULL)
+    {
+        fprintf(stderr, "Failed to allocate memory for Map !\n");
+        return NULL;
+    }
+
+    // Training screen size, like the windowed build starts with
+    if (!Game_init(map, TRAINING_SCREEN_WIDTH, TRAINING_SCREEN_HEIGHT))
+    {
+        free(map);
+        return NULL;
+    }
+
+#ifdef HAVE_OPENMP
+    if (options->threads > 0)
+        omp_set_num_threads(options->threads);
+    map->useMultithreading = options->threads != 1;
+#else
+    map->useMultithreading = false;
+#endif
+
+    Inference_SetBackend(map, options->backend);
+    if (options->shadowInterval > 0)
+        Inference_SetShadow(map, options->shadow, options->shadowInterval);
+    Inference_SetDecisionInterval(map, options->decisionInterval);
+
+    if (!Inference_SetPruning(map, options->pruneFraction) ||
+        (options->loadFile != NULL && !load_network(map, options->loadFile)))
+    {
+        Game_destroy(map);
+        free(map);
+        return NULL;
+    }
+    return map;
+}
+
+// Train the same world (same seed) with each decision interval in turn, for
+// the same number of generations, and compare the speed with the scores
+static int bench_decisions(const HeadlessOptions *options, unsigned int seed)
+{
+    int generations = options->generations > 0 ? options->generations : 20;
+    printf("Decision interval benchmark: seed %u, %d generations each\n", seed, generations);
+    printf(" K   gen/s   ticks/s   mean best   best ever   max lineage\n");
+
+    for (int interval = 1; interval <= BENCH_DECISION_MAX && !g_interrupted; interval++)
+    {
+        HeadlessOptions runOptions = *options;
+        runOptions.decisionInterval = interval;
+        Random_Seed(seed);
+        Map *map = create_map(&runOptions);
+        if (map == NULL)
+            return 1;
+
+        int startGeneration = map->generation;
+        long long ticks = 0;
+        long long scoreSum = 0;
+        struct timespec start, now;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        while (!g_interrupted && map->generation - startGeneration < generations)
+        {
+            int generation = map->generation;
+            Game_update(map);
+            ticks++;
+            if (map->generation != generation)
+                scoreSum += last_generation_score(&map->graphData);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        double elapsed = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+
+        int done = map->generation - startGeneration;
+        printf("%2d  %6.2f  %8.0f  %10.1f  %10d  %12d\n", interval,
+               elapsed > 0.0 ? done / elapsed : 0.0, elapsed > 0.0 ? ticks / elapsed : 0.0,
+               done > 0 ? (double)scoreSum / done : 0.0, map->bestCellEver.score, map->maxGeneration);
+        fflush(stdout);
+
+        Game_destroy(map);
+        free(map);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    HeadlessOptions options;
+    int parsed = parse_options(argc, argv, &options);
+    if (parsed != 0)
+        return parsed < 0 ? 0 : 1;
+
+    // Verify neural network topology consistency
+    int topology[] = NEURAL_NETWORK_TOPOLOGY;
+    int expected_inputs = CELL_PERCEPTION_RAYS * RAY_OBJECT_COUNT + 2; // rays * types + health + can_reproduce
+    if (topology[0] != expected_inputs) {
+        fprintf(stderr, "ERROR: Neural network topology mismatch!\n");
+        fprintf(stderr, "Expected: %d * %d + 2 = %d inputs, but got: %d inputs\n",
+                CELL_PERCEPTION_RAYS, RAY_OBJECT_COUNT, expected_inputs, topology[0]);
+        return 1;
+    }
+
+    unsigned int seed = options.hasSeed ? options.seed : (unsigned int)time(NULL);
+    Random_Seed(seed);
+
+    if (options.checkKernels)
+        return check_kernels();
+    NeuralNetwork_SelectKernel(options.kernel);
+    NeuralQuant_SelectKernel(quant_kernel(options.kernel));
+    if (options.checkActivation)
+        return check_activation(&options);
+    NeuralNetwork_SetActivation(options.activation);
+    if (options.checkQuant)
+        return check_quant(&options);
+    if (options.checkPruned)
+        return check_pruned(&options);
+
+    Checkpoint_setDir(options.outputDir);
+    Perf_Init(false, NULL);
+
+    signal(SIGINT, on_interrupt);
+    signal(SIGTERM, on_interrupt);
+
+    if (options.benchDecisions)
+    {
+        int status = bench_decisions(&options, seed);
+        Perf_Cleanup();
+        return status;
+    }
+
+    Map *map = create_map(&options);
+    if (map == NULL)
+        return 1;
+
+#ifdef HAVE_OPENMP
+    int threadCount = map->useMultithreading ? omp_get_max_threads() : 1;
+#else
+    int threadCount = 1;
+#endif
+
+    char inference[256];
+    int length = describe_backend(map, options.backend, inference, sizeof(inference));
+    if (options.shadowInterval > 0)
+    {
+        char shadow[96];
+        describe_backend(map, options.shadow, shadow, sizeof(shadow));
+        length += snprintf(inference + length, sizeof(inference) - length, ", shadow %s on 1 cell in %d",
+                           shadow, options.shadowInterval);
+    }
+    if (options.decisionInterval > 1)
+        snprintf(inference + length, sizeof(inference) - length, ", decisions every %d ticks",
+                 options.decisionInterval);
+
+    if (options.generations > 0)
+        printf("Headless training: seed %u, %d thread(s), %s, %s tanh, %d generations, output %s\n",
+               seed, threadCount, inference,
+               NeuralNetwork_ActivationName(NeuralNetwork_ActiveActivation()), options.generations, Checkpoint_getDir());
+    else
+        printf("Headless training: seed %u, %d thread(s), %s, %s tanh, until interrupted, output %s\n",
+               seed, threadCount, inference,
+               NeuralNetwork_ActivationName(NeuralNetwork_ActiveActivation()), Checkpoint_getDir());
+
+    int status = run(map, &options);
+
+    Game_destroy(map);
+    free(map);
+    Perf_Cleanup();
+
+    return status;
+}
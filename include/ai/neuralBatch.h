@@ -0,0 +1,154 @@
+/**
+ * @file neuralBatch.h
+ * @brief Inference of a whole block of cells at once, one SIMD lane per cell
+ *
+ * Every cell uses NEURAL_NETWORK_TOPOLOGY, so the networks are stored by
+ * blocks of NEURAL_BATCH_LANES, interleaved by neuron:
+ * weights[layer][j][k][lane]. One vector load brings the same weight of every
+ * cell of the block, the block's forward pass streams its weights in order,
+ * and the lanes stay full even for the 3-neuron output layer.
+ *
+ * Lanes are not tied to population slots: packed networks occupy lanes
+ * 0..laneCount-1, and releasing a lane moves the last one into it. Dead cells
+ * therefore never leave holes in the blocks, only the last block is partial.
+ *
+ * The cells' NeuralNetwork remains the genome (copied, mutated, saved); the
+ * batch only keeps a packed copy of it, refreshed through NeuralBatch_Pack.
+ */
+
+#ifndef NEURAL_BATCH_H
+#define NEURAL_BATCH_H
+
+#include <stdbool.h>
+#include "neuralScalar.h"
+
+// Forward declarations to avoid circular inclusion (neuralNetwork.h includes game.h)
+typedef struct NeuralNetwork NeuralNetwork;
+typedef struct NeuralWorkspace NeuralWorkspace;
+
+// Cells per block: one 64-byte vector of scalars (8 doubles or 16 floats),
+// NEURAL_NETWORK_ALIGNMENT comes from neuralNetwork.h
+#define NEURAL_BATCH_LANES (NEURAL_NETWORK_ALIGNMENT / (int)sizeof(NeuralScalar))
+
+typedef struct {
+    int *topology;              // Shape of every packed network
+    int topologySize;
+    int maxWidth;               // Widest layer, inputs included
+    int blockParameterCount;    // Parameters per block
+    bool fixedTopology;         // Shape of NEURAL_NETWORK_TOPOLOGY: blocks run the specialized pass
+
+    int slotCapacity;           // Slots and lanes
+    int blockCapacity;
+    NeuralParameter **blocks;   // Packed parameters, allocated when a lane of the block is first used
+
+    int *slotLane;              // Per slot: its lane, -1 if not packed
+    int *laneSlot;              // Per lane: the slot it holds
+    int laneCount;              // Lanes in use, always the first ones
+} NeuralBatch;
+
+/**
+ * Create an empty batch for networks of the given shape
+ *
+ * @param batch Batch to initialize
+ * @param topology Neurons per layer, inputs first
+ * @param topologySize Number of layers
+ * @param slotCapacity Number of slots (cells) the batch can hold
+ * @return true on success
+ */
+bool NeuralBatch_Init(NeuralBatch *batch, const int *topology, int topologySize, int slotCapacity);
+
+/**
+ * Free every block
+ *
+ * @param batch Batch to free
+ */
+void NeuralBatch_Free(NeuralBatch *batch);
+
+/**
+ * Copy a network into its slot's lane, taking the next free lane if the slot has none
+ * A network of another shape is not packed (its lane is released), the slot
+ * then has to be run with NeuralNetwork_Forward. The deltas of a copy-on-write
+ * genome are applied to the lane, the genome itself stays as it is.
+ *
+ * @param batch Batch
+ * @param slot Slot of the cell
+ * @param nn Network of the cell
+ * @return true if the slot is packed
+ */
+bool NeuralBatch_Pack(NeuralBatch *batch, int slot, const NeuralNetwork *nn);
+
+/**
+ * Release the lane of a slot, the last lane in use moves into it
+ *
+ * @param batch Batch
+ * @param slot Slot of the cell, nothing happens if it is not packed
+ */
+void NeuralBatch_Release(NeuralBatch *batch, int slot);
+
+/**
+ * Check whether a slot holds a packed network
+ *
+ * @param batch Batch
+ * @param slot Slot of the cell
+ * @return true if NeuralBatch_Forward can evaluate it
+ */
+bool NeuralBatch_IsPacked(const NeuralBatch *batch, int slot);
+
+/**
+ * Number of blocks holding at least one lane in use
+ *
+ * @param batch Batch
+ * @return Blocks to run
+ */
+int NeuralBatch_BlockCount(const NeuralBatch *batch);
+
+/**
+ * Workspace capacity needed by NeuralBatch_Forward
+ *
+ * @param batch Batch
+ * @return Scalars per workspace buffer
+ */
+int NeuralBatch_WorkspaceSize(const NeuralBatch *batch);
+
+/**
+ * Run the forward pass of the packed lanes of one block
+ * Lane i of the block holds the network of slot laneSlot[block * NEURAL_BATCH_LANES + i].
+ * Reentrant for different workspaces, the batch is only read.
+ *
+ * @param batch Batch
+ * @param block Block index
+ * @param inputs Per lane, the network inputs (NULL for lanes to skip)
+ * @param outputs Per lane, where to write the network outputs (NULL for lanes to skip)
+ * @param workspace Scratch of the calling thread
+ */
+void NeuralBatch_Forward(const NeuralBatch *batch, int block, const NeuralScalar *const *inputs,
+                         NeuralScalar *const *outputs, NeuralWorkspace *workspace);
+
+/**
+ * One dense layer of a block, followed by tanh
+ * out[j][lane] = tanh(bias[j][lane] + sum_k in[k][lane] * weights[j][k][lane]),
+ * computed by the kernel selected with NeuralNetwork_SelectKernel.
+ *
+ * @param neuronCount Inputs of the layer
+ * @param nextLayerNeuronCount Outputs of the layer
+ * @param weights Interleaved weights [nextLayerNeuronCount][neuronCount][NEURAL_BATCH_LANES]
+ * @param biases Interleaved biases [nextLayerNeuronCount][NEURAL_BATCH_LANES]
+ * @param inputs [neuronCount][NEURAL_BATCH_LANES]
+ * @param outputs [nextLayerNeuronCount][NEURAL_BATCH_LANES]
+ */
+void NeuralNetwork_BatchLayer(int neuronCount, int nextLayerNeuronCount, const NeuralParameter *weights,
+                              const NeuralParameter *biases, const NeuralScalar *inputs, NeuralScalar *outputs);
+
+/**
+ * Forward pass of one block for NEURAL_NETWORK_TOPOLOGY, with constant layer sizes
+ *
+ * @param parameters Packed parameters of the block
+ * @param activeInputs Inputs non-zero in at least one lane, increasing (NULL: all of them)
+ * @param activeCount Number of active inputs
+ * @param workspace Scratch holding the interleaved inputs in buffers[0]
+ * @return The buffer holding the interleaved outputs
+ */
+const NeuralScalar *NeuralNetwork_BatchForwardFixed(const NeuralParameter *parameters, const uint8_t *activeInputs,
+                                                    int activeCount, NeuralWorkspace *workspace);
+
+#endif // NEURAL_BATCH_H
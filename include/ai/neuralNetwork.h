@@ -5,31 +5,128 @@
 #include <SDL2/SDL2_framerate.h>
 #include <SDL2/SDL2_gfxPrimitives.h>
 
+#include "neuralScalar.h"
+
 typedef struct NeuralLayer NeuralLayer;
 typedef struct NeuralNetwork NeuralNetwork;
+typedef struct NeuralWorkspace NeuralWorkspace;
+typedef struct NeuralPool NeuralPool;
+typedef struct NeuralBlock NeuralBlock;
 
 #include "../entities/cell.h"
 #include "../core/utils.h"
+#include "../core/random.h"
+
+// Parameter arrays start on this boundary (bytes), padding is kept at zero
+#define NEURAL_NETWORK_ALIGNMENT 64
 
 struct NeuralLayer {
     int neuronCount;
     int nextLayerNeuronCount;
-    double *weights;
-    double *biases;
-    double *outputs;
+    NeuralParameter *weights;   // [neuronCount][nextLayerNeuronCount], in the parameter block
+    NeuralParameter *biases;    // [nextLayerNeuronCount], in the parameter block
 };
 
+// Mutation of a copy-on-write genome: parameters[index] += value
+typedef struct {
+    int index;                  // In the parameter block, padding included
+    NeuralScalar value;         // Added as is, like a mutation applied in place
+} NeuralDelta;
+
+// One aligned allocation holds the struct, the layers, the topology and every
+// weight and bias, so cloning a genome of the same shape is a single memcpy.
+// Inference never writes to it: activations go to a caller-owned workspace.
+//
+// A pooled network only holds the struct and the layers: its parameters live
+// in a block of the pool, shared copy-on-write with its relatives, plus the
+// deltas of its own mutations (see neuralPool.h). While it has deltas, the
+// parameters are those of the block without them: NeuralNetwork_Materialize
+// gives it dense parameters before they are read.
 struct NeuralNetwork {
     int *topology;
     int topologySize;
-    NeuralLayer **layers;
+    NeuralLayer *layers;        // topologySize - 1 layers
+    NeuralParameter *parameters;    // Weights then biases of each layer, aligned and padded
+    int parameterCount;         // Including padding
+    bool fixedTopology;         // Shape of NEURAL_NETWORK_TOPOLOGY: runs the specialized forward pass
+    NeuralPool *pool;           // Pool the network belongs to, NULL for a block of its own
+    NeuralBlock *block;         // Pooled networks: block holding the parameters
+    NeuralDelta *deltas;        // Pooled networks: mutations on top of the block, in order
+    int deltaCount;
+    int deltaCapacity;
+};
+
+// Dense layer kernels, from slowest to fastest (see neuralNetwork_kernels.c)
+typedef enum {
+    NEURAL_KERNEL_SCALAR,
+    NEURAL_KERNEL_SSE2,
+    NEURAL_KERNEL_AVX2,         // AVX2 + FMA
+    NEURAL_KERNEL_AVX512,
+    NEURAL_KERNEL_COUNT
+} NeuralKernel;
+
+// Largest activation difference allowed between a kernel and the scalar reference
+// (fused multiply-adds round differently, the summation order is the same)
+#ifdef NN_SCALAR_FLOAT
+#define NEURAL_KERNEL_TOLERANCE 1e-4
+#else
+#define NEURAL_KERNEL_TOLERANCE 1e-9
+#endif
+
+// Activation of the hidden and output neurons
+typedef enum {
+    NEURAL_ACTIVATION_EXACT,    // libm tanh
+    NEURAL_ACTIVATION_FAST,     // Vectorized rational approximation of tanh
+    NEURAL_ACTIVATION_COUNT
+} NeuralActivation;
+
+// Largest difference between the fast tanh and tanh, over the whole real line
+// (float or double alike: the approximation error dominates the rounding)
+#define NEURAL_FAST_TANH_MAX_ERROR 4e-7
+
+// Scratch for one forward pass at a time, typically one per thread
+struct NeuralWorkspace {
+    NeuralScalar *buffers[2];   // Layer outputs, alternating between layers
+    int capacity;               // Scalars per buffer
 };
 
 NeuralNetwork *createNeuralNetwork(int *topology, int topologySize);
+int NeuralNetwork_ParameterCount(const int *topology, int topologySize);
+size_t NeuralNetwork_HeaderSize(int topologySize);
+NeuralNetwork *NeuralNetwork_InitHeader(void *memory, int *topology, int topologySize);
+void NeuralNetwork_BindParameters(NeuralNetwork *nn, NeuralParameter *parameters);
 NeuralNetwork *NeuralNetwork_Copy(NeuralNetwork *parent);
-void processInputs(NeuralNetwork *nn, double *inputs, double *outputs);
-void mutate_NeuralNetwork_Weights(NeuralNetwork *nn, double mutationRate, float mutationProbability);
-void mutate_NeuralNetwork_Topology(NeuralNetwork *nn, int maxNeurons, int maxLayers, float mutationProbability);
+bool NeuralNetwork_Materialize(NeuralNetwork *nn);
+bool NeuralNetwork_ReserveDeltas(NeuralNetwork *nn, int capacity);
+void NeuralNetwork_ApplyDeltas(const NeuralNetwork *nn, NeuralParameter *parameters);
+bool NeuralNetwork_CopyInto(NeuralNetwork *dst, NeuralNetwork *src);
+bool NeuralNetwork_Assign(NeuralNetwork **dst, NeuralNetwork *src);
+bool NeuralWorkspace_Init(NeuralWorkspace *workspace, int capacity);
+bool NeuralWorkspace_Reserve(NeuralWorkspace *workspace, int capacity);
+void NeuralWorkspace_Free(NeuralWorkspace *workspace);
+int NeuralNetwork_MaxWidth(const NeuralNetwork *nn);
+int NeuralNetwork_ActivationCount(const NeuralNetwork *nn);
+void NeuralNetwork_Forward(const NeuralNetwork *nn, const NeuralScalar *inputs, NeuralScalar *outputs, NeuralWorkspace *workspace);
+void NeuralNetwork_ForwardReference(const NeuralNetwork *nn, const NeuralScalar *inputs, NeuralScalar *outputs, NeuralWorkspace *workspace);
+void NeuralNetwork_ForwardSparse(const NeuralNetwork *nn, const NeuralScalar *inputs, const uint8_t *activeInputs, int activeCount, NeuralScalar *outputs, NeuralWorkspace *workspace);
+int NeuralNetwork_ActiveInputs(const NeuralScalar *inputs, int count, uint8_t *activeInputs);
+void NeuralNetwork_ForwardCapture(const NeuralNetwork *nn, const NeuralScalar *inputs, NeuralScalar *activations);
+NeuralKernel NeuralNetwork_SelectKernel(NeuralKernel maxKernel);
+NeuralKernel NeuralNetwork_ActiveKernel(void);
+const char *NeuralNetwork_KernelName(NeuralKernel kernel);
+void NeuralNetwork_DenseLayer(const NeuralLayer *layer, const NeuralScalar *inputs, NeuralScalar *outputs);
+void NeuralNetwork_DenseLayerReference(const NeuralLayer *layer, const NeuralScalar *inputs, NeuralScalar *outputs);
+bool NeuralNetwork_IsFixedTopology(const int *topology, int topologySize);
+void NeuralNetwork_ForwardFixed(const NeuralNetwork *nn, const NeuralScalar *inputs, NeuralScalar *outputs, NeuralWorkspace *workspace);
+void NeuralNetwork_ForwardFixedSparse(const NeuralNetwork *nn, const NeuralScalar *inputs, const uint8_t *activeInputs, int activeCount, NeuralScalar *outputs, NeuralWorkspace *workspace);
+void NeuralNetwork_ForwardFixedReference(const NeuralNetwork *nn, const NeuralScalar *inputs, NeuralScalar *outputs, NeuralWorkspace *workspace);
+void NeuralNetwork_SetActivation(NeuralActivation activation);
+NeuralActivation NeuralNetwork_ActiveActivation(void);
+const char *NeuralNetwork_ActivationName(NeuralActivation activation);
+NeuralScalar NeuralNetwork_FastTanh(NeuralScalar x);
+void NeuralNetwork_Activate(NeuralScalar *values, int count);
+void mutate_NeuralNetwork_Weights(NeuralNetwork *nn, double mutationRate, float mutationProbability, Rng *rng);
+NeuralNetwork *mutate_NeuralNetwork_Topology(NeuralNetwork *nn, int maxNeurons, int maxLayers, float mutationProbability);
 void setRandomWeights(NeuralNetwork *nn, double minValue, double maxValue);
 void freeNeuralNetwork(NeuralNetwork *nn);
 
@@ -0,0 +1,129 @@
+/**
+ * @file neuralPool.h
+ * @brief Slab allocator and copy-on-write storage for networks of one shape
+ *
+ * Every cell network has the shape of NEURAL_NETWORK_TOPOLOGY, so the
+ * population takes its networks from a pool: parameter blocks are carved from
+ * large slabs, laid out once, and a freed block goes back to the pool's free
+ * list instead of the heap. Births, deaths and generation resets then reuse the
+ * same memory for the whole run.
+ *
+ * A pooled network is a small header (struct and layers) reading a block.
+ * Blocks are reference counted: a clone shares the block of its source and
+ * copies its deltas, the mutations made since. A network sharing its block
+ * records its own mutations as deltas too, so a child costs what its mutations
+ * cost, not a copy of the parameters. The deltas are folded into a block of
+ * the network's own (in place when nobody else reads the block):
+ * - when something reads the dense parameters (NeuralNetwork_Materialize),
+ * - when they weigh more than NEURAL_POOL_MAX_DELTA_SHARE of a block,
+ * - before the parameters are written in place.
+ * The batched inference packs the block and the deltas without materializing.
+ *
+ * A pooled network is freed with freeNeuralNetwork like any other, and
+ * NeuralNetwork_Copy clones it from the same pool. Not thread-safe: networks
+ * are only created, mutated and freed by the serial phases (births, resets).
+ */
+
+#ifndef NEURAL_POOL_H
+#define NEURAL_POOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Forward declaration to avoid circular inclusion (neuralNetwork.h includes game.h)
+typedef struct NeuralNetwork NeuralNetwork;
+
+#define NEURAL_POOL_SLAB_BLOCKS 16      // Parameter blocks carved from each slab
+#define NEURAL_POOL_MAX_DELTA_SHARE 0.5 // Deltas heavier than this share of a block are folded into one
+
+// Parameters of one or more networks, followed by the parameters themselves
+// (at NEURAL_NETWORK_ALIGNMENT from the start of the block)
+typedef struct NeuralBlock {
+    int refCount;                   // Networks reading the block
+} NeuralBlock;
+
+typedef struct NeuralPool {
+    int *topology;                  // Shape of every network
+    int topologySize;
+    int parameterCount;             // Parameters per block, padding included
+    size_t blockSize;               // Bytes per block, a multiple of NEURAL_NETWORK_ALIGNMENT
+
+    char **slabs;
+    int slabCount;
+    NeuralBlock **freeBlocks;       // Stack of blocks ready to be handed out
+    int freeBlockCount;
+    int usedBlockCount;             // Blocks read by at least one network
+
+    NeuralNetwork **networks;       // Every header made, for NeuralPool_Free
+    int networkCount;
+    NeuralNetwork **freeNetworks;   // Stack of headers ready to be handed out
+    int freeCount;
+    int usedCount;                  // Networks currently handed out
+} NeuralPool;
+
+/**
+ * Create an empty pool, slabs are allocated on demand
+ *
+ * @param pool Pool to initialize
+ * @param topology Neurons per layer, inputs first
+ * @param topologySize Number of layers
+ * @return true on success
+ */
+bool NeuralPool_Init(NeuralPool *pool, const int *topology, int topologySize);
+
+/**
+ * Free every slab and header, networks still handed out become invalid
+ *
+ * @param pool Pool to free
+ */
+void NeuralPool_Free(NeuralPool *pool);
+
+/**
+ * Take a network with a block of its own from the pool
+ * Its parameters are left as the previous owner left them (zero for a new
+ * block), the padding is always zero.
+ *
+ * @param pool Pool
+ * @return The network, NULL if a new slab could not be allocated
+ */
+NeuralNetwork *NeuralPool_Acquire(NeuralPool *pool);
+
+/**
+ * Take a network from the pool sharing the parameters of another one
+ *
+ * @param pool Pool
+ * @param source Network of the same pool
+ * @return The copy, NULL on failure
+ */
+NeuralNetwork *NeuralPool_Clone(NeuralPool *pool, const NeuralNetwork *source);
+
+/**
+ * Make a network of the pool share the parameters of another one
+ * Its previous block is released, no parameter is copied.
+ *
+ * @param nn Network of the pool
+ * @param source Network of the same pool
+ * @return false if the deltas could not be copied (nn is unchanged)
+ */
+bool NeuralPool_Share(NeuralNetwork *nn, const NeuralNetwork *source);
+
+/**
+ * Give a network a block of its own and no deltas, ready to be written in place
+ * Without a copy when nobody else reads its block.
+ *
+ * @param nn Network of a pool
+ * @param keepValues Fold the deltas into the new block; otherwise the
+ *                   parameters are left undefined, to be overwritten
+ * @return false if a new slab could not be allocated (nn is unchanged)
+ */
+bool NeuralPool_Detach(NeuralNetwork *nn, bool keepValues);
+
+/**
+ * Give a network back to its pool (called by freeNeuralNetwork)
+ *
+ * @param pool Pool the network was taken from
+ * @param nn Network
+ */
+void NeuralPool_Release(NeuralPool *pool, NeuralNetwork *nn);
+
+#endif // NEURAL_POOL_H
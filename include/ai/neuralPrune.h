@@ -0,0 +1,186 @@
+/**
+ * @file neuralPrune.h
+ * @brief Pruned, block-sparse copies of the cell networks, for evaluation runs
+ *
+ * Evolved networks carry many weights too small to matter: the ones drawn
+ * near zero by setRandomWeights and never pushed away by the mutations. A
+ * pruned copy drops, in every layer, the given fraction of its weights with
+ * the smallest magnitude, and runs the rest from a sparse layout.
+ *
+ * Weights are pruned by blocks of NEURAL_PRUNE_BLOCK outputs of one input
+ * row, ranked by the L2 norm of the block: a single weight would need an
+ * index of its own and a scalar multiply-add, a kept block is one vector of
+ * the dense kernels. The blocks kept are stored like a CSR matrix whose rows
+ * are the output blocks: blockStart[c] .. blockStart[c + 1] are the blocks of
+ * output block c, by increasing input, blockInputs[b] the input of block b
+ * and weights[b][NEURAL_PRUNE_BLOCK] its weights. A block of outputs is then
+ * summed in registers from its bias to its last block, and stored once.
+ * Outputs are padded to whole blocks, the padding weights and biases are zero.
+ *
+ * Each layer keeps the same number of blocks in every network, so the copies
+ * have a fixed size like NeuralQuant's. Every output adds its products in the
+ * order of the dense kernels (bias first, then k increasing), so with nothing
+ * pruned the outputs are the ones of NeuralNetwork_Forward with the same
+ * kernel, bit for bit.
+ *
+ * Like NeuralQuant, the genomes stay the cells' NeuralNetwork; the copy of a
+ * slot is refreshed through NeuralPrune_Pack when its network changes.
+ */
+
+#ifndef NEURAL_PRUNE_H
+#define NEURAL_PRUNE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "neuralScalar.h"
+
+// Forward declarations to avoid circular inclusion (neuralNetwork.h includes game.h)
+typedef struct NeuralNetwork NeuralNetwork;
+typedef struct NeuralWorkspace NeuralWorkspace;
+
+// Outputs per block: one 64-byte vector of scalars (8 doubles or 16 floats),
+// NEURAL_NETWORK_ALIGNMENT comes from neuralNetwork.h
+#define NEURAL_PRUNE_BLOCK (NEURAL_NETWORK_ALIGNMENT / (int)sizeof(NeuralScalar))
+
+typedef struct {
+    int inputCount;             // Neurons of the layer
+    int outputCount;            // Neurons of the next layer
+    int columnCount;            // Output blocks, outputs padded to NEURAL_PRUNE_BLOCK
+    int blockCount;             // Blocks kept out of columnCount * inputCount
+    size_t startOffset;         // Bytes from the start of a network: int32 blockStart[columnCount + 1]
+    size_t inputOffset;         // Bytes from the start of a network: uint16 blockInputs[blockCount]
+    size_t biasOffset;          // Bytes from the start of a network: padded biases
+    size_t weightOffset;        // Bytes from the start of a network: weights[blockCount][NEURAL_PRUNE_BLOCK]
+} NeuralPruneLayer;
+
+// Norm of a block of weights, while ranking them
+typedef struct {
+    double norm;
+    int block;                  // Output block * inputCount + k
+} NeuralPruneRank;
+
+typedef struct {
+    int *topology;              // Shape of every pruned network
+    int topologySize;
+    NeuralPruneLayer *layers;   // topologySize - 1 layers
+    double fraction;            // Share of the blocks of each layer pruned
+    size_t networkSize;         // Bytes per network
+    int maxWidth;               // Widest padded layer, inputs included
+
+    int slotCapacity;
+    char **networks;            // Per slot, allocated when the slot is first packed
+    bool *packed;               // Per slot: its network is up to date
+    NeuralParameter *scratch;   // Genome with its deltas applied, while packing
+    int scratchCount;
+    NeuralPruneRank *ranks;     // Blocks of the layer being packed
+    int rankCapacity;
+} NeuralPrune;
+
+/**
+ * Create an empty set of pruned networks of the given shape
+ *
+ * @param prune Set to initialize
+ * @param topology Neurons per layer, inputs first
+ * @param topologySize Number of layers
+ * @param slotCapacity Number of slots (cells)
+ * @param fraction Share of the weight blocks of each layer to prune, in [0, 1)
+ * @return true on success, false on a share outside [0, 1)
+ */
+bool NeuralPrune_Init(NeuralPrune *prune, const int *topology, int topologySize, int slotCapacity, double fraction);
+
+/**
+ * Free every network
+ *
+ * @param prune Set to free
+ */
+void NeuralPrune_Free(NeuralPrune *prune);
+
+/**
+ * Change the share of the blocks pruned
+ * The size of the networks changes with it: every slot is released and has
+ * to be packed again.
+ *
+ * @param prune Set
+ * @param fraction Share of the weight blocks of each layer to prune, in [0, 1)
+ * @return false on a share outside [0, 1), the set is then left as it was
+ */
+bool NeuralPrune_SetFraction(NeuralPrune *prune, double fraction);
+
+/**
+ * Prune a network into its slot
+ * A network of another shape is not packed, the slot then has to be run with
+ * NeuralNetwork_Forward. The deltas of a copy-on-write genome are applied,
+ * the genome itself stays as it is.
+ *
+ * @param prune Set
+ * @param slot Slot of the cell
+ * @param nn Network of the cell
+ * @return true if the slot is packed
+ */
+bool NeuralPrune_Pack(NeuralPrune *prune, int slot, const NeuralNetwork *nn);
+
+/**
+ * Mark a slot as empty, its memory is kept for the next network
+ *
+ * @param prune Set
+ * @param slot Slot of the cell
+ */
+void NeuralPrune_Release(NeuralPrune *prune, int slot);
+
+/**
+ * Check whether a slot holds a pruned network
+ *
+ * @param prune Set
+ * @param slot Slot of the cell
+ * @return true if NeuralPrune_Forward can evaluate it
+ */
+bool NeuralPrune_IsPacked(const NeuralPrune *prune, int slot);
+
+/**
+ * Weights kept per network, padding of the output blocks included
+ *
+ * @param prune Set
+ * @return Number of weights stored
+ */
+int NeuralPrune_KeptWeights(const NeuralPrune *prune);
+
+/**
+ * Workspace capacity needed by NeuralPrune_Forward
+ *
+ * @param prune Set
+ * @return Scalars per workspace buffer
+ */
+int NeuralPrune_WorkspaceSize(const NeuralPrune *prune);
+
+/**
+ * Run the forward pass of a slot's pruned network
+ * Reentrant for different workspaces, the set is only read.
+ *
+ * @param prune Set
+ * @param slot Slot of the cell
+ * @param inputs Network inputs
+ * @param outputs Network outputs (zero if the slot is not packed)
+ * @param workspace Scratch of the calling thread
+ */
+void NeuralPrune_Forward(const NeuralPrune *prune, int slot, const NeuralScalar *inputs, NeuralScalar *outputs,
+                         NeuralWorkspace *workspace);
+
+/**
+ * One pruned layer, followed by tanh, computed by the kernel selected with
+ * NeuralNetwork_SelectKernel
+ * out[j] = tanh(bias[j] + sum over the kept blocks b of the block of j of in[blockInputs[b]] * w)
+ *
+ * @param nextLayerNeuronCount Outputs of the layer
+ * @param blockStart Blocks of output block c: blockStart[c] .. blockStart[c + 1]
+ * @param blockInputs Input of each block
+ * @param weights [blockCount][NEURAL_PRUNE_BLOCK]
+ * @param biases Biases, padded to NEURAL_PRUNE_BLOCK
+ * @param inputs Outputs of the previous layer
+ * @param outputs [nextLayerNeuronCount padded to NEURAL_PRUNE_BLOCK], the padding is left at 0
+ */
+void NeuralNetwork_PrunedLayer(int nextLayerNeuronCount, const int32_t *blockStart,
+                               const uint16_t *blockInputs, const NeuralParameter *weights,
+                               const NeuralParameter *biases, const NeuralScalar *inputs, NeuralScalar *outputs);
+
+#endif // NEURAL_PRUNE_H
@@ -0,0 +1,168 @@
+/**
+ * @file neuralQuant.h
+ * @brief Int8 copies of the cell networks, for evaluation runs
+ *
+ * Replays, benchmarks and checkpoint evaluations only need the decisions of
+ * the networks, so they can run an 8-bit copy of each one: weights quantized
+ * per layer (symmetric, scale = max |w| / 127), activations as unsigned 7-bit
+ * codes, products accumulated in int32. The inputs are in [0, 1] and map to
+ * codes 0..127; tanh outputs map to 64 + 63 * tanh, read from a table indexed
+ * by the pre-activation. Biases are pre-scaled to the accumulator and absorb
+ * the zero point of the codes. The output layer is dequantized and goes
+ * through the regular activation, so the decisions keep continuous values.
+ *
+ * Weights are stored by groups of 4 inputs, [k / 4][j][k % 4], the layout of
+ * the AVX-512 VNNI dot product (vpdpbusd) and of AVX2 maddubs + madd: one
+ * broadcast of 4 input codes updates a whole vector of outputs. 7-bit codes
+ * keep the int16 pair sums of maddubs from saturating, so every kernel gives
+ * the same integers as the scalar one.
+ *
+ * Like NeuralBatch, the genomes stay the cells' NeuralNetwork; the copy of a
+ * slot is refreshed through NeuralQuant_Pack when its network changes.
+ */
+
+#ifndef NEURAL_QUANT_H
+#define NEURAL_QUANT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "neuralScalar.h"
+
+// Forward declarations to avoid circular inclusion (neuralNetwork.h includes game.h)
+typedef struct NeuralNetwork NeuralNetwork;
+typedef struct NeuralWorkspace NeuralWorkspace;
+
+#define NEURAL_QUANT_GROUP 4                // Inputs per int32 lane of the dot products
+#define NEURAL_QUANT_OUTPUT_BLOCK 16        // Outputs are padded to one 512-bit vector of int32
+#define NEURAL_QUANT_WEIGHT_MAX 127         // Weights in [-127, 127]
+#define NEURAL_QUANT_INPUT_STEPS 127        // Inputs in [0, 1] as codes 0..127
+#define NEURAL_QUANT_ACTIVATION_ZERO 64     // tanh in [-1, 1] as codes 1..127
+#define NEURAL_QUANT_ACTIVATION_STEPS 63
+#define NEURAL_QUANT_TANH_RANGE 4           // Table of tanh codes over [-4, 4] (saturated beyond)
+#define NEURAL_QUANT_TANH_RESOLUTION 256    // Table entries per unit of pre-activation
+
+// Int8 layer kernels, runtime dispatch like NeuralKernel
+typedef enum {
+    NEURAL_QUANT_KERNEL_SCALAR,
+    NEURAL_QUANT_KERNEL_AVX2,           // maddubs + madd
+    NEURAL_QUANT_KERNEL_AVX512_VNNI,    // vpdpbusd
+    NEURAL_QUANT_KERNEL_COUNT
+} NeuralQuantKernel;
+
+typedef struct {
+    int inputCount;             // Neurons of the layer
+    int outputCount;            // Neurons of the next layer
+    int groupCount;             // Inputs padded to groups of NEURAL_QUANT_GROUP
+    int paddedOutputs;          // Outputs padded to NEURAL_QUANT_OUTPUT_BLOCK
+    size_t biasOffset;          // Bytes from the start of a network: int32 biases
+    size_t weightOffset;        // Bytes from the start of a network: int8 weights
+} NeuralQuantLayer;
+
+typedef struct {
+    int *topology;              // Shape of every quantized network
+    int topologySize;
+    NeuralQuantLayer *layers;   // topologySize - 1 layers
+    size_t networkSize;         // Bytes per network: accumulator scales, then the layers
+    int maxCodes;               // Widest padded layer, inputs included
+
+    int slotCapacity;
+    char **networks;            // Per slot, allocated when the slot is first packed
+    bool *packed;               // Per slot: its network is up to date
+    NeuralParameter *scratch;   // Genome with its deltas applied, while packing
+    int scratchCount;
+} NeuralQuant;
+
+/**
+ * Create an empty set of int8 networks of the given shape
+ *
+ * @param quant Set to initialize
+ * @param topology Neurons per layer, inputs first
+ * @param topologySize Number of layers
+ * @param slotCapacity Number of slots (cells)
+ * @return true on success
+ */
+bool NeuralQuant_Init(NeuralQuant *quant, const int *topology, int topologySize, int slotCapacity);
+
+/**
+ * Free every network
+ *
+ * @param quant Set to free
+ */
+void NeuralQuant_Free(NeuralQuant *quant);
+
+/**
+ * Quantize a network into its slot
+ * A network of another shape is not packed, the slot then has to be run with
+ * NeuralNetwork_Forward. The deltas of a copy-on-write genome are applied,
+ * the genome itself stays as it is.
+ *
+ * @param quant Set
+ * @param slot Slot of the cell
+ * @param nn Network of the cell
+ * @return true if the slot is packed
+ */
+bool NeuralQuant_Pack(NeuralQuant *quant, int slot, const NeuralNetwork *nn);
+
+/**
+ * Mark a slot as empty, its memory is kept for the next network
+ *
+ * @param quant Set
+ * @param slot Slot of the cell
+ */
+void NeuralQuant_Release(NeuralQuant *quant, int slot);
+
+/**
+ * Check whether a slot holds a quantized network
+ *
+ * @param quant Set
+ * @param slot Slot of the cell
+ * @return true if NeuralQuant_Forward can evaluate it
+ */
+bool NeuralQuant_IsPacked(const NeuralQuant *quant, int slot);
+
+/**
+ * Workspace capacity needed by NeuralQuant_Forward
+ *
+ * @param quant Set
+ * @return Scalars per workspace buffer
+ */
+int NeuralQuant_WorkspaceSize(const NeuralQuant *quant);
+
+/**
+ * Run the forward pass of a slot's int8 network
+ * Reentrant for different workspaces, the set is only read.
+ *
+ * @param quant Set
+ * @param slot Slot of the cell
+ * @param inputs Network inputs, in [0, 1]
+ * @param outputs Network outputs (zero if the slot is not packed)
+ * @param workspace Scratch of the calling thread
+ */
+void NeuralQuant_Forward(const NeuralQuant *quant, int slot, const NeuralScalar *inputs, NeuralScalar *outputs,
+                         NeuralWorkspace *workspace);
+
+/**
+ * Choose the fastest int8 layer kernel supported by the CPU, up to maxKernel
+ *
+ * @param maxKernel Fastest kernel allowed
+ * @return The kernel selected
+ */
+NeuralQuantKernel NeuralQuant_SelectKernel(NeuralQuantKernel maxKernel);
+
+/**
+ * Kernel in use, selected on the first call if needed
+ *
+ * @return The kernel selected
+ */
+NeuralQuantKernel NeuralQuant_ActiveKernel(void);
+
+/**
+ * Name of an int8 kernel
+ *
+ * @param kernel Kernel
+ * @return Its name ("scalar", "avx2", "avx512-vnni")
+ */
+const char *NeuralQuant_KernelName(NeuralQuantKernel kernel);
+
+#endif // NEURAL_QUANT_H
@@ -0,0 +1,139 @@
+/**
+ * @file neuralScalar.h
+ * @brief Scalar type of the networks and of the cell inputs/outputs
+ *
+ * Chosen at build time (cmake -DNN_SCALAR=float). Saved networks are text, so
+ * both builds read them.
+ *
+ * Float builds can also store the weights and biases on 16 bits
+ * (cmake -DNN_STORAGE=bf16 or fp16): genomes and packed networks take half the
+ * memory, the kernels widen the parameters to float as they load them, and
+ * every write (initialization, mutation, loading) rounds the float result to
+ * the nearest 16-bit value. bf16 keeps the float range with 8 bits of
+ * precision, fp16 has 11 bits but saturates at 65504 (weights stay far below).
+ */
+
+#ifndef NEURAL_SCALAR_H
+#define NEURAL_SCALAR_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef NN_SCALAR_FLOAT
+typedef float NeuralScalar;
+#define NEURAL_TANH tanhf
+#else
+typedef double NeuralScalar;
+#define NEURAL_TANH tanh
+#endif
+
+#if defined(NN_STORAGE_BF16) || defined(NN_STORAGE_FP16)
+
+#ifndef NN_SCALAR_FLOAT
+#error "16-bit parameter storage computes in float: build with NN_SCALAR=float"
+#endif
+
+#define NEURAL_PARAMETER_HALF 1
+typedef uint16_t NeuralParameter;   // Weight or bias as stored
+
+static inline uint32_t neural_float_bits(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static inline float neural_bits_float(uint32_t bits)
+{
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+#ifdef NN_STORAGE_BF16
+
+#define NEURAL_PRECISION_NAME "float, bf16 storage"
+
+// bf16 is the top half of a float
+static inline NeuralScalar NeuralParameter_Load(NeuralParameter parameter)
+{
+    return neural_bits_float((uint32_t)parameter << 16);
+}
+
+// Round to nearest even (NaN stays a quiet NaN)
+static inline NeuralParameter NeuralParameter_Store(NeuralScalar value)
+{
+    uint32_t bits = neural_float_bits(value);
+    if ((bits & 0x7FFFFFFFu) > 0x7F800000u)
+        return (NeuralParameter)((bits >> 16) | 0x0040u);
+    bits += 0x7FFFu + ((bits >> 16) & 1u);
+    return (NeuralParameter)(bits >> 16);
+}
+
+#else
+
+#define NEURAL_PRECISION_NAME "float, fp16 storage"
+
+// IEEE half to float: exact, subnormals included
+static inline NeuralScalar NeuralParameter_Load(NeuralParameter parameter)
+{
+    const uint32_t exponentMask = 0x7C00u << 13;
+    uint32_t bits = (parameter & 0x7FFFu) << 13;
+    uint32_t exponent = bits & exponentMask;
+
+    bits += (127 - 15) << 23;
+    if (exponent == exponentMask)       // Infinity or NaN
+        bits += (128 - 16) << 23;
+    else if (exponent == 0)             // Zero or subnormal: renormalized by the FPU
+        bits = neural_float_bits(neural_bits_float(bits + (1u << 23)) - neural_bits_float(113u << 23));
+
+    return neural_bits_float(bits | ((uint32_t)(parameter & 0x8000u) << 16));
+}
+
+// Float to IEEE half, rounded to nearest even, overflow to infinity
+static inline NeuralParameter NeuralParameter_Store(NeuralScalar value)
+{
+    uint32_t bits = neural_float_bits(value);
+    uint32_t sign = bits & 0x80000000u;
+    uint32_t half;
+    bits ^= sign;
+
+    if (bits >= 0x47800000u)            // Beyond the half range, infinity or NaN
+        half = bits > 0x7F800000u ? 0x7E00u : 0x7C00u;
+    else if (bits < 0x38800000u)        // Subnormal half: the float addition rounds
+        half = neural_float_bits(neural_bits_float(bits) + neural_bits_float(126u << 23)) - (126u << 23);
+    else
+    {
+        uint32_t odd = (bits >> 13) & 1u;
+        bits += ((uint32_t)(15 - 127) << 23) + 0xFFFu + odd;
+        half = bits >> 13;
+    }
+
+    return (NeuralParameter)(half | (sign >> 16));
+}
+
+#endif // NN_STORAGE_BF16
+
+#else
+
+typedef NeuralScalar NeuralParameter;
+
+#ifdef NN_SCALAR_FLOAT
+#define NEURAL_PRECISION_NAME "float"
+#else
+#define NEURAL_PRECISION_NAME "double"
+#endif
+
+static inline NeuralScalar NeuralParameter_Load(NeuralParameter parameter)
+{
+    return parameter;
+}
+
+static inline NeuralParameter NeuralParameter_Store(NeuralScalar value)
+{
+    return value;
+}
+
+#endif // NN_STORAGE_BF16 || NN_STORAGE_FP16
+
+#endif // NEURAL_SCALAR_H
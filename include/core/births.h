@@ -0,0 +1,96 @@
+/**
+ * @file births.h
+ * @brief Deferred births and free cell slot allocation
+ *
+ * During the parallel phase of a tick each thread only appends to its own
+ * queue (reproductions and deaths), so no lock is needed. After the loop the
+ * queues are merged in cell order: dead cells go into a min-heap keyed on
+ * score, and each birth takes the lowest-scoring dead slot in O(log N).
+ */
+
+#ifndef BIRTHS_H
+#define BIRTHS_H
+
+#include <stdbool.h>
+
+// Forward declaration to avoid circular inclusion
+typedef struct Map Map;
+
+// Events recorded by one thread during a tick (cell indices)
+typedef struct {
+    int *parents;       // Cells that decided to reproduce
+    int parentCount;
+    int *deaths;        // Cells that died
+    int deathCount;
+} BirthQueue;
+
+typedef struct {
+    BirthQueue *queues;     // One per thread
+    int queueCount;
+    int *parents;           // Merge scratch, MEM_CELL_COUNT entries
+    int *freeSlots;         // Min-heap of dead slots ordered by (score, index)
+    int freeSlotCount;
+} Births;
+
+/**
+ * Allocate the queues and the free slot heap
+ *
+ * @param births Births to initialize
+ * @param threadCount Number of threads that may record events
+ * @return true on success
+ */
+bool Births_Init(Births *births, int threadCount);
+
+/**
+ * Free queues and heap memory
+ *
+ * @param births Births to free
+ */
+void Births_Free(Births *births);
+
+/**
+ * Make sure there is one queue per thread, keeping recorded events
+ *
+ * @param births Births to grow
+ * @param threadCount Number of threads that may record events
+ * @return true on success
+ */
+bool Births_Reserve(Births *births, int threadCount);
+
+/**
+ * Record a reproduction decided during the parallel phase
+ *
+ * @param births Births
+ * @param thread Calling thread number
+ * @param index Parent cell index
+ */
+void Births_RecordParent(Births *births, int thread, int index);
+
+/**
+ * Record a death that happened during the parallel phase
+ *
+ * @param births Births
+ * @param thread Calling thread number
+ * @param index Dead cell index
+ */
+void Births_RecordDeath(Births *births, int thread, int index);
+
+/**
+ * Merge the queues: dead cells join the free slots, then every parent gives
+ * birth in cell order. Queues are empty afterwards.
+ *
+ * @param births Births
+ * @param map Map owning the cells
+ */
+void Births_Apply(Births *births, Map *map);
+
+/**
+ * Rebuild the free slot heap from the current cells
+ * Needed whenever cells are revived outside of births (generation reset)
+ *
+ * @param births Births
+ * @param map Map owning the cells
+ */
+void Births_RebuildFreeSlots(Births *births, Map *map);
+
+#endif // BIRTHS_H
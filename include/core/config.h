@@ -37,6 +37,7 @@
 #define CELL_BIRTH_MIN_HEALTH 75        // Minimum health required for reproduction
 #define CELL_BIRTH_HEALTH_SACRIFICE 50  // Health points sacrificed for reproduction
 #define CELL_BIRTH_FAILED_PENALTY 2     // Health penalty for failed reproduction attempt
+#define CELL_DECISION_INTERVAL 1        // Ticks between two runs of a cell's network (steering kept in between)
 
 // Food item
 #define FOOD_ITEM_CAPACITY 20
@@ -59,6 +60,16 @@
 //   - Reproduce: [0.0, 1.0] with threshold at 0.5
 #define NEURAL_NETWORK_TOPOLOGY { 30, 256, 128, 64, 3 }
 
+// Activation: rational approximation of tanh (max error NEURAL_FAST_TANH_MAX_ERROR)
+// instead of libm tanh. Runs vectorized, several times faster.
+#define NEURAL_NETWORK_FAST_TANH true
+
+// Share of the weight blocks of each layer dropped by the pruned inference
+// backend (evaluation runs, see neuralPrune.h), the smallest ones first.
+// None by default: the evolved networks change their decisions even with 1%
+// pruned, measure a share with headless --check-pruned before using it
+#define NEURAL_NETWORK_PRUNE_FRACTION 0.0
+
 // Percentage of top performers selected as parents for next generation
 #define EVOLUTION_PARENT_SELECTION_RATIO 0.1f
 
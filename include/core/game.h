@@ -11,12 +11,19 @@
 typedef struct Map Map;
 
 #include "config.h"
+#include "spatial_grid.h"
+#include "births.h"
+#include "inference.h"
+#include "population.h"
 #include "../entities/cell.h"
 #include "../entities/food.h"
 #include "../entities/wall.h"
 #include "../ui/popup.h"
 #include "../system/checkpoint.h"
 #include "../ai/neuralNetwork.h"
+#include "../ai/neuralBatch.h"
+#include "../ai/neuralQuant.h"
+#include "../ai/neuralPrune.h"
 #include "../ui/graph/graphEvolution.h"
 #include "../ai/evolution.h"
 #include "../ui/graph/graphEvolutionWindow.h"
@@ -36,11 +43,17 @@ struct Map
     time_t startTime;
     time_t pausedTime;
 
-    Cell *cells[MEM_CELL_COUNT];
+    Population population;  // Every cell slot, hot fields stored as parallel arrays
     Food *foods[MEM_FOOD_COUNT];
     Wall *walls[MEM_WALL_COUNT];
-    Cell *bestCellEver;
-    int cellCount;
+    CellRecord bestCellEver;
+    SpatialGrid grid;  // Spatial index of foods and cells, rebuilt every tick for ray sensing
+    Births births;     // Reproductions and deaths queued during the parallel phase
+    NeuralWorkspace *workspaces;  // Inference scratch, one per thread
+    int workspaceCount;
+    NeuralBatch batch; // Interleaved copy of the cell networks, for block inference
+    NeuralQuant quant; // Int8 copy of the cell networks, for evaluation runs
+    NeuralPrune prune; // Pruned copy of the cell networks, for evaluation runs
     int generation;
     int maxGeneration;
     int frames;
@@ -54,7 +67,11 @@ struct Map
     bool renderEnabled;
 
     bool useMultithreading;  // Runtime flag to enable/disable OpenMP multithreading
-    bool useGpuAcceleration; // Runtime flag to enable/disable GPU acceleration for training
+    InferenceBackend inferenceBackend;  // Runs the networks, change it with Inference_SetBackend
+    InferenceBackend shadowBackend;     // Compared with it on sampled cells (Inference_SetShadow)
+    int shadowInterval;                 // One cell in shadowInterval sampled per tick, 0: no shadow
+    InferenceDivergence divergence;     // Shadow results
+    int decisionInterval;               // Cells sense and decide every decisionInterval ticks (Inference_SetDecisionInterval)
 
     // Screen mode
     int mode;
@@ -88,6 +105,8 @@ struct Map
 };
 
 
+bool Game_init(Map *map, int w, int h);
+void Game_destroy(Map *map);
 bool Game_start(SDL_Window *window, SDL_Renderer *renderer, int w, int h);
 void Game_events(Map *map, SDL_Event *event);
 void Game_update(Map *map);
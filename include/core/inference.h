@@ -0,0 +1,151 @@
+/**
+ * @file inference.h
+ * @brief Inference backends of the think phase, switchable at runtime
+ *
+ * Every backend turns the cells' inputs into their outputs its own way:
+ * - reference: cell by cell with the scalar kernel, the baseline,
+ * - simd: cell by cell with the fastest kernel allowed (NeuralNetwork_SelectKernel),
+ * - batched: blocks of cells, one SIMD lane per cell (NeuralBatch),
+ * - int8: quantized copies of the networks (NeuralQuant), for evaluation runs,
+ * - pruned: block-sparse copies without their smallest weights (NeuralPrune),
+ *   for evaluation runs too.
+ *
+ * The backend can change between two ticks (training dashboard button,
+ * headless -b): the packed copies of the new one are rebuilt on its first
+ * tick. A second backend can shadow the first one: it runs again, on its own,
+ * one sampled cell in shadowInterval per tick, and the difference between
+ * its outputs and the ones the cells acted on is accumulated, along with the
+ * time both backends took on those cells (a batched sample costs a whole
+ * block pass). The backend run again must give the outputs the cells acted
+ * on, the samples where it does not are counted as mismatches. The shadow
+ * never changes what the cells do, so a run can be compared live against
+ * another kernel.
+ *
+ * Steering changes slowly, so cells can also decide every decisionInterval
+ * ticks only: on the other ticks they skip the rays and the network and act
+ * on their last heading and speed again, while they still move every tick.
+ * Reproduction is only tried on a decision tick.
+ * The ticks are staggered (by cell, or by block for the batched backend) to
+ * keep the same load on every tick. Only the decisions are sampled by the shadow.
+ */
+
+#ifndef INFERENCE_H
+#define INFERENCE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../ai/neuralScalar.h"
+
+// Forward declaration to avoid circular inclusion
+typedef struct Map Map;
+
+typedef enum {
+    INFERENCE_REFERENCE,
+    INFERENCE_SIMD,
+    INFERENCE_BATCHED,
+    INFERENCE_QUANTIZED,
+    INFERENCE_PRUNED,
+    INFERENCE_BACKEND_COUNT
+} InferenceBackend;
+
+// Decisions read from the outputs by Cell_applyOutputs
+typedef enum {
+    INFERENCE_DECISION_DIRECTION,   // outputs[0] < 0: backwards
+    INFERENCE_DECISION_TURN,        // outputs[1] < 0: turn left
+    INFERENCE_DECISION_REPRODUCE,   // outputs[2] > 0.5
+    INFERENCE_DECISION_COUNT
+} InferenceDecision;
+
+// Shadow results since the last Inference_ResetDivergence
+typedef struct {
+    uint64_t samples;                           // Cells run by both backends
+    double maxDifference;                       // Largest output difference
+    double totalDifference;                     // Sum over the samples of their mean output difference
+    uint64_t flips[INFERENCE_DECISION_COUNT];   // Samples where the shadow decides otherwise
+    uint64_t mismatches;                        // Samples where the backend run again gives other outputs
+    double backendTime;                         // Seconds taken by the backend on the samples
+    double shadowTime;                          // Seconds taken by the shadow on the samples
+} InferenceDivergence;
+
+/**
+ * Run the think phase of the alive cells with the map's backend, then the
+ * shadow on the sampled cells
+ *
+ * @param map Map (inferenceBackend, shadowBackend, shadowInterval)
+ * @param parallel Spread the cells over the OpenMP threads
+ */
+void Inference_Think(Map *map, bool parallel);
+
+/**
+ * Switch backend, its copies of the networks are rebuilt on the next tick
+ *
+ * @param map Map
+ * @param backend New backend
+ */
+void Inference_SetBackend(Map *map, InferenceBackend backend);
+
+/**
+ * Start shadowing the backend, or stop with an interval of 0
+ * The divergence is reset.
+ *
+ * @param map Map
+ * @param shadow Backend run on the sampled cells
+ * @param interval One cell in interval is sampled per tick
+ */
+void Inference_SetShadow(Map *map, InferenceBackend shadow, int interval);
+
+/**
+ * Run the networks every interval ticks only, 1 for every tick
+ *
+ * @param map Map
+ * @param interval Ticks between two decisions of a cell
+ */
+void Inference_SetDecisionInterval(Map *map, int interval);
+
+/**
+ * Change the share of the weights dropped by the pruned backend, its copies
+ * of the networks are rebuilt on the next tick
+ *
+ * @param map Map
+ * @param fraction Share of the weight blocks of each layer to prune, in [0, 1)
+ * @return false on a share outside [0, 1), the pruning is then left as it was
+ */
+bool Inference_SetPruning(Map *map, double fraction);
+
+/**
+ * Add one sample to the results: its output differences and the decisions of
+ * Cell_applyOutputs that would change
+ *
+ * @param divergence Results to add to
+ * @param reference Outputs the cell acts on (at least 3)
+ * @param outputs Outputs compared with them
+ * @param outputCount Number of outputs
+ */
+void Inference_CompareOutputs(InferenceDivergence *divergence, const NeuralScalar *reference,
+                              const NeuralScalar *outputs, int outputCount);
+
+/**
+ * Clear the shadow results
+ *
+ * @param divergence Results to clear
+ */
+void Inference_ResetDivergence(InferenceDivergence *divergence);
+
+/**
+ * Name of a backend
+ *
+ * @param backend Backend
+ * @return Its name ("reference", "simd", "batched", "int8", "pruned")
+ */
+const char *Inference_BackendName(InferenceBackend backend);
+
+/**
+ * Backend from its name
+ *
+ * @param name Name, as given by Inference_BackendName
+ * @param backend Set to the backend found
+ * @return false if no backend has this name
+ */
+bool Inference_ParseBackend(const char *name, InferenceBackend *backend);
+
+#endif // INFERENCE_H
@@ -0,0 +1,83 @@
+/**
+ * @file population.h
+ * @brief Structure-of-arrays storage for every cell slot
+ *
+ * The fields read or written by every cell on every tick (position, heading,
+ * speed, health, score...) live in parallel arrays indexed by slot, so the
+ * kinematics, sensing and statistics loops stream through memory instead of
+ * chasing one heap pointer per cell. Everything else (rays, network, tuning
+ * constants, player controls) stays in a contiguous array of Cell records.
+ *
+ * Slots [0, count) are in use; a dead cell keeps its slot until a birth or
+ * the next generation reuses it. The networks of the cells come from the
+ * population's pool, so their memory is recycled rather than freed.
+ */
+
+#ifndef POPULATION_H
+#define POPULATION_H
+
+#include <stdbool.h>
+#include "../ai/neuralPool.h"
+
+// Forward declarations to avoid circular inclusion
+typedef struct Cell Cell;
+typedef struct NeuralNetwork NeuralNetwork;
+
+typedef struct {
+    int count;          // Slots in use
+    int capacity;
+
+    // Hot state, one entry per slot
+    float *x;           // Position
+    float *y;
+    float *angle;       // Heading in degrees, [0, 360)
+    float *speed;
+    int *health;
+    int *score;
+    int *generation;
+    bool *alive;
+    bool *networkChanged;   // Network created, copied or mutated since the inference copy (batch or int8) was made
+
+    // Living slots in increasing order, see Population_UpdateAlive
+    int *aliveIndex;
+    int aliveCount;
+
+    // Cold state, one record per slot
+    Cell *cells;
+
+    // Blocks of the cell networks (NEURAL_NETWORK_TOPOLOGY)
+    NeuralPool networks;
+} Population;
+
+// Cell kept outside of the population (best cell ever)
+typedef struct {
+    NeuralNetwork *nn;
+    int score;
+    int generation;
+} CellRecord;
+
+/**
+ * Allocate every array for a fixed number of slots, all unused, and an empty network pool
+ *
+ * @param population Population to initialize
+ * @param capacity Maximum number of cells
+ * @return true on success
+ */
+bool Population_Init(Population *population, int capacity);
+
+/**
+ * Free the networks of used slots, the network pool and every array
+ *
+ * @param population Population to free
+ */
+void Population_Free(Population *population);
+
+/**
+ * Rebuild the list of living slots
+ * Needed after any change of the alive flags (end of tick, generation reset)
+ *
+ * @param population Population
+ */
+void Population_UpdateAlive(Population *population);
+
+#endif // POPULATION_H
@@ -0,0 +1,116 @@
+/**
+ * @file random.h
+ * @brief Seeded random streams (xoshiro256**) replacing libc rand()
+ *
+ * Every random number of a run derives from a single run seed: a stream is
+ * identified by (run seed, stream id) and seeded through splitmix64, so two
+ * streams never share state and a run is reproducible whatever the thread
+ * count or the platform's rand().
+ *
+ * The main stream serves drand/irand and the other serial code (world setup,
+ * food respawn). Each cell owns a stream for its mutations, taken in order
+ * from a counter when the cell is created, born or revived. Those events are
+ * applied serially, so the stream ids do not depend on the thread schedule.
+ *
+ * Rng_Fill produces bulk uniforms with 4 independent lanes stepped together
+ * (AVX2 when available); the scalar and AVX2 paths give the same numbers.
+ */
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <stdint.h>
+
+#define RANDOM_DEFAULT_SEED 1   // Used when Random_Seed was never called
+#define RANDOM_FILL_LANES 4     // Independent generators stepped by Rng_Fill
+
+typedef struct {
+    uint64_t s[4];
+} Rng;
+
+/**
+ * Seed a stream
+ *
+ * @param rng Stream to seed
+ * @param seed Run seed
+ * @param stream Stream id, different ids give independent streams
+ */
+void Rng_Seed(Rng *rng, uint64_t seed, uint64_t stream);
+
+/**
+ * Next 64 random bits of a stream
+ *
+ * @param rng Stream
+ * @return Uniform 64-bit value
+ */
+uint64_t Rng_Next(Rng *rng);
+
+/**
+ * Uniform double in [0, 1) with 53 bits of precision
+ *
+ * @param rng Stream
+ * @return Random value
+ */
+double Rng_Double(Rng *rng);
+
+/**
+ * Uniform double in [min, max)
+ *
+ * @param rng Stream
+ * @param min Lower bound
+ * @param max Upper bound
+ * @return Random value
+ */
+double Rng_Range(Rng *rng, double min, double max);
+
+/**
+ * Uniform integer in [min, max], both included
+ *
+ * @param rng Stream
+ * @param min Lower bound
+ * @param max Upper bound (at most min + 2^32 - 1)
+ * @return Random value
+ */
+int Rng_Int(Rng *rng, int min, int max);
+
+/**
+ * Fill a buffer with uniform doubles in [0, 1) (52 bits of precision)
+ * The lanes are seeded from the stream, which advances by RANDOM_FILL_LANES draws.
+ *
+ * @param rng Stream
+ * @param values Output buffer
+ * @param count Number of values
+ */
+void Rng_Fill(Rng *rng, double *values, int count);
+
+/**
+ * Start a run: reseed the main stream and restart the stream ids
+ * Not thread-safe, call it before the simulation starts.
+ *
+ * @param seed Run seed
+ */
+void Random_Seed(uint64_t seed);
+
+/**
+ * Seed of the current run
+ *
+ * @return The value given to Random_Seed, or RANDOM_DEFAULT_SEED
+ */
+uint64_t Random_GetSeed(void);
+
+/**
+ * Main stream of the run, shared by the serial code only
+ *
+ * @return The stream (never NULL)
+ */
+Rng *Random_Main(void);
+
+/**
+ * Seed a stream with the next unused stream id of the run
+ * Serial code only: the ids are taken from a shared counter.
+ *
+ * @param rng Stream to seed
+ */
+void Random_NewStream(Rng *rng);
+
+#endif // RANDOM_H
@@ -0,0 +1,192 @@
+/**
+ * @file spatial_grid.h
+ * @brief Uniform grid over the map used to accelerate ray sensing
+ *
+ * The grid is rebuilt once per tick from the current foods and living cells.
+ * Each object is stored in every bucket its bounding box overlaps, so a ray
+ * only has to test the objects of the buckets it crosses instead of the
+ * whole population.
+ *
+ * Objects are stored as structure-of-arrays and every bucket is padded with
+ * never-hit entries up to the SIMD width, so one ray is tested against a whole
+ * packet of obstacles per instruction (SSE: 4, AVX2: 8). The kernel is picked
+ * at runtime from the CPU features, with a scalar fallback.
+ */
+
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <stdbool.h>
+#include <SDL2/SDL.h>
+
+// Forward declaration to avoid circular inclusion
+typedef struct Map Map;
+
+// Grid settings
+#define SPATIAL_GRID_BUCKET_SIZE 40.0f  // World units covered by one bucket (side length)
+#define SPATIAL_GRID_MARGIN 40.0f       // Extra border so objects straddling the wrapping edges stay indexed
+
+// Food boxes stored as structure-of-arrays, sorted by bucket
+typedef struct {
+    int *bucketStart;   // Offsets into the arrays, cols * rows + 1 entries
+    int *bucketFill;    // Scratch write cursors used while rebuilding
+    float *minX;        // Box corners at rebuild time
+    float *minY;
+    float *maxX;
+    float *maxY;
+    float *value;       // Food amount at rebuild time
+    int *index;         // Index in map->foods, -1 for padding entries
+    int count;
+    int capacity;
+} SpatialGridBoxes;
+
+// Living cells stored as structure-of-arrays circles, sorted by bucket
+typedef struct {
+    int *bucketStart;
+    int *bucketFill;
+    float *centerX;     // Circle inscribed in the hitbox at rebuild time
+    float *centerY;
+    float *radius;
+    float *value;       // Cell health at rebuild time
+    int *index;         // Index in map->cells, -1 for padding entries
+    int count;
+    int capacity;
+} SpatialGridCircles;
+
+typedef struct {
+    int worldWidth;             // Map size the grid was built for
+    int worldHeight;
+    int cols;                   // Bucket count on each axis
+    int rows;
+    float originX;              // World position of the first bucket corner
+    float originY;
+    int lanes;                  // Bucket ranges are padded to a multiple of this (kernel vector width)
+    SpatialGridBoxes foods;
+    SpatialGridCircles cells;
+} SpatialGrid;
+
+// Ray as seen by the packet kernels
+typedef struct {
+    float originX;
+    float originY;
+    float dirX;             // Normalized direction
+    float dirY;
+    float invDirX;          // 1 / direction (may be +/-inf)
+    float invDirY;
+    float maxDistance;
+} SpatialGridRay;
+
+// Incremental walk over the buckets crossed by a ray (Amanatides & Woo)
+typedef struct {
+    const SpatialGrid *grid;
+    int bucketX;
+    int bucketY;
+    int stepX;
+    int stepY;
+    float tMaxX;        // Ray distance at which the next vertical boundary is crossed
+    float tMaxY;        // Ray distance at which the next horizontal boundary is crossed
+    float tDeltaX;      // Ray distance between two vertical boundaries
+    float tDeltaY;      // Ray distance between two horizontal boundaries
+    float maxDistance;
+    bool done;
+} SpatialGridRayWalk;
+
+/**
+ * Allocate a grid covering a world of the given size (plus margin)
+ *
+ * @param grid Grid to initialize
+ * @param worldWidth Map width
+ * @param worldHeight Map height
+ * @return true on success
+ */
+bool SpatialGrid_Init(SpatialGrid *grid, int worldWidth, int worldHeight);
+
+/**
+ * Free grid memory
+ *
+ * @param grid Grid to free
+ */
+void SpatialGrid_Free(SpatialGrid *grid);
+
+/**
+ * Rebuild the grid from the current foods and living cells of the map
+ * Reallocates the buckets if the map has been resized since the last call
+ *
+ * @param grid Grid to rebuild
+ * @param map Map providing foods and cells
+ */
+void SpatialGrid_Rebuild(SpatialGrid *grid, Map *map);
+
+/**
+ * Start walking the buckets crossed by a ray
+ *
+ * @param grid Grid to walk
+ * @param walk Walk state to initialize
+ * @param ray Ray to walk (direction must be normalized)
+ */
+void SpatialGrid_BeginRay(const SpatialGrid *grid, SpatialGridRayWalk *walk, const SpatialGridRay *ray);
+
+/**
+ * Advance to the next bucket crossed by the ray
+ * Buckets are returned in ray order, so once a hit closer than exitDistance is
+ * known the walk can be stopped.
+ *
+ * @param walk Walk state
+ * @param bucket Output bucket index (row * cols + col)
+ * @param exitDistance Output ray distance at which the ray leaves the bucket
+ * @return false once the ray has left the grid or reached its length
+ */
+bool SpatialGrid_NextBucket(SpatialGridRayWalk *walk, int *bucket, float *exitDistance);
+
+/**
+ * Find the closest food box of a bucket hit by the ray
+ *
+ * @param grid Grid to query
+ * @param ray Ray to cast
+ * @param bucket Bucket index returned by SpatialGrid_NextBucket
+ * @param closestDistance In: current closest hit, out: updated if a closer box is hit
+ * @param hit Output position of the hit box in grid->foods (untouched on miss)
+ * @return true if a closer box was hit
+ */
+bool SpatialGrid_ClosestBox(const SpatialGrid *grid, const SpatialGridRay *ray, int bucket,
+                            float *closestDistance, int *hit);
+
+/**
+ * Find the closest cell circle of a bucket hit by the ray
+ *
+ * @param grid Grid to query
+ * @param ray Ray to cast
+ * @param bucket Bucket index returned by SpatialGrid_NextBucket
+ * @param skipIndex Cell index to ignore (the casting cell itself)
+ * @param closestDistance In: current closest hit, out: updated if a closer circle is hit
+ * @param hit Output position of the hit circle in grid->cells (untouched on miss)
+ * @return true if a closer circle was hit
+ */
+bool SpatialGrid_ClosestCircle(const SpatialGrid *grid, const SpatialGridRay *ray, int bucket, int skipIndex,
+                               float *closestDistance, int *hit);
+
+/**
+ * Select the packet kernels from the CPU features
+ * Done automatically on first use, the choice is shared by every grid and
+ * takes effect on the next rebuild.
+ *
+ * @param allowSimd false forces the scalar kernels
+ * @return Lane width of the selected kernels (1 for scalar)
+ */
+int SpatialGrid_SelectKernels(bool allowSimd);
+
+/**
+ * Get the lane width of the selected packet kernels, selecting them on first use
+ *
+ * @return Number of obstacles tested per instruction (1 for scalar)
+ */
+int SpatialGrid_KernelLanes(void);
+
+/**
+ * Get the name of the selected packet kernels
+ *
+ * @return "scalar", "sse" or "avx2"
+ */
+const char *SpatialGrid_KernelName(void);
+
+#endif // SPATIAL_GRID_H
@@ -46,7 +46,13 @@ void Utils_setBackgroundColor(SDL_Renderer *renderer, SDL_Color color);
 
 void Utils_randInit(void);
 float Utils_map(float value, float min1, float max1, float min2, float max2);
+
+// Draw from the main random stream (serial code only, see random.h), max included
 int irand(int min, int max);
 double drand(double min, double max);
 
+// Aligned heap blocks (alignment must be a power of two), freed with Utils_alignedFree
+void *Utils_alignedAlloc(size_t alignment, size_t size);
+void Utils_alignedFree(void *ptr);
+
 #endif // UTILS_H
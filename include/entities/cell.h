@@ -18,9 +18,11 @@ typedef struct Ray Ray;
 typedef struct Cell Cell;
 
 #include "../core/game.h"
+#include "../core/population.h"
 #include "../ai/neuralNetwork.h"
 #include "wall.h"
 #include "../core/utils.h"
+#include "../core/random.h"
 
 
 typedef enum {
@@ -43,32 +45,36 @@ struct Ray
     float distance;
     float distanceMax;
     RayHit hit;
+
+    SDL_FPoint localDirection;      // Unit direction relative to the cell heading (constant)
+    SDL_FPoint direction;           // World-space unit direction, refreshed every tick
+    SDL_FPoint inverseDirection;    // 1 / direction, used by the slab test
 };
+// Cold per-cell state, see Population for the hot fields (position, heading,
+// speed, health, score, generation, alive)
 struct Cell
 {
-    bool isAlive;
-    int score; // eatenFood
     Ray rays[7];
-    int generation;
 
-    int health;
     int healthInit;
     int healthMax;
     int frame;
     int birthCostMax;
+    bool birthPending;  // Reproduction decided in the think phase, applied by Births_Apply
+    bool deciding;      // Senses and runs its network this tick, else keeps its last steering
 
     bool isAI;
     NeuralNetwork *nn;
-    double inputs[30]; // 1 health + 1 can_reproduce + 7 rays * 4 features
-    double outputs[3]; // acceleration + rotation + reproduction
+    Rng rng;                 // Mutation stream, a new one for each created, born or revived cell
+    NeuralScalar inputs[30]; // 1 health + 1 can_reproduce + 7 rays * 4 features
+    uint8_t activeInputs[30]; // Indices of the non-zero inputs, increasing (skipped by the first layer otherwise)
+    int activeInputCount;
+    NeuralScalar outputs[3]; // acceleration + rotation + reproduction
 
-    SDL_FPoint position;
     SDL_FPoint positionInit;
-    float angle;
     float angleVelocity;
     float angleVelocityMax;
 
-    float speed;
     float speedMax;
     float velocity;
 
@@ -78,22 +84,29 @@ struct Cell
     bool goingRight;
 
     int radius;
-    SDL_FRect hitbox;
     SDL_Texture *sprite;
 };
 
 
-Cell *Cell_create(int x, int y, bool isAI);
-void Cell_update(Cell *cell, Map *map);
+void Cell_init(Population *population, int index, int x, int y, bool isAI);
+bool Cell_create(Population *population, int index, int x, int y, bool isAI);
+void Cell_sense(Population *population, int index, Map *map);
+void Cell_think(Population *population, int index, NeuralWorkspace *workspace);
+void Cell_encodeInputs(Population *population, int index);
+void Cell_applyOutputs(Population *population, int index);
+void Cell_move(Population *population, Map *map);
+void Cell_act(Population *population, int index, Map *map);
 void Cell_mutate(Cell *cell, float mutationRate, float mutationProbability);
-void Cell_GiveBirth(Cell *cell, Map *map);
-void Cell_render(Cell *cell, SDL_Renderer *renderer, bool renderRays, bool isSelected);
-void Cell_reset(Cell *cell);
-void Cell_destroy(Cell *cell);
+bool Cell_GiveBirth(Population *population, int parent, int index, Map *map);
+void Cell_render(Population *population, int index, SDL_Renderer *renderer, float offsetX, float offsetY, bool renderRays, bool isSelected);
+void Cell_reset(Population *population, int index);
+void Cell_destroy(Population *population, int index);
 
 // Collisions
-bool check_rect_collision(Cell *cell, SDL_FRect *hitbox);
-float check_ray_collision(Cell *cell, SDL_FRect *hitbox, int rayIndex);
+bool check_rect_collision(Population *population, int index, SDL_FRect *hitbox);
+
+// Sensing
+void update_ray_directions(Cell *cell, float angle);
 
 // Sprite loading and management functions
 bool load_all_cell_sprites(SDL_Renderer *renderer);
@@ -19,6 +19,8 @@ typedef struct Map Map;
 #define CHECKPOINT_DIR "checkpoints/"   // Directory to store checkpoints
 
 // Checkpoint functions
+void Checkpoint_setDir(const char *dir);
+const char *Checkpoint_getDir(void);
 void Checkpoint_createDir(void);
 void Checkpoint_cleanupOld(void);
 void Checkpoint_save(Map *map);
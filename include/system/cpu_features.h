@@ -0,0 +1,35 @@
+/**
+ * @file cpu_features.h
+ * @brief Runtime detection of the SIMD instruction sets supported by the CPU
+ */
+
+#ifndef CPU_FEATURES_H
+#define CPU_FEATURES_H
+
+#include <stdbool.h>
+
+// SIMD kernels are only compiled for x86 with GCC/Clang (target attributes + cpuid builtins)
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define CPU_HAS_X86_SIMD 1
+#else
+    #define CPU_HAS_X86_SIMD 0
+#endif
+
+typedef struct {
+    bool sse2;      // 128-bit vectors
+    bool avx2;      // 256-bit integer and float vectors
+    bool fma;       // Fused multiply-add
+    bool f16c;      // Half-precision conversions
+    bool avx512f;   // 512-bit vectors
+    bool avx512vnni;    // 8-bit integer dot products on 512-bit vectors
+} CpuFeatures;
+
+/**
+ * Get the SIMD features of the running CPU
+ * Detection runs once, later calls return the cached result
+ *
+ * @return Pointer to the detected features (never NULL)
+ */
+const CpuFeatures *CpuFeatures_Get(void);
+
+#endif // CPU_FEATURES_H
@@ -122,15 +122,14 @@ float Evolution_CalculateDiversity(Map *map)
     float maxScore = 0.0f;
 
     // Calculate mean score and find min/max
-    for (int i = 0; i < map->cellCount; i++) {
-        if (map->cells[i] != NULL) {
-            float score = (float)map->cells[i]->score;
-            totalScore += score;
-            validCells++;
-
-            if (score < minScore) minScore = score;
-            if (score > maxScore) maxScore = score;
-        }
+    const int *scores = map->population.score;
+    for (int i = 0; i < map->population.count; i++) {
+        float score = (float)scores[i];
+        totalScore += score;
+        validCells++;
+
+        if (score < minScore) minScore = score;
+        if (score > maxScore) maxScore = score;
     }
 
     if (validCells <= 1) return 0.0f;
@@ -139,11 +138,9 @@ float Evolution_CalculateDiversity(Map *map)
 
     // Calculate variance
     float variance = 0.0f;
-    for (int i = 0; i < map->cellCount; i++) {
-        if (map->cells[i] != NULL) {
-            float diff = (float)map->cells[i]->score - meanScore;
-            variance += diff * diff;
-        }
+    for (int i = 0; i < map->population.count; i++) {
+        float diff = (float)scores[i] - meanScore;
+        variance += diff * diff;
     }
     variance /= validCells;
 
@@ -0,0 +1,255 @@
+/**
+ * @file neuralBatch.c
+ * @brief Implementation of the interleaved block inference
+ */
+
+#include "../../include/ai/neuralNetwork.h"
+#include "../../include/ai/neuralBatch.h"
+#include "../../include/system/performance.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool NeuralBatch_Init(NeuralBatch *batch, const int *topology, int topologySize, int slotCapacity)
+{
+    memset(batch, 0, sizeof(NeuralBatch));
+
+    batch->topology = malloc(topologySize * sizeof(int));
+    batch->slotCapacity = slotCapacity;
+    batch->blockCapacity = (slotCapacity + NEURAL_BATCH_LANES - 1) / NEURAL_BATCH_LANES;
+    batch->blocks = calloc(batch->blockCapacity, sizeof(NeuralParameter *));
+    batch->slotLane = malloc(slotCapacity * sizeof(int));
+    batch->laneSlot = malloc(slotCapacity * sizeof(int));
+    if (batch->topology == NULL || batch->blocks == NULL || batch->slotLane == NULL || batch->laneSlot == NULL)
+    {
+        fprintf(stderr, "Failed to allocate memory for NeuralBatch !\n");
+        NeuralBatch_Free(batch);
+        return false;
+    }
+
+    for (int slot = 0; slot < slotCapacity; slot++)
+        batch->slotLane[slot] = -1;
+    memcpy(batch->topology, topology, topologySize * sizeof(int));
+    batch->topologySize = topologySize;
+    for (int i = 0; i < topologySize; i++)
+        batch->maxWidth = MAX(batch->maxWidth, topology[i]);
+    for (int i = 0; i < topologySize - 1; i++)
+        batch->blockParameterCount += (topology[i] + 1) * topology[i + 1] * NEURAL_BATCH_LANES;
+    batch->fixedTopology = NeuralNetwork_IsFixedTopology(topology, topologySize);
+
+    return true;
+}
+
+void NeuralBatch_Free(NeuralBatch *batch)
+{
+    if (batch->blocks != NULL)
+    {
+        for (int b = 0; b < batch->blockCapacity; b++)
+            Utils_alignedFree(batch->blocks[b]);
+    }
+    free(batch->blocks);
+    free(batch->slotLane);
+    free(batch->laneSlot);
+    free(batch->topology);
+    memset(batch, 0, sizeof(NeuralBatch));
+}
+
+static bool same_shape(const NeuralBatch *batch, const NeuralNetwork *nn)
+{
+    if (nn->topologySize != batch->topologySize)
+        return false;
+    return memcmp(nn->topology, batch->topology, batch->topologySize * sizeof(int)) == 0;
+}
+
+// Where parameters[index] of a network goes in the lane of a block
+static NeuralParameter *packed_parameter(NeuralParameter *parameters, const NeuralNetwork *nn, int lane, int index)
+{
+    for (int i = 0; i < nn->topologySize - 1; i++)
+    {
+        const NeuralLayer *layer = &nn->layers[i];
+        int n = layer->neuronCount;
+        int m = layer->nextLayerNeuronCount;
+        int weight = index - (int)(layer->weights - nn->parameters);
+        int bias = index - (int)(layer->biases - nn->parameters);
+
+        if (weight >= 0 && weight < n * m)
+            return &parameters[((weight % m) * n + weight / m) * NEURAL_BATCH_LANES + lane];
+        parameters += n * m * NEURAL_BATCH_LANES;
+
+        if (bias >= 0 && bias < m)
+            return &parameters[bias * NEURAL_BATCH_LANES + lane];
+        parameters += m * NEURAL_BATCH_LANES;
+    }
+    return NULL;
+}
+
+bool NeuralBatch_Pack(NeuralBatch *batch, int slot, const NeuralNetwork *nn)
+{
+    if (nn == NULL || !same_shape(batch, nn))
+    {
+        NeuralBatch_Release(batch, slot);
+        return false;
+    }
+
+    int laneIndex = batch->slotLane[slot];
+    if (laneIndex < 0)
+        laneIndex = batch->laneCount;
+    int block = laneIndex / NEURAL_BATCH_LANES;
+    int lane = laneIndex % NEURAL_BATCH_LANES;
+
+    if (batch->blocks[block] == NULL)
+    {
+        size_t size = batch->blockParameterCount * sizeof(NeuralParameter);
+        batch->blocks[block] = Utils_alignedAlloc(NEURAL_NETWORK_ALIGNMENT, size);
+        if (batch->blocks[block] == NULL)
+        {
+            fprintf(stderr, "Failed to allocate memory for NeuralBatch block !\n");
+            return false;
+        }
+        memset(batch->blocks[block], 0, size);
+    }
+
+    if (batch->slotLane[slot] < 0)
+    {
+        batch->slotLane[slot] = laneIndex;
+        batch->laneSlot[laneIndex] = slot;
+        batch->laneCount++;
+    }
+
+    // Per layer: weights [j][k][lane], then biases [j][lane]
+    NeuralParameter *parameters = batch->blocks[block];
+    for (int i = 0; i < nn->topologySize - 1; i++)
+    {
+        const NeuralLayer *layer = &nn->layers[i];
+        int n = layer->neuronCount;
+        int m = layer->nextLayerNeuronCount;
+
+        for (int j = 0; j < m; j++)
+            for (int k = 0; k < n; k++)
+                parameters[(j * n + k) * NEURAL_BATCH_LANES + lane] = layer->weights[k * m + j];
+        parameters += n * m * NEURAL_BATCH_LANES;
+
+        for (int j = 0; j < m; j++)
+            parameters[j * NEURAL_BATCH_LANES + lane] = layer->biases[j];
+        parameters += m * NEURAL_BATCH_LANES;
+    }
+
+    // A copy-on-write genome is packed as is: its block, then its deltas in order
+    for (int d = 0; d < nn->deltaCount; d++)
+    {
+        NeuralParameter *parameter = packed_parameter(batch->blocks[block], nn, lane, nn->deltas[d].index);
+        if (parameter != NULL)
+            *parameter = NeuralParameter_Store(NeuralParameter_Load(*parameter) + nn->deltas[d].value);
+    }
+
+    return true;
+}
+
+void NeuralBatch_Release(NeuralBatch *batch, int slot)
+{
+    int laneIndex = batch->slotLane[slot];
+    if (laneIndex < 0)
+        return;
+
+    // Keep the lanes contiguous: the last one takes the free place
+    int last = batch->laneCount - 1;
+    if (laneIndex != last)
+    {
+        const int lanes = NEURAL_BATCH_LANES;
+        const NeuralParameter *from = batch->blocks[last / lanes] + last % lanes;
+        NeuralParameter *to = batch->blocks[laneIndex / lanes] + laneIndex % lanes;
+        for (int p = 0; p < batch->blockParameterCount; p += lanes)
+            to[p] = from[p];
+
+        int moved = batch->laneSlot[last];
+        batch->slotLane[moved] = laneIndex;
+        batch->laneSlot[laneIndex] = moved;
+    }
+
+    batch->slotLane[slot] = -1;
+    batch->laneCount--;
+}
+
+bool NeuralBatch_IsPacked(const NeuralBatch *batch, int slot)
+{
+    return batch->slotLane[slot] >= 0;
+}
+
+int NeuralBatch_BlockCount(const NeuralBatch *batch)
+{
+    return (batch->laneCount + NEURAL_BATCH_LANES - 1) / NEURAL_BATCH_LANES;
+}
+
+int NeuralBatch_WorkspaceSize(const NeuralBatch *batch)
+{
+    return batch->maxWidth * NEURAL_BATCH_LANES;
+}
+
+void NeuralBatch_Forward(const NeuralBatch *batch, int block, const NeuralScalar *const *inputs,
+                         NeuralScalar *const *outputs, NeuralWorkspace *workspace)
+{
+    const int lanes = NEURAL_BATCH_LANES;
+    const int layerCount = batch->topologySize - 1;
+    const NeuralParameter *parameters = batch->blocks[block];
+
+    if (parameters == NULL || !NeuralWorkspace_Reserve(workspace, NeuralBatch_WorkspaceSize(batch)))
+    {
+        for (int lane = 0; lane < lanes; lane++)
+            if (outputs[lane] != NULL)
+                memset(outputs[lane], 0, batch->topology[layerCount] * sizeof(NeuralScalar));
+        return;
+    }
+
+    PERF_MEASURE(PERF_NEURAL_NETWORK) {
+        // Interleave the observations, lanes without a cell stay at zero
+        NeuralScalar *interleaved = workspace->buffers[0];
+        int inputCount = batch->topology[0];
+        memset(interleaved, 0, inputCount * lanes * sizeof(NeuralScalar));
+        for (int lane = 0; lane < lanes; lane++)
+        {
+            if (inputs[lane] == NULL)
+                continue;
+            for (int k = 0; k < inputCount; k++)
+                interleaved[k * lanes + lane] = inputs[lane][k];
+        }
+
+        const NeuralScalar *current = interleaved;
+
+        if (batch->fixedTopology)
+        {
+            // The first layer skips the inputs that are zero in every lane
+            uint8_t activeInputs[UINT8_MAX + 1];
+            int activeCount = 0;
+            for (int k = 0; k < inputCount; k++)
+            {
+                bool active = false;
+                for (int lane = 0; lane < lanes; lane++)
+                    active |= interleaved[k * lanes + lane] != 0;
+                activeInputs[activeCount] = (uint8_t)k;
+                activeCount += active;
+            }
+            current = NeuralNetwork_BatchForwardFixed(parameters, activeInputs, activeCount, workspace);
+        }
+        else
+        {
+            for (int i = 0; i < layerCount; i++)
+            {
+                int n = batch->topology[i];
+                int m = batch->topology[i + 1];
+                NeuralScalar *next = workspace->buffers[(i + 1) & 1];
+
+                NeuralNetwork_BatchLayer(n, m, parameters, parameters + n * m * lanes, current, next);
+                parameters += (n + 1) * m * lanes;
+                current = next;
+            }
+        }
+
+        int outputCount = batch->topology[layerCount];
+        for (int lane = 0; lane < lanes; lane++)
+        {
+            if (outputs[lane] == NULL)
+                continue;
+            for (int j = 0; j < outputCount; j++)
+                outputs[lane][j] = current[j * lanes + lane];
+        }
+    } // PERF_MEASURE
+}
@@ -1,170 +1,527 @@
 #include "../../include/ai/neuralNetwork.h"
+#include "../../include/ai/neuralPool.h"
 #include "../../include/system/performance.h"
 
-NeuralLayer *createNeuralLayer(int neuronCount, int nextLayerNeuronCount)
+// Number of values that keeps the next array on NEURAL_NETWORK_ALIGNMENT
+static int padded_count(int count)
 {
-    NeuralLayer *layer = (NeuralLayer *)malloc(sizeof(NeuralLayer));
-    if (layer == NULL)
-    {
-        return NULL;
-    }
-
-    layer->neuronCount = neuronCount;
-    layer->nextLayerNeuronCount = nextLayerNeuronCount;
-    layer->weights = (double *)malloc(neuronCount * nextLayerNeuronCount * sizeof(double));
-    layer->biases  = (double *)malloc(nextLayerNeuronCount * sizeof(double));
-    layer->outputs = (double *)malloc(nextLayerNeuronCount * sizeof(double));
-    return layer;
+    int lane = NEURAL_NETWORK_ALIGNMENT / sizeof(NeuralParameter);
+    return (count + lane - 1) / lane * lane;
 }
 
-void freeNeuralLayer(NeuralLayer *layer)
+static size_t align_size(size_t size, size_t alignment)
 {
-    free(layer->weights);
-    free(layer->biases);
-    free(layer->outputs);
-    free(layer);
+    return (size + alignment - 1) / alignment * alignment;
 }
 
 void setRandomWeights(NeuralNetwork *nn, double minValue, double maxValue)
 {
+    // Every value is overwritten: a pooled network only needs a block of its own
+    if (nn->pool != NULL && !NeuralPool_Detach(nn, false))
+        return;
+
     for (int i = 0; i < nn->topologySize - 1; i++)
     {
-        NeuralLayer *layer = nn->layers[i];
+        NeuralLayer *layer = &nn->layers[i];
 
         // Initialize weights with random values
         for (int j = 0; j < layer->neuronCount * layer->nextLayerNeuronCount; j++)
         {
-            layer->weights[j] = drand(minValue, maxValue);
+            layer->weights[j] = NeuralParameter_Store(drand(minValue, maxValue));
         }
 
         // Initialize biases with smaller random values
         for (int j = 0; j < layer->nextLayerNeuronCount; j++)
         {
-            layer->biases[j] = drand(minValue * 0.5, maxValue * 0.5);
+            layer->biases[j] = NeuralParameter_Store(drand(minValue * 0.5, maxValue * 0.5));
         }
     }
 }
 
-NeuralNetwork *createNeuralNetwork(int *topology, int topologySize)
+// Block layout: struct | layers | topology | padding | parameters
+// (a pooled network is the header alone: struct | layers)
+int NeuralNetwork_ParameterCount(const int *topology, int topologySize)
+{
+    int parameterCount = 0;
+    for (int i = 0; i < topologySize - 1; i++)
+        parameterCount += padded_count(topology[i] * topology[i + 1]) + padded_count(topology[i + 1]);
+    return parameterCount;
+}
+
+static size_t layers_offset(void)
+{
+    return align_size(sizeof(NeuralNetwork), sizeof(double));
+}
+
+size_t NeuralNetwork_HeaderSize(int topologySize)
 {
-    NeuralNetwork *nn = (NeuralNetwork *)malloc(sizeof(NeuralNetwork));
-    if (nn == NULL)
+    return layers_offset() + (topologySize - 1) * sizeof(NeuralLayer);
+}
+
+static size_t topology_offset(int topologySize)
+{
+    return NeuralNetwork_HeaderSize(topologySize);
+}
+
+static size_t parameters_offset(int topologySize)
+{
+    return align_size(topology_offset(topologySize) + topologySize * sizeof(int), NEURAL_NETWORK_ALIGNMENT);
+}
+
+// Lay out the struct and the layers in zeroed memory, the parameters are bound
+// separately. The topology array is referenced, not copied
+NeuralNetwork *NeuralNetwork_InitHeader(void *memory, int *topology, int topologySize)
+{
+    NeuralNetwork *nn = memory;
+    nn->layers = (NeuralLayer *)((char *)memory + layers_offset());
+    nn->topology = topology;
+    nn->topologySize = topologySize;
+    nn->parameterCount = NeuralNetwork_ParameterCount(topology, topologySize);
+    nn->fixedTopology = NeuralNetwork_IsFixedTopology(topology, topologySize);
+
+    for (int i = 0; i < topologySize - 1; i++)
     {
-        return NULL;
+        nn->layers[i].neuronCount = topology[i];
+        nn->layers[i].nextLayerNeuronCount = topology[i + 1];
     }
-    nn->topology = (int *)malloc(topologySize * sizeof(int));
-    if (nn->topology == NULL)
+
+    return nn;
+}
+
+// Point the layers at parameters laid out for the network's shape
+void NeuralNetwork_BindParameters(NeuralNetwork *nn, NeuralParameter *parameters)
+{
+    nn->parameters = parameters;
+    for (int i = 0; i < nn->topologySize - 1; i++)
     {
-        free(nn);
-        return NULL;
+        NeuralLayer *layer = &nn->layers[i];
+        layer->weights = parameters;
+        parameters += padded_count(layer->neuronCount * layer->nextLayerNeuronCount);
+        layer->biases = parameters;
+        parameters += padded_count(layer->nextLayerNeuronCount);
     }
-    nn->topologySize = topologySize;
-    nn->layers = (NeuralLayer **)malloc((topologySize - 1) * sizeof(NeuralLayer *));
-    if (nn->layers == NULL)
+}
+
+NeuralNetwork *createNeuralNetwork(int *topology, int topologySize)
+{
+    size_t blockSize = parameters_offset(topologySize) + NeuralNetwork_ParameterCount(topology, topologySize) * sizeof(NeuralParameter);
+    char *block = Utils_alignedAlloc(NEURAL_NETWORK_ALIGNMENT, blockSize);
+    if (block == NULL)
     {
-        free(nn->topology);
-        free(nn);
         return NULL;
     }
+    memset(block, 0, blockSize);
 
-    for (int i = 0; i < topologySize - 1; i++)
-    {
-        nn->topology[i] = topology[i];
-        nn->layers[i] = createNeuralLayer(topology[i], topology[i + 1]);
-        if (nn->layers[i] == NULL)
-        {
-            free(nn->topology);
-            free(nn->layers);
-            free(nn);
-            return NULL;
-        }
-    }
-    nn->topology[topologySize - 1] = topology[topologySize - 1];
+    int *blockTopology = (int *)(block + topology_offset(topologySize));
+    memcpy(blockTopology, topology, topologySize * sizeof(int));
+    NeuralNetwork *nn = NeuralNetwork_InitHeader(block, blockTopology, topologySize);
+    NeuralNetwork_BindParameters(nn, (NeuralParameter *)(block + parameters_offset(topologySize)));
 
     return nn;
 }
 
+// A pooled network is cloned from its own pool, sharing its parameters
 NeuralNetwork *NeuralNetwork_Copy(NeuralNetwork *parent)
 {
+    if (parent->pool != NULL)
+        return NeuralPool_Clone(parent->pool, parent);
+
     NeuralNetwork *newNN = createNeuralNetwork(parent->topology, parent->topologySize);
     if (newNN == NULL)
     {
         return NULL;
     }
 
-    for (int i = 0; i < newNN->topologySize - 1; i++)
+    memcpy(newNN->parameters, parent->parameters, parent->parameterCount * sizeof(NeuralParameter));
+
+    return newNN;
+}
+
+// Copy weights and biases into an existing network, without allocating
+// (unless dst shares its block and needs one of its own)
+// Returns false if the topologies differ or memory runs out
+bool NeuralNetwork_CopyInto(NeuralNetwork *dst, NeuralNetwork *src)
+{
+    if (dst == src)
+        return true;
+    if (dst->topologySize != src->topologySize)
+        return false;
+    for (int i = 0; i < src->topologySize; i++)
+        if (dst->topology[i] != src->topology[i])
+            return false;
+
+    if (dst->pool != NULL && !NeuralPool_Detach(dst, false))
+        return false;
+
+    // Same topology, same block layout
+    memcpy(dst->parameters, src->parameters, src->parameterCount * sizeof(NeuralParameter));
+    NeuralNetwork_ApplyDeltas(src, dst->parameters);
+
+    return true;
+}
+
+// Make *dst a copy of src: within a pool it shares the parameters of src,
+// otherwise its block is reused when the shapes match
+// *dst may be NULL; it is left untouched on failure
+bool NeuralNetwork_Assign(NeuralNetwork **dst, NeuralNetwork *src)
+{
+    if (*dst != NULL && src->pool != NULL && (*dst)->pool == src->pool)
+        return NeuralPool_Share(*dst, src);
+    if (*dst != NULL && NeuralNetwork_CopyInto(*dst, src))
+        return true;
+
+    NeuralNetwork *newNN = NeuralNetwork_Copy(src);
+    if (newNN == NULL)
+        return false;
+    if (*dst != NULL)
+        freeNeuralNetwork(*dst);
+    *dst = newNN;
+    return true;
+}
+
+// Dense parameters for the readers: a genome with deltas gets them folded into
+// a block of its own. Serial code only, like every change to the pool
+bool NeuralNetwork_Materialize(NeuralNetwork *nn)
+{
+    if (nn->deltaCount == 0)
+        return true;
+    return NeuralPool_Detach(nn, true);
+}
+
+// Room made for the first mutations of a genome, the list then doubles
+#define DELTAS_MIN_CAPACITY 4096
+
+// Grow the delta list to hold at least capacity mutations (contents are kept)
+bool NeuralNetwork_ReserveDeltas(NeuralNetwork *nn, int capacity)
+{
+    if (capacity <= nn->deltaCapacity)
+        return true;
+
+    capacity = MAX(capacity, MAX(2 * nn->deltaCapacity, DELTAS_MIN_CAPACITY));
+    NeuralDelta *deltas = realloc(nn->deltas, capacity * sizeof(NeuralDelta));
+    if (deltas == NULL)
     {
-        NeuralLayer *newLayer = newNN->layers[i];
-        NeuralLayer *parentLayer = parent->layers[i];
+        fprintf(stderr, "Failed to allocate memory for NeuralNetwork deltas !\n");
+        return false;
+    }
+    nn->deltas = deltas;
+    nn->deltaCapacity = capacity;
+    return true;
+}
 
-        // Copy the weights
-        for (int j = 0; j < newLayer->neuronCount * newLayer->nextLayerNeuronCount; j++)
-        {
-            newLayer->weights[j] = parentLayer->weights[j];
-        }
+// Replay the mutations of a genome on a copy of its block, in the order they
+// were made: the values come out exactly as if they had been mutated in place
+void NeuralNetwork_ApplyDeltas(const NeuralNetwork *nn, NeuralParameter *parameters)
+{
+    for (int d = 0; d < nn->deltaCount; d++)
+    {
+        NeuralParameter *parameter = &parameters[nn->deltas[d].index];
+        *parameter = NeuralParameter_Store(NeuralParameter_Load(*parameter) + nn->deltas[d].value);
+    }
+}
 
-        // Copy the biases
-        for (int j = 0; j < newLayer->nextLayerNeuronCount; j++)
-        {
-            newLayer->biases[j] = parentLayer->biases[j];
-        }
+bool NeuralWorkspace_Init(NeuralWorkspace *workspace, int capacity)
+{
+    memset(workspace, 0, sizeof(NeuralWorkspace));
+    return NeuralWorkspace_Reserve(workspace, capacity);
+}
+
+// Grow the buffers to hold at least capacity outputs (contents are not kept)
+bool NeuralWorkspace_Reserve(NeuralWorkspace *workspace, int capacity)
+{
+    if (capacity <= workspace->capacity)
+        return true;
+
+    capacity = padded_count(capacity);
+    NeuralScalar *front = Utils_alignedAlloc(NEURAL_NETWORK_ALIGNMENT, capacity * sizeof(NeuralScalar));
+    NeuralScalar *back = Utils_alignedAlloc(NEURAL_NETWORK_ALIGNMENT, capacity * sizeof(NeuralScalar));
+    if (front == NULL || back == NULL)
+    {
+        fprintf(stderr, "Failed to allocate memory for NeuralWorkspace !\n");
+        Utils_alignedFree(front);
+        Utils_alignedFree(back);
+        return false;
     }
 
-    return newNN;
+    NeuralWorkspace_Free(workspace);
+    workspace->buffers[0] = front;
+    workspace->buffers[1] = back;
+    workspace->capacity = capacity;
+    return true;
+}
+
+void NeuralWorkspace_Free(NeuralWorkspace *workspace)
+{
+    Utils_alignedFree(workspace->buffers[0]);
+    Utils_alignedFree(workspace->buffers[1]);
+    memset(workspace, 0, sizeof(NeuralWorkspace));
+}
+
+// Widest layer, i.e. the workspace capacity this network needs
+int NeuralNetwork_MaxWidth(const NeuralNetwork *nn)
+{
+    int width = 0;
+    for (int i = 1; i < nn->topologySize; i++)
+        width = MAX(width, nn->topology[i]);
+    return width;
+}
+
+// Number of scalars written by NeuralNetwork_ForwardCapture
+int NeuralNetwork_ActivationCount(const NeuralNetwork *nn)
+{
+    int count = 0;
+    for (int i = 1; i < nn->topologySize; i++)
+        count += nn->topology[i];
+    return count;
 }
 
-void processInputs(NeuralNetwork *nn, double *inputs, double *outputs)
+// Reentrant: the network is only read, intermediate layers go to the workspace.
+// The reference pass runs the scalar kernel whatever NeuralNetwork_SelectKernel chose.
+// With a list of active inputs, the fixed topology pass skips the zero ones
+// (other shapes are rare enough to run every input)
+static inline void forward_pass(const NeuralNetwork *nn, const NeuralScalar *inputs, const uint8_t *activeInputs,
+                                int activeCount, NeuralScalar *outputs, NeuralWorkspace *workspace, bool reference)
 {
     PERF_MEASURE(PERF_NEURAL_NETWORK) {
-        double *currentOutputs = inputs;
-        for (int i = 0; i < nn->topologySize - 1; i++)
+        int layerCount = nn->topologySize - 1;
+        if (!NeuralWorkspace_Reserve(workspace, NeuralNetwork_MaxWidth(nn)))
+        {
+            memset(outputs, 0, nn->topology[layerCount] * sizeof(NeuralScalar));
+        }
+        else if (nn->fixedTopology)
         {
-            NeuralLayer *layer = nn->layers[i];
-            for (int j = 0; j < layer->nextLayerNeuronCount; j++)
+            if (reference)
+                NeuralNetwork_ForwardFixedReference(nn, inputs, outputs, workspace);
+            else if (activeInputs != NULL)
+                NeuralNetwork_ForwardFixedSparse(nn, inputs, activeInputs, activeCount, outputs, workspace);
+            else
+                NeuralNetwork_ForwardFixed(nn, inputs, outputs, workspace);
+        }
+        else
+        {
+            const NeuralScalar *currentOutputs = inputs;
+            for (int i = 0; i < layerCount; i++)
             {
-                // Start with the bias
-                layer->outputs[j] = layer->biases[j];
-
-                for (int k = 0; k < layer->neuronCount; k++)
-                {
-                    layer->outputs[j] += currentOutputs[k] * layer->weights[k * layer->nextLayerNeuronCount + j];
-                }
-                layer->outputs[j] = tanh(layer->outputs[j]);
+                NeuralScalar *layerOutputs = i == layerCount - 1 ? outputs : workspace->buffers[i & 1];
+                if (reference)
+                    NeuralNetwork_DenseLayerReference(&nn->layers[i], currentOutputs, layerOutputs);
+                else
+                    NeuralNetwork_DenseLayer(&nn->layers[i], currentOutputs, layerOutputs);
+                currentOutputs = layerOutputs;
             }
-            currentOutputs = layer->outputs;
         }
-        for (int i = 0; i < nn->layers[nn->topologySize - 2]->nextLayerNeuronCount; i++)
+    } // PERF_MEASURE
+}
+
+void NeuralNetwork_Forward(const NeuralNetwork *nn, const NeuralScalar *inputs, NeuralScalar *outputs, NeuralWorkspace *workspace)
+{
+    forward_pass(nn, inputs, NULL, 0, outputs, workspace, false);
+}
+
+void NeuralNetwork_ForwardReference(const NeuralNetwork *nn, const NeuralScalar *inputs, NeuralScalar *outputs, NeuralWorkspace *workspace)
+{
+    forward_pass(nn, inputs, NULL, 0, outputs, workspace, true);
+}
+
+// activeInputs: increasing indices of the non-zero inputs (NeuralNetwork_ActiveInputs)
+void NeuralNetwork_ForwardSparse(const NeuralNetwork *nn, const NeuralScalar *inputs, const uint8_t *activeInputs,
+                                 int activeCount, NeuralScalar *outputs, NeuralWorkspace *workspace)
+{
+    forward_pass(nn, inputs, activeInputs, activeCount, outputs, workspace, false);
+}
+
+// Same pass keeping every layer's outputs, one layer after the other
+// (debug views only, see NeuralNetwork_ActivationCount for the size)
+void NeuralNetwork_ForwardCapture(const NeuralNetwork *nn, const NeuralScalar *inputs, NeuralScalar *activations)
+{
+    const NeuralScalar *currentOutputs = inputs;
+    for (int i = 0; i < nn->topologySize - 1; i++)
+    {
+        NeuralNetwork_DenseLayer(&nn->layers[i], currentOutputs, activations);
+        currentOutputs = activations;
+        activations += nn->layers[i].nextLayerNeuronCount;
+    }
+}
+
+// Mutations drawn at once by the mutation sampler
+#define MUTATION_CHUNK 256
+// Skips found by table lookup, longer ones fall back to the logarithm
+#define MUTATION_SKIP_TABLE 64
+// Above this probability testing every value is cheaper than skipping
+#define MUTATION_DENSE_PROBABILITY 0.25
+
+typedef struct {
+    Rng *rng;
+    int next;                           // Next unused mutation of the chunk
+    double skips[MUTATION_CHUNK];       // Values left untouched before each mutation
+    double deltas[MUTATION_CHUNK];      // Perturbations in [-1, 1)
+    int64_t keep[MUTATION_SKIP_TABLE];  // Bits of (1 - p)^k: probability of skipping at least k values
+    double inverseLogKeep;              // 1 / log(1 - p)
+} MutationSampler;
+
+// Non-negative doubles compare like their bit patterns: comparing those as
+// integers keeps the compiler from turning the tests back into branches
+static int64_t double_bits(double value)
+{
+    int64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Geometric of parameter p: the largest k with v <= (1 - p)^k,
+// i.e. floor(log(v) / log(1 - p)), for v uniform in (0, 1]
+static double skip_count(const MutationSampler *sampler, double v)
+{
+    // Branchless binary search in the decreasing table
+    int64_t bits = double_bits(v);
+    int k = 0;
+    for (int step = MUTATION_SKIP_TABLE / 2; step > 0; step /= 2)
+        k += step & -(int)(bits <= sampler->keep[k + step]);
+
+    if (k < MUTATION_SKIP_TABLE - 1)
+        return k;
+    return MAX(k, floor(log(v) * sampler->inverseLogKeep));
+}
+
+// Draw the next chunk of mutations: bulk uniforms, then independent
+// lookups that the CPU can overlap
+static void refill_mutations(MutationSampler *sampler)
+{
+    Rng_Fill(sampler->rng, sampler->skips, MUTATION_CHUNK);
+    Rng_Fill(sampler->rng, sampler->deltas, MUTATION_CHUNK);
+    for (int i = 0; i < MUTATION_CHUNK; i++)
+    {
+        sampler->skips[i] = skip_count(sampler, 1.0 - sampler->skips[i]);
+        sampler->deltas[i] = 2.0 * sampler->deltas[i] - 1.0;
+    }
+    sampler->next = 0;
+}
+
+// Memory of deltaCount deltas, relative to a parameter block
+static double delta_share(const NeuralNetwork *nn, double deltaCount)
+{
+    return deltaCount * sizeof(NeuralDelta) / (nn->parameterCount * sizeof(NeuralParameter));
+}
+
+static bool record_delta(NeuralNetwork *nn, int index, double value)
+{
+    if (nn->deltaCount == nn->deltaCapacity && !NeuralNetwork_ReserveDeltas(nn, nn->deltaCount + 1))
+        return false;
+    nn->deltas[nn->deltaCount++] = (NeuralDelta) { index, (NeuralScalar)value };
+    return true;
+}
+
+// Visits the mutated values only, parameters[first] to parameters[first + count - 1].
+// A skip running past the end of the array carries over to the next one, so
+// the parameters behave as one sequence of independent trials.
+// A recorded mutation goes to the deltas instead of the parameters; when the
+// deltas cannot grow, the genome gets a block of its own and *record is cleared.
+// Returns false if neither can be allocated, the mutation is then lost
+static bool mutate_values(NeuralNetwork *nn, int first, int count, double mutationRate, MutationSampler *sampler, bool *record)
+{
+    double position = 0.0;
+    for (;;)
+    {
+        if (sampler->next == MUTATION_CHUNK)
+            refill_mutations(sampler);
+
+        double target = position + sampler->skips[sampler->next];
+        if (target >= count)
         {
-            outputs[i] = currentOutputs[i];
+            sampler->skips[sampler->next] = target - count;
+            return true;
         }
-    } // PERF_MEASURE
+        int index = first + (int)target;
+        double perturbation = mutationRate * sampler->deltas[sampler->next++];
+        if (*record && !record_delta(nn, index, perturbation))
+        {
+            if (!NeuralPool_Detach(nn, true))
+                return false;
+            *record = false;
+        }
+        if (!*record)
+            nn->parameters[index] = NeuralParameter_Store(NeuralParameter_Load(nn->parameters[index])
+                                                          + (NeuralScalar)perturbation);
+        position = target + 1.0;
+    }
+}
+
+// Dense version for high probabilities: one test per value, without branches
+// (the skips buffer holds the uniforms of the tests)
+static void mutate_values_dense(NeuralParameter *values, int count, double mutationRate, double mutationProbability,
+                                MutationSampler *sampler)
+{
+    int64_t threshold = double_bits(mutationProbability);
+
+    for (int first = 0; first < count; first += MUTATION_CHUNK)
+    {
+        int chunk = MIN(MUTATION_CHUNK, count - first);
+        Rng_Fill(sampler->rng, sampler->skips, chunk);
+        Rng_Fill(sampler->rng, sampler->deltas, chunk);
+        for (int j = 0; j < chunk; j++)
+        {
+            int64_t delta = double_bits(mutationRate * (2.0 * sampler->deltas[j] - 1.0));
+            delta &= -(int64_t)(double_bits(sampler->skips[j]) < threshold);
+
+            double perturbation;
+            memcpy(&perturbation, &delta, sizeof(perturbation));
+            values[first + j] = NeuralParameter_Store(NeuralParameter_Load(values[first + j]) + perturbation);
+        }
+    }
 }
 
-void mutate_NeuralNetwork_Weights(NeuralNetwork *nn, double mutationRate, float mutationProbability)
+// Each weight and bias is perturbed by U(-rate, rate) with the given probability,
+// drawing random numbers for the mutated values only.
+// The rng is the cell's own stream, so the result does not depend on which
+// thread or in which order the cells are mutated.
+// A genome sharing its block records the mutations as deltas, so a child
+// costs what its mutations cost; when the deltas would weigh too much, it gets
+// a block of its own instead
+void mutate_NeuralNetwork_Weights(NeuralNetwork *nn, double mutationRate, float mutationProbability, Rng *rng)
 {
+    if (mutationProbability <= 0.0f)
+        return;
+
+    bool dense = mutationProbability > MUTATION_DENSE_PROBABILITY;
+    bool record = false;
+    if (nn->pool != NULL && nn->block->refCount > 1 && !dense)
+    {
+        double expectedDeltas = nn->deltaCount + (double)mutationProbability * nn->parameterCount;
+        record = delta_share(nn, expectedDeltas) <= NEURAL_POOL_MAX_DELTA_SHARE;
+    }
+    if (nn->pool != NULL && !record && !NeuralPool_Detach(nn, true))
+        return;
+
     PERF_MEASURE(PERF_MUTATION) {
+        MutationSampler sampler = { .rng = rng, .next = MUTATION_CHUNK };
+        double keep = 1.0 - MIN((double)mutationProbability, 1.0);
+        double keepPower = 1.0;
+        for (int k = 0; k < MUTATION_SKIP_TABLE; k++, keepPower *= keep)
+            sampler.keep[k] = double_bits(keepPower);
+        sampler.inverseLogKeep = 1.0 / log(keep);
+
         for (int i = 0; i < nn->topologySize - 1; i++)
         {
-            NeuralLayer *layer = nn->layers[i];
-
-            // Weight mutation
-            for (int j = 0; j < layer->neuronCount * layer->nextLayerNeuronCount; j++)
+            NeuralLayer *layer = &nn->layers[i];
+            int weightCount = layer->neuronCount * layer->nextLayerNeuronCount;
+            if (dense)
             {
-                if (rand() / (double)RAND_MAX < mutationProbability)
-                {
-                    layer->weights[j] += drand(-mutationRate, mutationRate);
-                }
+                mutate_values_dense(layer->weights, weightCount, mutationRate, mutationProbability, &sampler);
+                mutate_values_dense(layer->biases, layer->nextLayerNeuronCount, mutationRate, mutationProbability, &sampler);
             }
-
-            // Bias mutation
-            for (int j = 0; j < layer->nextLayerNeuronCount; j++)
+            else
             {
-                if (rand() / (double)RAND_MAX < mutationProbability)
+                if (!mutate_values(nn, (int)(layer->weights - nn->parameters), weightCount, mutationRate, &sampler, &record) ||
+                    !mutate_values(nn, (int)(layer->biases - nn->parameters), layer->nextLayerNeuronCount, mutationRate, &sampler, &record))
                 {
-                    layer->biases[j] += drand(-mutationRate, mutationRate);
+                    fprintf(stderr, "Failed to mutate NeuralNetwork, its mutations stop here !\n");
+                    break;
                 }
             }
         }
+
+        if (record && delta_share(nn, nn->deltaCount) > NEURAL_POOL_MAX_DELTA_SHARE)
+            NeuralNetwork_Materialize(nn);
     } // PERF_MEASURE
 }
 
@@ -174,211 +531,131 @@ void mutate_NeuralNetwork_Weights(NeuralNetwork *nn, double mutationRate, float
  * - Remove a neuron from a random hidden layer (not input/output)
  * Note: Layer addition/removal is disabled as it's complex to implement correctly
  *
+ * The parameter block has a fixed shape, so a changed network is rebuilt:
+ * like realloc, the returned network replaces nn (which is freed if different)
+ *
  * @param nn
  * @param maxNeurons
  * @param maxLayers
  * @param mutationProbability
+ * @return The mutated network, nn itself when nothing changed or on failure
  */
-void mutate_NeuralNetwork_Topology(NeuralNetwork *nn, int maxNeurons, int maxLayers, float mutationProbability)
+NeuralNetwork *mutate_NeuralNetwork_Topology(NeuralNetwork *nn, int maxNeurons, int maxLayers, float mutationProbability)
 {
     (void)maxLayers; // Suppress unused parameter warning
 
-    if (rand() / (double)RAND_MAX >= mutationProbability) {
-        return;
+    if (drand(0, 1) >= mutationProbability) {
+        return nn;
     }
 
     // Only allow neuron addition/removal in hidden layers (not input/output)
     if (nn->topologySize < 3) {
-        return; // Need at least input + hidden + output
+        return nn; // Need at least input + hidden + output
+    }
+    if (!NeuralNetwork_Materialize(nn)) {
+        return nn;
     }
 
-    int mutationType = rand() % 2; // 0 = add neuron, 1 = remove neuron
+    int mutationType = irand(0, 1); // 0 = add neuron, 1 = remove neuron
 
-    if (mutationType == 0)
-    {
-        // Add a neuron to a random HIDDEN layer (exclude input and output)
-        int hiddenLayerCount = nn->topologySize - 2;
-        if (hiddenLayerCount <= 0) return;
+    int hiddenLayerCount = nn->topologySize - 2;
+    int hiddenLayerIndex = irand(0, hiddenLayerCount - 1); // 0 to hiddenLayerCount-1
+    int layerIndex = hiddenLayerIndex + 1; // +1 to skip input layer
 
-        int hiddenLayerIndex = rand() % hiddenLayerCount; // 0 to hiddenLayerCount-1
-        int layerIndex = hiddenLayerIndex + 1; // +1 to skip input layer
+    int currentNeurons = nn->topology[layerIndex];
+    int nextLayerNeurons = nn->topology[layerIndex + 1];
+    int prevNeurons = nn->topology[layerIndex - 1];
 
-        NeuralLayer *currentLayer = nn->layers[layerIndex];
-        int currentNeurons = currentLayer->neuronCount;
-        int nextLayerNeurons = currentLayer->nextLayerNeuronCount;
+    if (mutationType == 0 && currentNeurons >= maxNeurons) {
+        return nn; // Already at max capacity
+    }
+    if (mutationType == 1 && currentNeurons <= 1) {
+        return nn; // Can't remove the last neuron
+    }
+    int neuronToRemove = mutationType == 1 ? irand(0, currentNeurons - 1) : -1;
 
-        if (currentNeurons >= maxNeurons) {
-            return; // Already at max capacity
-        }
+    int *topology = (int *)malloc(nn->topologySize * sizeof(int));
+    if (topology == NULL) {
+        return nn;
+    }
+    memcpy(topology, nn->topology, nn->topologySize * sizeof(int));
+    topology[layerIndex] = currentNeurons + (mutationType == 0 ? 1 : -1);
+    NeuralNetwork *newNN = createNeuralNetwork(topology, nn->topologySize);
+    free(topology);
+    if (newNN == NULL) {
+        return nn;
+    }
 
-        // Create new layer with one more neuron
-        NeuralLayer *newLayer = createNeuralLayer(currentNeurons + 1, nextLayerNeurons);
-        if (newLayer == NULL) {
-            return;
-        }
+    // Layers away from the mutated neuron are unchanged
+    for (int i = 0; i < nn->topologySize - 1; i++) {
+        if (i == layerIndex || i == layerIndex - 1)
+            continue;
+        NeuralLayer *src = &nn->layers[i];
+        memcpy(newNN->layers[i].weights, src->weights, src->neuronCount * src->nextLayerNeuronCount * sizeof(NeuralParameter));
+        memcpy(newNN->layers[i].biases, src->biases, src->nextLayerNeuronCount * sizeof(NeuralParameter));
+    }
 
-        // Copy existing weights from current layer to new layer
-        // Format: weights[from_neuron * next_layer_size + to_neuron]
-        for (int from = 0; from < currentNeurons; from++) {
-            for (int to = 0; to < nextLayerNeurons; to++) {
-                int oldIndex = from * nextLayerNeurons + to;
-                int newIndex = from * nextLayerNeurons + to;
-                newLayer->weights[newIndex] = currentLayer->weights[oldIndex];
-            }
-        }
+    NeuralLayer *currentLayer = &nn->layers[layerIndex];
+    NeuralLayer *newLayer = &newNN->layers[layerIndex];
+    NeuralLayer *prevLayer = &nn->layers[layerIndex - 1];
+    NeuralLayer *newPrevLayer = &newNN->layers[layerIndex - 1];
 
-        // Initialize weights for the new neuron (last neuron)
+    // Format: weights[from_neuron * next_layer_size + to_neuron]
+    if (mutationType == 0)
+    {
+        // Copy existing weights from current layer, then weights of the new neuron (last one)
+        memcpy(newLayer->weights, currentLayer->weights, currentNeurons * nextLayerNeurons * sizeof(NeuralParameter));
         for (int to = 0; to < nextLayerNeurons; to++) {
-            int newIndex = currentNeurons * nextLayerNeurons + to;
-            newLayer->weights[newIndex] = drand(-0.5, 0.5);
+            newLayer->weights[currentNeurons * nextLayerNeurons + to] = NeuralParameter_Store(drand(-0.5, 0.5));
         }
+        memcpy(newLayer->biases, currentLayer->biases, nextLayerNeurons * sizeof(NeuralParameter));
 
-        // Copy existing biases
-        for (int i = 0; i < nextLayerNeurons; i++) {
-            newLayer->biases[i] = currentLayer->biases[i];
-        }
-
-        // Update topology
-        nn->topology[layerIndex] = currentNeurons + 1;
-
-        // Update previous layer if it exists to connect to the new neuron
-        if (layerIndex > 0) {
-            NeuralLayer *prevLayer = nn->layers[layerIndex - 1];
-            int prevNeurons = prevLayer->neuronCount;
-            int prevNextLayerNeurons = prevLayer->nextLayerNeuronCount;
-
-            // Create new previous layer with updated connections
-            NeuralLayer *newPrevLayer = createNeuralLayer(prevNeurons, currentNeurons + 1);
-            if (newPrevLayer == NULL) {
-                freeNeuralLayer(newLayer);
-                return;
-            }
-
-            // Copy existing weights and add new connections to the new neuron
-            for (int from = 0; from < prevNeurons; from++) {
-                for (int to = 0; to < currentNeurons; to++) {
-                    int oldIndex = from * prevNextLayerNeurons + to;
-                    int newIndex = from * (currentNeurons + 1) + to;
-                    newPrevLayer->weights[newIndex] = prevLayer->weights[oldIndex];
-                }
-                // Add connection to new neuron
-                int newNeuronIndex = from * (currentNeurons + 1) + currentNeurons;
-                newPrevLayer->weights[newNeuronIndex] = drand(-0.5, 0.5);
+        // Previous layer gets a connection to the new neuron
+        for (int from = 0; from < prevNeurons; from++) {
+            for (int to = 0; to < currentNeurons; to++) {
+                newPrevLayer->weights[from * (currentNeurons + 1) + to] = prevLayer->weights[from * currentNeurons + to];
             }
-
-            // Copy biases and add bias for new neuron
-            for (int i = 0; i < currentNeurons; i++) {
-                newPrevLayer->biases[i] = prevLayer->biases[i];
-            }
-            newPrevLayer->biases[currentNeurons] = drand(-0.5, 0.5);
-
-            // Replace previous layer
-            freeNeuralLayer(nn->layers[layerIndex - 1]);
-            nn->layers[layerIndex - 1] = newPrevLayer;
+            newPrevLayer->weights[from * (currentNeurons + 1) + currentNeurons] = NeuralParameter_Store(drand(-0.5, 0.5));
         }
-
-        // Replace current layer
-        freeNeuralLayer(nn->layers[layerIndex]);
-        nn->layers[layerIndex] = newLayer;
+        memcpy(newPrevLayer->biases, prevLayer->biases, currentNeurons * sizeof(NeuralParameter));
+        newPrevLayer->biases[currentNeurons] = NeuralParameter_Store(drand(-0.5, 0.5));
     }
-    else if (mutationType == 1)
+    else
     {
-        // Remove a neuron from a random HIDDEN layer
-        int hiddenLayerCount = nn->topologySize - 2;
-        if (hiddenLayerCount <= 0) return;
-
-        int hiddenLayerIndex = rand() % hiddenLayerCount;
-        int layerIndex = hiddenLayerIndex + 1; // +1 to skip input layer
-
-        NeuralLayer *currentLayer = nn->layers[layerIndex];
-        int currentNeurons = currentLayer->neuronCount;
-        int nextLayerNeurons = currentLayer->nextLayerNeuronCount;
-
-        if (currentNeurons <= 1) {
-            return; // Can't remove the last neuron
-        }
-
-        int neuronToRemove = rand() % currentNeurons;
-
-        // Create new layer with one less neuron
-        NeuralLayer *newLayer = createNeuralLayer(currentNeurons - 1, nextLayerNeurons);
-        if (newLayer == NULL) {
-            return;
-        }
-
         // Copy weights, skipping the removed neuron
         int newFrom = 0;
         for (int from = 0; from < currentNeurons; from++) {
             if (from == neuronToRemove) continue;
-
-            for (int to = 0; to < nextLayerNeurons; to++) {
-                int oldIndex = from * nextLayerNeurons + to;
-                int newIndex = newFrom * nextLayerNeurons + to;
-                newLayer->weights[newIndex] = currentLayer->weights[oldIndex];
-            }
+            memcpy(&newLayer->weights[newFrom * nextLayerNeurons], &currentLayer->weights[from * nextLayerNeurons],
+                   nextLayerNeurons * sizeof(NeuralParameter));
             newFrom++;
         }
-
-        // Copy biases
-        for (int i = 0; i < nextLayerNeurons; i++) {
-            newLayer->biases[i] = currentLayer->biases[i];
-        }
-
-        // Update topology
-        nn->topology[layerIndex] = currentNeurons - 1;
-
-        // Update previous layer if it exists
-        if (layerIndex > 0) {
-            NeuralLayer *prevLayer = nn->layers[layerIndex - 1];
-            int prevNeurons = prevLayer->neuronCount;
-            int prevNextLayerNeurons = prevLayer->nextLayerNeuronCount;
-
-            // Create new previous layer with updated connections
-            NeuralLayer *newPrevLayer = createNeuralLayer(prevNeurons, currentNeurons - 1);
-            if (newPrevLayer == NULL) {
-                freeNeuralLayer(newLayer);
-                return;
+        memcpy(newLayer->biases, currentLayer->biases, nextLayerNeurons * sizeof(NeuralParameter));
+
+        // Copy weights and biases of the previous layer, skipping connections to the removed neuron
+        for (int from = 0; from < prevNeurons; from++) {
+            int newTo = 0;
+            for (int to = 0; to < currentNeurons; to++) {
+                if (to == neuronToRemove) continue;
+                newPrevLayer->weights[from * (currentNeurons - 1) + newTo] = prevLayer->weights[from * currentNeurons + to];
+                newTo++;
             }
-
-            // Copy weights, skipping connections to the removed neuron
-            for (int from = 0; from < prevNeurons; from++) {
-                int newTo = 0;
-                for (int to = 0; to < prevNextLayerNeurons; to++) {
-                    if (to == neuronToRemove) continue;
-
-                    int oldIndex = from * prevNextLayerNeurons + to;
-                    int newIndex = from * (currentNeurons - 1) + newTo;
-                    newPrevLayer->weights[newIndex] = prevLayer->weights[oldIndex];
-                    newTo++;
-                }
-            }
-
-            // Copy biases, skipping the removed neuron's bias
-            int newBiasIndex = 0;
-            for (int i = 0; i < prevNextLayerNeurons; i++) {
-                if (i == neuronToRemove) continue;
-                newPrevLayer->biases[newBiasIndex] = prevLayer->biases[i];
-                newBiasIndex++;
-            }
-
-            // Replace previous layer
-            freeNeuralLayer(nn->layers[layerIndex - 1]);
-            nn->layers[layerIndex - 1] = newPrevLayer;
         }
-
-        // Replace current layer
-        freeNeuralLayer(nn->layers[layerIndex]);
-        nn->layers[layerIndex] = newLayer;
+        int newBiasIndex = 0;
+        for (int i = 0; i < currentNeurons; i++) {
+            if (i == neuronToRemove) continue;
+            newPrevLayer->biases[newBiasIndex++] = prevLayer->biases[i];
+        }
     }
+
+    freeNeuralNetwork(nn);
+    return newNN;
 }
 
 void freeNeuralNetwork(NeuralNetwork *nn)
 {
-    for (int i = 0; i < nn->topologySize - 1; i++)
-    {
-        freeNeuralLayer(nn->layers[i]);
-    }
-    free(nn->layers);
-    free(nn->topology);
-    free(nn);
+    if (nn->pool != NULL)
+        NeuralPool_Release(nn->pool, nn);
+    else
+        Utils_alignedFree(nn);
 }
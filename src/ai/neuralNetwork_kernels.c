@@ -0,0 +1,1263 @@
+/**
+ * @file neuralNetwork_kernels.c
+ * @brief Dense layer (GEMV) kernels with runtime CPU dispatch
+ *
+ * A layer computes out[j] = bias[j] + sum_k in[k] * weights[k * m + j], in the
+ * build's NeuralScalar (double, or float with NN_SCALAR_FLOAT). Rows of
+ * the weight matrix are contiguous over j, so the SIMD kernels broadcast one
+ * input and update a block of outputs per instruction, keeping the scalar
+ * summation order (bias first, then k increasing) for every output.
+ * SSE2 therefore matches the scalar reference bit for bit; the AVX2 and
+ * AVX-512 kernels fuse the multiply-add and round once instead of twice, see
+ * NEURAL_KERNEL_TOLERANCE.
+ *
+ * Every kernel, the scalar one included, walks the weights row after row,
+ * contiguously. Panels of one block of outputs ([j / 32][k][32]) were measured
+ * no faster than the rows, so the genomes keep their input-major layout.
+ *
+ * With 16-bit parameter storage (NN_STORAGE=bf16 or fp16, see neuralScalar.h)
+ * the kernels widen each vector of weights or biases to float as they load it
+ * and compute as the float build does: bf16 by a shift, fp16 by F16C on AVX2
+ * (required by that kernel then) and AVX-512, by integer operations on SSE2.
+ *
+ * The batch kernels compute the same layer for a block of cells whose
+ * parameters are interleaved (see neuralBatch.h): every vector holds one value
+ * for each cell of the block, so they need no horizontal work nor tails, and
+ * each lane follows the same summation order as the single-cell kernels.
+ *
+ * The fast activation is the rational approximation of tanh used by Eigen:
+ * x clamped to +-7.9053, then an odd degree-13 over an even degree-6
+ * polynomial. It is within 2.6e-8 of tanh inside the clamp and 2.6e-7 beyond
+ * (tanh(7.9053) is 1 - 2.6e-7), 4e-7 in float: see NEURAL_FAST_TANH_MAX_ERROR.
+ * Only multiplies, adds, min/max and one division, so it vectorizes like the
+ * layers; SSE2 matches the scalar version bit for bit, AVX2 and AVX-512 fuse
+ * the multiply-adds.
+ *
+ * Networks of the configured NEURAL_NETWORK_TOPOLOGY (all of them unless the
+ * topology mutation changed a shape) run a forward pass specialized for it:
+ * every layer's kernel is inlined with constant sizes, which lets the compiler
+ * drop the remainder loops and keep the loop counters out of memory.
+ *
+ * Most sensor inputs are exact zeros (a ray sees food, a cell or a wall, not
+ * all three), so the kernels can also accumulate a list of rows only: the
+ * first layer of those passes then skips the weights of the zero inputs. A
+ * skipped term would have added 0 to the sum, so the outputs are the same.
+ *
+ * The pruned kernels run the block-sparse layers of neuralPrune.h, block of
+ * outputs by block of outputs: the accumulators stay in registers and several
+ * blocks are summed at once, as in the dense kernels. They add the terms of
+ * each output in the order and with the operations of the dense kernel of
+ * their instruction set, the AVX2 one included: its outputs past the last
+ * whole vector take the scalar tail, like in dense_rows_avx2.
+ */
+
+#include "../../include/ai/neuralNetwork.h"
+#include "../../include/ai/neuralBatch.h"
+#include "../../include/ai/neuralPrune.h"
+#include "../../include/system/cpu_features.h"
+#include <math.h>
+#include <string.h>
+
+#if CPU_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+// The kernels are inlined into the fixed topology passes below, where n and m
+// are constants; the dispatch pointers use their out-of-line copies
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+
+typedef void (*LayerKernel)(int n, int m, const NeuralParameter *weights, const NeuralParameter *biases,
+                            const NeuralScalar *inputs, NeuralScalar *outputs);
+typedef void (*ActivationKernel)(NeuralScalar *values, int count);
+typedef void (*PrunedKernel)(int m, const int32_t *blockStart, const uint16_t *blockInputs,
+                             const NeuralParameter *weights, const NeuralParameter *biases,
+                             const NeuralScalar *inputs, NeuralScalar *outputs);
+typedef void (*FixedForward)(const NeuralLayer *layers, const NeuralScalar *inputs, const uint8_t *rows,
+                             int rowCount, NeuralScalar *outputs, NeuralScalar *const *buffers);
+typedef const NeuralScalar *(*FixedBatchForward)(const NeuralParameter *parameters, const uint8_t *rows,
+                                                 int rowCount, NeuralScalar *const *buffers);
+
+static LayerKernel g_dense = NULL;
+static LayerKernel g_batch = NULL;
+static PrunedKernel g_pruned = NULL;
+static ActivationKernel g_fastTanh = NULL;
+static FixedForward g_forwardFixed = NULL;
+static FixedBatchForward g_batchForwardFixed = NULL;
+static NeuralKernel g_kernel = NEURAL_KERNEL_SCALAR;
+static NeuralActivation g_activation = NEURAL_NETWORK_FAST_TANH ? NEURAL_ACTIVATION_FAST : NEURAL_ACTIVATION_EXACT;
+
+static const char *const g_kernelNames[NEURAL_KERNEL_COUNT] = { "scalar", "sse2", "avx2", "avx512" };
+static const char *const g_activationNames[NEURAL_ACTIVATION_COUNT] = { "exact", "fast" };
+
+// Fast tanh: x * P(x^2) / Q(x^2) on [-TANH_CLAMP, TANH_CLAMP]
+#define TANH_CLAMP  7.90531110763549805
+#define TANH_A1     4.89352455891786e-03
+#define TANH_A3     6.37261928875436e-04
+#define TANH_A5     1.48572235717979e-05
+#define TANH_A7     5.12229709037114e-08
+#define TANH_A9    -8.60467152213735e-11
+#define TANH_A11    2.00018790482477e-13
+#define TANH_A13   -2.76076847742355e-16
+#define TANH_B0     4.89352518554385e-03
+#define TANH_B2     2.26843463243900e-03
+#define TANH_B4     1.18534705686654e-04
+#define TANH_B6     1.19825839466702e-06
+
+
+// ============================================================================
+// Scalar kernel (reference and fallback)
+// ============================================================================
+
+// Pre-activations of outputs [first, m). Every dense kernel sums the first n
+// inputs, or the n listed in rows (increasing); the batch kernels the rowCount
+// listed in rows out of n.
+// Like the SIMD kernels, the outputs are accumulated one row of weights at a
+// time: a dot product per output would read a column, one cache line per
+// multiply on the wide layers. Each output still adds its terms in k order.
+KERNEL_INLINE void dense_columns_scalar(int n, int m, const NeuralParameter *weights, const NeuralParameter *biases,
+                                        const NeuralScalar *inputs, NeuralScalar *outputs, int first,
+                                        const uint8_t *rows)
+{
+    for (int j = first; j < m; j++)
+        outputs[j] = NeuralParameter_Load(biases[j]);
+
+    for (int r = 0; r < n; r++)
+    {
+        const int k = rows != NULL ? rows[r] : r;
+        const NeuralScalar x = inputs[k];
+        const NeuralParameter *row = &weights[k * m];
+        for (int j = first; j < m; j++)
+            outputs[j] += x * NeuralParameter_Load(row[j]);
+    }
+}
+
+KERNEL_INLINE void dense_rows_scalar(int n, int m, const NeuralParameter *weights, const NeuralParameter *biases,
+                                     const NeuralScalar *inputs, NeuralScalar *outputs, const uint8_t *rows)
+{
+    dense_columns_scalar(n, m, weights, biases, inputs, outputs, 0, rows);
+}
+
+static inline NeuralScalar fast_tanh(NeuralScalar x)
+{
+    const NeuralScalar clamp = (NeuralScalar)TANH_CLAMP;
+    x = x < -clamp ? -clamp : (x > clamp ? clamp : x);
+
+    const NeuralScalar x2 = x * x;
+    NeuralScalar p = (NeuralScalar)TANH_A13;
+    p = p * x2 + (NeuralScalar)TANH_A11;
+    p = p * x2 + (NeuralScalar)TANH_A9;
+    p = p * x2 + (NeuralScalar)TANH_A7;
+    p = p * x2 + (NeuralScalar)TANH_A5;
+    p = p * x2 + (NeuralScalar)TANH_A3;
+    p = p * x2 + (NeuralScalar)TANH_A1;
+    NeuralScalar q = (NeuralScalar)TANH_B6;
+    q = q * x2 + (NeuralScalar)TANH_B4;
+    q = q * x2 + (NeuralScalar)TANH_B2;
+    q = q * x2 + (NeuralScalar)TANH_B0;
+    return x * p / q;
+}
+
+KERNEL_INLINE void tanh_exact(NeuralScalar *values, int count)
+{
+    for (int i = 0; i < count; i++)
+        values[i] = NEURAL_TANH(values[i]);
+}
+
+KERNEL_INLINE void tanh_fast_scalar(NeuralScalar *values, int count)
+{
+    for (int i = 0; i < count; i++)
+        values[i] = fast_tanh(values[i]);
+}
+
+KERNEL_INLINE void batch_rows_scalar(int n, int m, const NeuralParameter *weights, const NeuralParameter *biases,
+                                     const NeuralScalar *inputs, NeuralScalar *outputs,
+                                     const uint8_t *rows, int rowCount)
+{
+    const int lanes = NEURAL_BATCH_LANES;
+
+    for (int j = 0; j < m; j++)
+    {
+        const NeuralParameter *row = &weights[j * n * lanes];
+        NeuralScalar *sum = &outputs[j * lanes];
+
+        for (int l = 0; l < lanes; l++)
+            sum[l] = NeuralParameter_Load(biases[j * lanes + l]);
+        for (int r = 0; r < rowCount; r++)
+        {
+            const int k = rows != NULL ? rows[r] : r;
+            for (int l = 0; l < lanes; l++)
+                sum[l] += inputs[k * lanes + l] * NeuralParameter_Load(row[k * lanes + l]);
+        }
+    }
+}
+
+// Pre-activations of a pruned layer, padded outputs included: each block of
+// outputs from its bias through its kept blocks, by increasing input
+static void pruned_scalar(int m, const int32_t *blockStart, const uint16_t *blockInputs,
+                          const NeuralParameter *weights, const NeuralParameter *biases,
+                          const NeuralScalar *inputs, NeuralScalar *outputs)
+{
+    const int lanes = NEURAL_PRUNE_BLOCK;
+    const int columnCount = (m + lanes - 1) / lanes;
+
+    for (int c = 0; c < columnCount; c++)
+    {
+        NeuralScalar *sum = &outputs[c * lanes];
+        for (int l = 0; l < lanes; l++)
+            sum[l] = NeuralParameter_Load(biases[c * lanes + l]);
+        for (int b = blockStart[c]; b < blockStart[c + 1]; b++)
+        {
+            const NeuralScalar x = inputs[blockInputs[b]];
+            const NeuralParameter *w = &weights[b * lanes];
+            for (int l = 0; l < lanes; l++)
+                sum[l] += x * NeuralParameter_Load(w[l]);
+        }
+    }
+}
+
+
+#if CPU_HAS_X86_SIMD
+
+// Vector types and intrinsics for the build's NeuralScalar
+#ifdef NN_SCALAR_FLOAT
+    #define SSE_LANES 4
+    #define AVX_LANES 8
+    #define AVX512_LANES 16
+    typedef __m128 SseVector;
+    typedef __m256 AvxVector;
+    typedef __m512 Avx512Vector;
+    typedef __mmask16 Avx512Mask;
+    #define sse_loadu       _mm_loadu_ps
+    #define sse_storeu      _mm_storeu_ps
+    #define sse_set1        _mm_set1_ps
+    #define sse_add         _mm_add_ps
+    #define sse_mul         _mm_mul_ps
+    #define sse_div         _mm_div_ps
+    #define sse_min         _mm_min_ps
+    #define sse_max         _mm_max_ps
+    #define avx_loadu       _mm256_loadu_ps
+    #define avx_storeu      _mm256_storeu_ps
+    #define avx_set1        _mm256_set1_ps
+    #define avx_mul         _mm256_mul_ps
+    #define avx_div         _mm256_div_ps
+    #define avx_min         _mm256_min_ps
+    #define avx_max         _mm256_max_ps
+    #define avx_fmadd       _mm256_fmadd_ps
+    #define avx512_loadu    _mm512_loadu_ps
+    #define avx512_storeu   _mm512_storeu_ps
+    #define avx512_set1     _mm512_set1_ps
+    #define avx512_mul      _mm512_mul_ps
+    #define avx512_div      _mm512_div_ps
+    #define avx512_min      _mm512_min_ps
+    #define avx512_max      _mm512_max_ps
+    #define avx512_fmadd    _mm512_fmadd_ps
+    #define avx512_maskz_loadu  _mm512_maskz_loadu_ps
+    #define avx512_mask_storeu  _mm512_mask_storeu_ps
+#else
+    #define SSE_LANES 2
+    #define AVX_LANES 4
+    #define AVX512_LANES 8
+    typedef __m128d SseVector;
+    typedef __m256d AvxVector;
+    typedef __m512d Avx512Vector;
+    typedef __mmask8 Avx512Mask;
+    #define sse_loadu       _mm_loadu_pd
+    #define sse_storeu      _mm_storeu_pd
+    #define sse_set1        _mm_set1_pd
+    #define sse_add         _mm_add_pd
+    #define sse_mul         _mm_mul_pd
+    #define sse_div         _mm_div_pd
+    #define sse_min         _mm_min_pd
+    #define sse_max         _mm_max_pd
+    #define avx_loadu       _mm256_loadu_pd
+    #define avx_storeu      _mm256_storeu_pd
+    #define avx_set1        _mm256_set1_pd
+    #define avx_mul         _mm256_mul_pd
+    #define avx_div         _mm256_div_pd
+    #define avx_min         _mm256_min_pd
+    #define avx_max         _mm256_max_pd
+    #define avx_fmadd       _mm256_fmadd_pd
+    #define avx512_loadu    _mm512_loadu_pd
+    #define avx512_storeu   _mm512_storeu_pd
+    #define avx512_set1     _mm512_set1_pd
+    #define avx512_mul      _mm512_mul_pd
+    #define avx512_div      _mm512_div_pd
+    #define avx512_min      _mm512_min_pd
+    #define avx512_max      _mm512_max_pd
+    #define avx512_fmadd    _mm512_fmadd_pd
+    #define avx512_maskz_loadu  _mm512_maskz_loadu_pd
+    #define avx512_mask_storeu  _mm512_mask_storeu_pd
+#endif
+
+// The AVX2 kernels convert fp16 parameters with F16C
+#ifdef NN_STORAGE_FP16
+    #define AVX2_TARGET "avx2,fma,f16c"
+    #define AVX2_NEEDS_F16C true
+#else
+    #define AVX2_TARGET "avx2,fma"
+    #define AVX2_NEEDS_F16C false
+#endif
+
+// Loads of weights and biases, widened to float with 16-bit storage
+#if defined(NN_STORAGE_BF16)
+
+__attribute__((target("sse2")))
+static inline SseVector sse_loadp(const NeuralParameter *p)
+{
+    return _mm_castsi128_ps(_mm_unpacklo_epi16(_mm_setzero_si128(), _mm_loadl_epi64((const __m128i *)p)));
+}
+
+__attribute__((target(AVX2_TARGET)))
+static inline AvxVector avx_loadp(const NeuralParameter *p)
+{
+    __m256i widened = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)p));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(widened, 16));
+}
+
+__attribute__((target("avx512f")))
+static inline Avx512Vector avx512_loadp(const NeuralParameter *p)
+{
+    __m512i widened = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i *)p));
+    return _mm512_castsi512_ps(_mm512_slli_epi32(widened, 16));
+}
+
+#elif defined(NN_STORAGE_FP16)
+
+// Same steps as NeuralParameter_Load, four halves at a time
+__attribute__((target("sse2")))
+static inline SseVector sse_loadp(const NeuralParameter *p)
+{
+    const __m128i half = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i *)p), _mm_setzero_si128());
+    const __m128i exponentMask = _mm_set1_epi32(0x7C00 << 13);
+    __m128i bits = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x7FFF)), 13);
+    __m128i exponent = _mm_and_si128(bits, exponentMask);
+    bits = _mm_add_epi32(bits, _mm_set1_epi32((127 - 15) << 23));
+
+    __m128i special = _mm_cmpeq_epi32(exponent, exponentMask);
+    bits = _mm_add_epi32(bits, _mm_and_si128(special, _mm_set1_epi32((128 - 16) << 23)));
+
+    __m128i tiny = _mm_cmpeq_epi32(exponent, _mm_setzero_si128());
+    __m128 renormalized = _mm_sub_ps(_mm_castsi128_ps(_mm_add_epi32(bits, _mm_set1_epi32(1 << 23))),
+                                     _mm_castsi128_ps(_mm_set1_epi32(113 << 23)));
+    bits = _mm_or_si128(_mm_andnot_si128(tiny, bits), _mm_and_si128(tiny, _mm_castps_si128(renormalized)));
+
+    __m128i sign = _mm_slli_epi32(_mm_and_si128(half, _mm_set1_epi32(0x8000)), 16);
+    return _mm_castsi128_ps(_mm_or_si128(bits, sign));
+}
+
+__attribute__((target(AVX2_TARGET)))
+static inline AvxVector avx_loadp(const NeuralParameter *p)
+{
+    return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)p));
+}
+
+__attribute__((target("avx512f")))
+static inline Avx512Vector avx512_loadp(const NeuralParameter *p)
+{
+    return _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i *)p));
+}
+
+#else
+    #define sse_loadp       sse_loadu
+    #define avx_loadp       avx_loadu
+    #define avx512_loadp    avx512_loadu
+    #define avx512_maskz_loadp  avx512_maskz_loadu
+#endif
+
+#ifdef NEURAL_PARAMETER_HALF
+// Loads the whole vector and clears the masked lanes: the parameter arrays are
+// padded to NEURAL_NETWORK_ALIGNMENT (32 halves), so the read stays in the network
+__attribute__((target("avx512f")))
+static inline Avx512Vector avx512_maskz_loadp(Avx512Mask mask, const NeuralParameter *p)
+{
+    return _mm512_maskz_mov_ps(mask, avx512_loadp(p));
+}
+#endif
+
+
+// ============================================================================
+// SSE2 kernel: 4 vectors of outputs per block
+// ============================================================================
+
+__attribute__((target("sse2")))
+KERNEL_INLINE void dense_rows_sse2(int n, int m, const NeuralParameter *weights, const NeuralParameter *biases,
+                                   const NeuralScalar *inputs, NeuralScalar *outputs, const uint8_t *rows)
+{
+    int j = 0;
+
+    for (; j + 4 * SSE_LANES <= m; j += 4 * SSE_LANES)
+    {
+        SseVector sum0 = sse_loadp(&biases[j]);
+        SseVector sum1 = sse_loadp(&biases[j + SSE_LANES]);
+        SseVector sum2 = sse_loadp(&biases[j + 2 * SSE_LANES]);
+        SseVector sum3 = sse_loadp(&biases[j + 3 * SSE_LANES]);
+
+        for (int r = 0; r < n; r++)
+        {
+            const int k = rows != NULL ? rows[r] : r;
+            const SseVector x = sse_set1(inputs[k]);
+            const NeuralParameter *row = &weights[k * m + j];
+            sum0 = sse_add(sum0, sse_mul(x, sse_loadp(row)));
+            sum1 = sse_add(sum1, sse_mul(x, sse_loadp(row + SSE_LANES)));
+            sum2 = sse_add(sum2, sse_mul(x, sse_loadp(row + 2 * SSE_LANES)));
+            sum3 = sse_add(sum3, sse_mul(x, sse_loadp(row + 3 * SSE_LANES)));
+        }
+
+        sse_storeu(&outputs[j], sum0);
+        sse_storeu(&outputs[j + SSE_LANES], sum1);
+        sse_storeu(&outputs[j + 2 * SSE_LANES], sum2);
+        sse_storeu(&outputs[j + 3 * SSE_LANES], sum3);
+    }
+
+    for (; j + SSE_LANES <= m; j += SSE_LANES)
+    {
+        SseVector sum = sse_loadp(&biases[j]);
+        for (int r = 0; r < n; r++)
+        {
+            const int k = rows != NULL ? rows[r] : r;
+            sum = sse_add(sum, sse_mul(sse_set1(inputs[k]), sse_loadp(&weights[k * m + j])));
+        }
+        sse_storeu(&outputs[j], sum);
+    }
+
+    dense_columns_scalar(n, m, weights, biases, inputs, outputs, j, rows);
+}
+
+
+// ============================================================================
+// AVX2 + FMA kernel: 4 vectors of outputs per block
+// ============================================================================
+
+__attribute__((target(AVX2_TARGET)))
+KERNEL_INLINE void dense_rows_avx2(int n, int m, const NeuralParameter *weights, const NeuralParameter *biases,
+                                   const NeuralScalar *inputs, NeuralScalar *outputs, const uint8_t *rows)
+{
+    int j = 0;
+
+    for (; j + 4 * AVX_LANES <= m; j += 4 * AVX_LANES)
+    {
+        AvxVector sum0 = avx_loadp(&biases[j]);
+        AvxVector sum1 = avx_loadp(&biases[j + AVX_LANES]);
+        AvxVector sum2 = avx_loadp(&biases[j + 2 * AVX_LANES]);
+        AvxVector sum3 = avx_loadp(&biases[j + 3 * AVX_LANES]);
+
+        for (int r = 0; r < n; r++)
+        {
+            const int k = rows != NULL ? rows[r] : r;
+            const AvxVector x = avx_set1(inputs[k]);
+            const NeuralParameter *row = &weights[k * m + j];
+            sum0 = avx_fmadd(x, avx_loadp(row), sum0);
+            sum1 = avx_fmadd(x, avx_loadp(row + AVX_LANES), sum1);
+            sum2 = avx_fmadd(x, avx_loadp(row + 2 * AVX_LANES), sum2);
+            sum3 = avx_fmadd(x, avx_loadp(row + 3 * AVX_LANES), sum3);
+        }
+
+        avx_storeu(&outputs[j], sum0);
+        avx_storeu(&outputs[j + AVX_LANES], sum1);
+        avx_storeu(&outputs[j + 2 * AVX_LANES], sum2);
+        avx_storeu(&outputs[j + 3 * AVX_LANES], sum3);
+    }
+
+    for (; j + AVX_LANES <= m; j += AVX_LANES)
+    {
+        AvxVector sum = avx_loadp(&biases[j]);
+        for (int r = 0; r < n; r++)
+        {
+            const int k = rows != NULL ? rows[r] : r;
+            sum = avx_fmadd(avx_set1(inputs[k]), avx_loadp(&weights[k * m + j]), sum);
+        }
+        avx_storeu(&outputs[j], sum);
+    }
+
+    // GCC omits the vzeroupper on the tail call, and SSE code after dirty upper
+    // halves (the scalar tail, then tanh) runs several times slower
+    _mm256_zeroupper();
+    dense_columns_scalar(n, m, weights, biases, inputs, outputs, j, rows);
+}
+
+
+// ============================================================================
+// AVX-512 kernel: 4 vectors of outputs per block, masked tail
+// ============================================================================
+
+__attribute__((target("avx512f")))
+KERNEL_INLINE void dense_rows_avx512(int n, int m, const NeuralParameter *weights, const NeuralParameter *biases,
+                                     const NeuralScalar *inputs, NeuralScalar *outputs, const uint8_t *rows)
+{
+    int j = 0;
+
+    for (; j + 4 * AVX512_LANES <= m; j += 4 * AVX512_LANES)
+    {
+        Avx512Vector sum0 = avx512_loadp(&biases[j]);
+        Avx512Vector sum1 = avx512_loadp(&biases[j + AVX512_LANES]);
+        Avx512Vector sum2 = avx512_loadp(&biases[j + 2 * AVX512_LANES]);
+        Avx512Vector sum3 = avx512_loadp(&biases[j + 3 * AVX512_LANES]);
+
+        for (int r = 0; r < n; r++)
+        {
+            const int k = rows != NULL ? rows[r] : r;
+            const Avx512Vector x = avx512_set1(inputs[k]);
+            const NeuralParameter *row = &weights[k * m + j];
+            sum0 = avx512_fmadd(x, avx512_loadp(row), sum0);
+            sum1 = avx512_fmadd(x, avx512_loadp(row + AVX512_LANES), sum1);
+            sum2 = avx512_fmadd(x, avx512_loadp(row + 2 * AVX512_LANES), sum2);
+            sum3 = avx512_fmadd(x, avx512_loadp(row + 3 * AVX512_LANES), sum3);
+        }
+
+        avx512_storeu(&outputs[j], sum0);
+        avx512_storeu(&outputs[j + AVX512_LANES], sum1);
+        avx512_storeu(&outputs[j + 2 * AVX512_LANES], sum2);
+        avx512_storeu(&outputs[j + 3 * AVX512_LANES], sum3);
+    }
+
+    // Remaining outputs one vector at a time, the last one masked (the output layer is only 3 wide)
+    for (; j < m; j += AVX512_LANES)
+    {
+        const Avx512Mask lanes = (m - j >= AVX512_LANES) ? (Avx512Mask)~0u : (Avx512Mask)((1u << (m - j)) - 1);
+        Avx512Vector sum = avx512_maskz_loadp(lanes, &biases[j]);
+        for (int r = 0; r < n; r++)
+        {
+            const int k = rows != NULL ? rows[r] : r;
+            sum = avx512_fmadd(avx512_set1(inputs[k]), avx512_maskz_loadp(lanes, &weights[k * m + j]), sum);
+        }
+        avx512_mask_storeu(&outputs[j], lanes, sum);
+    }
+}
+
+
+// ============================================================================
+// Batch kernels: one group of NEURAL_BATCH_LANES scalars is 4 SSE, 2 AVX or
+// 1 AVX-512 vector(s)
+// ============================================================================
+
+__attribute__((target("sse2")))
+KERNEL_INLINE void batch_rows_sse2(int n, int m, const NeuralParameter *weights, const NeuralParameter *biases,
+                                   const NeuralScalar *inputs, NeuralScalar *outputs,
+                                   const uint8_t *rows, int rowCount)
+{
+    const int lanes = NEURAL_BATCH_LANES;
+    const int stride = n * lanes;
+
+    // Two outputs per pass: 8 accumulators
+    for (int j = 0; j < m; j += 2)
+    {
+        const bool pair = j + 1 < m;
+        const NeuralParameter *row0 = &weights[j * stride];
+        const NeuralParameter *row1 = pair ? row0 + stride : row0;
+        const NeuralParameter *bias1 = &biases[(pair ? j + 1 : j) * lanes];
+
+        SseVector a0 = sse_loadp(&biases[j * lanes]);
+        SseVector a1 = sse_loadp(&biases[j * lanes + SSE_LANES]);
+        SseVector a2 = sse_loadp(&biases[j * lanes + 2 * SSE_LANES]);
+        SseVector a3 = sse_loadp(&biases[j * lanes + 3 * SSE_LANES]);
+        SseVector b0 = sse_loadp(bias1);
+        SseVector b1 = sse_loadp(bias1 + SSE_LANES);
+        SseVector b2 = sse_loadp(bias1 + 2 * SSE_LANES);
+        SseVector b3 = sse_loadp(bias1 + 3 * SSE_LANES);
+
+        for (int r = 0; r < rowCount; r++)
+        {
+            const int k = rows != NULL ? rows[r] : r;
+            const NeuralScalar *x = &inputs[k * lanes];
+            const SseVector x0 = sse_loadu(x);
+            const SseVector x1 = sse_loadu(x + SSE_LANES);
+            const SseVector x2 = sse_loadu(x + 2 * SSE_LANES);
+            const SseVector x3 = sse_loadu(x + 3 * SSE_LANES);
+            const NeuralParameter *w0 = &row0[k * lanes];
+            const NeuralParameter *w1 = &row1[k * lanes];
+            a0 = sse_add(a0, sse_mul(x0, sse_loadp(w0)));
+            a1 = sse_add(a1, sse_mul(x1, sse_loadp(w0 + SSE_LANES)));
+            a2 = sse_add(a2, sse_mul(x2, sse_loadp(w0 + 2 * SSE_LANES)));
+            a3 = sse_add(a3, sse_mul(x3, sse_loadp(w0 + 3 * SSE_LANES)));
+            b0 = sse_add(b0, sse_mul(x0, sse_loadp(w1)));
+            b1 = sse_add(b1, sse_mul(x1, sse_loadp(w1 + SSE_LANES)));
+            b2 = sse_add(b2, sse_mul(x2, sse_loadp(w1 + 2 * SSE_LANES)));
+            b3 = sse_add(b3, sse_mul(x3, sse_loadp(w1 + 3 * SSE_LANES)));
+        }
+
+        NeuralScalar *out = &outputs[j * lanes];
+        sse_storeu(out, a0);
+        sse_storeu(out + SSE_LANES, a1);
+        sse_storeu(out + 2 * SSE_LANES, a2);
+        sse_storeu(out + 3 * SSE_LANES, a3);
+        if (pair)
+        {
+            sse_storeu(out + lanes, b0);
+            sse_storeu(out + lanes + SSE_LANES, b1);
+            sse_storeu(out + lanes + 2 * SSE_LANES, b2);
+            sse_storeu(out + lanes + 3 * SSE_LANES, b3);
+        }
+    }
+}
+
+__attribute__((target(AVX2_TARGET)))
+KERNEL_INLINE void batch_rows_avx2(int n, int m, const NeuralParameter *weights, const NeuralParameter *biases,
+                                   const NeuralScalar *inputs, NeuralScalar *outputs,
+                                   const uint8_t *rows, int rowCount)
+{
+    const int lanes = NEURAL_BATCH_LANES;
+    const int stride = n * lanes;
+    const int blockEnd = m - m % 4;
+
+    // Four outputs per pass: 8 accumulators
+    for (int j = 0; j < blockEnd; j += 4)
+    {
+        const NeuralParameter *row = &weights[j * stride];
+        const NeuralParameter *bias = &biases[j * lanes];
+        AvxVector a0 = avx_loadp(bias), a1 = avx_loadp(bias + AVX_LANES);
+        AvxVector b0 = avx_loadp(bias + lanes), b1 = avx_loadp(bias + lanes + AVX_LANES);
+        AvxVector c0 = avx_loadp(bias + 2 * lanes), c1 = avx_loadp(bias + 2 * lanes + AVX_LANES);
+        AvxVector d0 = avx_loadp(bias + 3 * lanes), d1 = avx_loadp(bias + 3 * lanes + AVX_LANES);
+
+        for (int r = 0; r < rowCount; r++)
+        {
+            const int k = rows != NULL ? rows[r] : r;
+            const AvxVector x0 = avx_loadu(&inputs[k * lanes]);
+            const AvxVector x1 = avx_loadu(&inputs[k * lanes + AVX_LANES]);
+            const NeuralParameter *w = &row[k * lanes];
+            a0 = avx_fmadd(x0, avx_loadp(w), a0);
+            a1 = avx_fmadd(x1, avx_loadp(w + AVX_LANES), a1);
+            b0 = avx_fmadd(x0, avx_loadp(w + stride), b0);
+            b1 = avx_fmadd(x1, avx_loadp(w + stride + AVX_LANES), b1);
+            c0 = avx_fmadd(x0, avx_loadp(w + 2 * stride), c0);
+            c1 = avx_fmadd(x1, avx_loadp(w + 2 * stride + AVX_LANES), c1);
+            d0 = avx_fmadd(x0, avx_loadp(w + 3 * stride), d0);
+            d1 = avx_fmadd(x1, avx_loadp(w + 3 * stride + AVX_LANES), d1);
+        }
+
+        NeuralScalar *out = &outputs[j * lanes];
+        avx_storeu(out, a0);
+        avx_storeu(out + AVX_LANES, a1);
+        avx_storeu(out + lanes, b0);
+        avx_storeu(out + lanes + AVX_LANES, b1);
+        avx_storeu(out + 2 * lanes, c0);
+        avx_storeu(out + 2 * lanes + AVX_LANES, c1);
+        avx_storeu(out + 3 * lanes, d0);
+        avx_storeu(out + 3 * lanes + AVX_LANES, d1);
+    }
+
+    for (int j = blockEnd; j < m; j++)
+    {
+        const NeuralParameter *row = &weights[j * stride];
+        AvxVector a0 = avx_loadp(&biases[j * lanes]);
+        AvxVector a1 = avx_loadp(&biases[j * lanes + AVX_LANES]);
+        for (int r = 0; r < rowCount; r++)
+        {
+            const int k = rows != NULL ? rows[r] : r;
+            a0 = avx_fmadd(avx_loadu(&inputs[k * lanes]), avx_loadp(&row[k * lanes]), a0);
+            a1 = avx_fmadd(avx_loadu(&inputs[k * lanes + AVX_LANES]), avx_loadp(&row[k * lanes + AVX_LANES]), a1);
+        }
+        avx_storeu(&outputs[j * lanes], a0);
+        avx_storeu(&outputs[j * lanes + AVX_LANES], a1);
+    }
+}
+
+__attribute__((target("avx512f")))
+KERNEL_INLINE void batch_rows_avx512(int n, int m, const NeuralParameter *weights, const NeuralParameter *biases,
+                                     const NeuralScalar *inputs, NeuralScalar *outputs,
+                                     const uint8_t *rows, int rowCount)
+{
+    const int lanes = NEURAL_BATCH_LANES;
+    const int stride = n * lanes;
+    const int blockEnd = m - m % 4;
+
+    // Four outputs per pass, one vector each
+    for (int j = 0; j < blockEnd; j += 4)
+    {
+        const NeuralParameter *row = &weights[j * stride];
+        Avx512Vector a = avx512_loadp(&biases[j * lanes]);
+        Avx512Vector b = avx512_loadp(&biases[(j + 1) * lanes]);
+        Avx512Vector c = avx512_loadp(&biases[(j + 2) * lanes]);
+        Avx512Vector d = avx512_loadp(&biases[(j + 3) * lanes]);
+
+        for (int r = 0; r < rowCount; r++)
+        {
+            const int k = rows != NULL ? rows[r] : r;
+            const Avx512Vector x = avx512_loadu(&inputs[k * lanes]);
+            const NeuralParameter *w = &row[k * lanes];
+            a = avx512_fmadd(x, avx512_loadp(w), a);
+            b = avx512_fmadd(x, avx512_loadp(w + stride), b);
+            c = avx512_fmadd(x, avx512_loadp(w + 2 * stride), c);
+            d = avx512_fmadd(x, avx512_loadp(w + 3 * stride), d);
+        }
+
+        avx512_storeu(&outputs[j * lanes], a);
+        avx512_storeu(&outputs[(j + 1) * lanes], b);
+        avx512_storeu(&outputs[(j + 2) * lanes], c);
+        avx512_storeu(&outputs[(j + 3) * lanes], d);
+    }
+
+    for (int j = blockEnd; j < m; j++)
+    {
+        const NeuralParameter *row = &weights[j * stride];
+        Avx512Vector a = avx512_loadp(&biases[j * lanes]);
+        for (int r = 0; r < rowCount; r++)
+        {
+            const int k = rows != NULL ? rows[r] : r;
+            a = avx512_fmadd(avx512_loadu(&inputs[k * lanes]), avx512_loadp(&row[k * lanes]), a);
+        }
+        avx512_storeu(&outputs[j * lanes], a);
+    }
+}
+
+
+// ============================================================================
+// Pruned kernels: one block of NEURAL_PRUNE_BLOCK outputs is 4 SSE, 2 AVX or
+// 1 AVX-512 vector(s), summed from its bias through its kept blocks
+// ============================================================================
+
+__attribute__((target("sse2")))
+static void pruned_sse2(int m, const int32_t *blockStart, const uint16_t *blockInputs,
+                        const NeuralParameter *weights, const NeuralParameter *biases,
+                        const NeuralScalar *inputs, NeuralScalar *outputs)
+{
+    const int lanes = NEURAL_PRUNE_BLOCK;
+    const int columnCount = (m + lanes - 1) / lanes;
+
+    for (int c = 0; c < columnCount; c++)
+    {
+        const NeuralParameter *bias = &biases[c * lanes];
+        SseVector sum0 = sse_loadp(bias);
+        SseVector sum1 = sse_loadp(bias + SSE_LANES);
+        SseVector sum2 = sse_loadp(bias + 2 * SSE_LANES);
+        SseVector sum3 = sse_loadp(bias + 3 * SSE_LANES);
+
+        for (int b = blockStart[c]; b < blockStart[c + 1]; b++)
+        {
+            const SseVector x = sse_set1(inputs[blockInputs[b]]);
+            const NeuralParameter *w = &weights[b * lanes];
+            sum0 = sse_add(sum0, sse_mul(x, sse_loadp(w)));
+            sum1 = sse_add(sum1, sse_mul(x, sse_loadp(w + SSE_LANES)));
+            sum2 = sse_add(sum2, sse_mul(x, sse_loadp(w + 2 * SSE_LANES)));
+            sum3 = sse_add(sum3, sse_mul(x, sse_loadp(w + 3 * SSE_LANES)));
+        }
+
+        NeuralScalar *out = &outputs[c * lanes];
+        sse_storeu(out, sum0);
+        sse_storeu(out + SSE_LANES, sum1);
+        sse_storeu(out + 2 * SSE_LANES, sum2);
+        sse_storeu(out + 3 * SSE_LANES, sum3);
+    }
+}
+
+// One block of outputs on its own, the outputs past vectorEnd as the scalar tail of dense_rows_avx2
+__attribute__((target(AVX2_TARGET)))
+static void pruned_block_avx2(int c, int vectorEnd, const int32_t *blockStart, const uint16_t *blockInputs,
+                              const NeuralParameter *weights, const NeuralParameter *biases,
+                              const NeuralScalar *inputs, NeuralScalar *outputs)
+{
+    const int lanes = NEURAL_PRUNE_BLOCK;
+
+    for (int l = 0; l < lanes; l += AVX_LANES)
+    {
+        const int j = c * lanes + l;
+        if (j + AVX_LANES <= vectorEnd)
+        {
+            AvxVector sum = avx_loadp(&biases[j]);
+            for (int b = blockStart[c]; b < blockStart[c + 1]; b++)
+                sum = avx_fmadd(avx_set1(inputs[blockInputs[b]]), avx_loadp(&weights[b * lanes + l]), sum);
+            avx_storeu(&outputs[j], sum);
+            continue;
+        }
+
+        for (int t = l; t < l + AVX_LANES; t++)
+        {
+            NeuralScalar sum = NeuralParameter_Load(biases[c * lanes + t]);
+            for (int b = blockStart[c]; b < blockStart[c + 1]; b++)
+                sum += inputs[blockInputs[b]] * NeuralParameter_Load(weights[b * lanes + t]);
+            outputs[c * lanes + t] = sum;
+        }
+    }
+}
+
+// Two blocks of outputs per pass: 4 accumulators
+__attribute__((target(AVX2_TARGET)))
+static void pruned_avx2(int m, const int32_t *blockStart, const uint16_t *blockInputs,
+                        const NeuralParameter *weights, const NeuralParameter *biases,
+                        const NeuralScalar *inputs, NeuralScalar *outputs)
+{
+    const int lanes = NEURAL_PRUNE_BLOCK;
+    const int columnCount = (m + lanes - 1) / lanes;
+    const int vectorEnd = m - m % AVX_LANES;    // Outputs of whole vectors in dense_rows_avx2
+    int c = 0;
+
+    for (; (c + 2) * lanes <= vectorEnd; c += 2)
+    {
+        const NeuralParameter *bias = &biases[c * lanes];
+        AvxVector a0 = avx_loadp(bias);
+        AvxVector a1 = avx_loadp(bias + AVX_LANES);
+        AvxVector b0 = avx_loadp(bias + lanes);
+        AvxVector b1 = avx_loadp(bias + lanes + AVX_LANES);
+        int first = blockStart[c], second = blockStart[c + 1];
+        const int firstEnd = blockStart[c + 1], secondEnd = blockStart[c + 2];
+
+        // Both blocks while each has weights left, then the longer one alone
+        for (; first < firstEnd && second < secondEnd; first++, second++)
+        {
+            const AvxVector x = avx_set1(inputs[blockInputs[first]]);
+            const AvxVector y = avx_set1(inputs[blockInputs[second]]);
+            const NeuralParameter *v = &weights[first * lanes];
+            const NeuralParameter *w = &weights[second * lanes];
+            a0 = avx_fmadd(x, avx_loadp(v), a0);
+            a1 = avx_fmadd(x, avx_loadp(v + AVX_LANES), a1);
+            b0 = avx_fmadd(y, avx_loadp(w), b0);
+            b1 = avx_fmadd(y, avx_loadp(w + AVX_LANES), b1);
+        }
+        for (; first < firstEnd; first++)
+        {
+            const AvxVector x = avx_set1(inputs[blockInputs[first]]);
+            a0 = avx_fmadd(x, avx_loadp(&weights[first * lanes]), a0);
+            a1 = avx_fmadd(x, avx_loadp(&weights[first * lanes + AVX_LANES]), a1);
+        }
+        for (; second < secondEnd; second++)
+        {
+            const AvxVector y = avx_set1(inputs[blockInputs[second]]);
+            b0 = avx_fmadd(y, avx_loadp(&weights[second * lanes]), b0);
+            b1 = avx_fmadd(y, avx_loadp(&weights[second * lanes + AVX_LANES]), b1);
+        }
+
+        NeuralScalar *out = &outputs[c * lanes];
+        avx_storeu(out, a0);
+        avx_storeu(out + AVX_LANES, a1);
+        avx_storeu(out + lanes, b0);
+        avx_storeu(out + lanes + AVX_LANES, b1);
+    }
+
+    for (; c < columnCount; c++)
+        pruned_block_avx2(c, vectorEnd, blockStart, blockInputs, weights, biases, inputs, outputs);
+}
+
+// Four blocks of outputs per pass, one vector each
+__attribute__((target("avx512f")))
+static void pruned_avx512(int m, const int32_t *blockStart, const uint16_t *blockInputs,
+                          const NeuralParameter *weights, const NeuralParameter *biases,
+                          const NeuralScalar *inputs, NeuralScalar *outputs)
+{
+    const int lanes = NEURAL_PRUNE_BLOCK;
+    const int columnCount = (m + lanes - 1) / lanes;
+    int c = 0;
+
+    for (; c + 4 <= columnCount; c += 4)
+    {
+        Avx512Vector a = avx512_loadp(&biases[c * lanes]);
+        Avx512Vector b = avx512_loadp(&biases[(c + 1) * lanes]);
+        Avx512Vector d = avx512_loadp(&biases[(c + 2) * lanes]);
+        Avx512Vector e = avx512_loadp(&biases[(c + 3) * lanes]);
+        int i0 = blockStart[c], i1 = blockStart[c + 1], i2 = blockStart[c + 2], i3 = blockStart[c + 3];
+        const int end0 = i1, end1 = i2, end2 = i3, end3 = blockStart[c + 4];
+
+        // The four blocks while each has weights left, then one at a time
+        for (; i0 < end0 && i1 < end1 && i2 < end2 && i3 < end3; i0++, i1++, i2++, i3++)
+        {
+            a = avx512_fmadd(avx512_set1(inputs[blockInputs[i0]]), avx512_loadp(&weights[i0 * lanes]), a);
+            b = avx512_fmadd(avx512_set1(inputs[blockInputs[i1]]), avx512_loadp(&weights[i1 * lanes]), b);
+            d = avx512_fmadd(avx512_set1(inputs[blockInputs[i2]]), avx512_loadp(&weights[i2 * lanes]), d);
+            e = avx512_fmadd(avx512_set1(inputs[blockInputs[i3]]), avx512_loadp(&weights[i3 * lanes]), e);
+        }
+        for (; i0 < end0; i0++)
+            a = avx512_fmadd(avx512_set1(inputs[blockInputs[i0]]), avx512_loadp(&weights[i0 * lanes]), a);
+        for (; i1 < end1; i1++)
+            b = avx512_fmadd(avx512_set1(inputs[blockInputs[i1]]), avx512_loadp(&weights[i1 * lanes]), b);
+        for (; i2 < end2; i2++)
+            d = avx512_fmadd(avx512_set1(inputs[blockInputs[i2]]), avx512_loadp(&weights[i2 * lanes]), d);
+        for (; i3 < end3; i3++)
+            e = avx512_fmadd(avx512_set1(inputs[blockInputs[i3]]), avx512_loadp(&weights[i3 * lanes]), e);
+
+        avx512_storeu(&outputs[c * lanes], a);
+        avx512_storeu(&outputs[(c + 1) * lanes], b);
+        avx512_storeu(&outputs[(c + 2) * lanes], d);
+        avx512_storeu(&outputs[(c + 3) * lanes], e);
+    }
+
+    for (; c < columnCount; c++)
+    {
+        Avx512Vector sum = avx512_loadp(&biases[c * lanes]);
+        for (int i = blockStart[c]; i < blockStart[c + 1]; i++)
+            sum = avx512_fmadd(avx512_set1(inputs[blockInputs[i]]), avx512_loadp(&weights[i * lanes]), sum);
+        avx512_storeu(&outputs[c * lanes], sum);
+    }
+}
+
+
+// ============================================================================
+// Fast tanh kernels, same steps as fast_tanh()
+// ============================================================================
+
+__attribute__((target("sse2")))
+static inline SseVector sse_tanh(SseVector x)
+{
+    const SseVector clamp = sse_set1((NeuralScalar)TANH_CLAMP);
+    x = sse_min(sse_max(x, sse_set1(-(NeuralScalar)TANH_CLAMP)), clamp);
+
+    const SseVector x2 = sse_mul(x, x);
+    SseVector p = sse_set1((NeuralScalar)TANH_A13);
+    p = sse_add(sse_mul(p, x2), sse_set1((NeuralScalar)TANH_A11));
+    p = sse_add(sse_mul(p, x2), sse_set1((NeuralScalar)TANH_A9));
+    p = sse_add(sse_mul(p, x2), sse_set1((NeuralScalar)TANH_A7));
+    p = sse_add(sse_mul(p, x2), sse_set1((NeuralScalar)TANH_A5));
+    p = sse_add(sse_mul(p, x2), sse_set1((NeuralScalar)TANH_A3));
+    p = sse_add(sse_mul(p, x2), sse_set1((NeuralScalar)TANH_A1));
+    SseVector q = sse_set1((NeuralScalar)TANH_B6);
+    q = sse_add(sse_mul(q, x2), sse_set1((NeuralScalar)TANH_B4));
+    q = sse_add(sse_mul(q, x2), sse_set1((NeuralScalar)TANH_B2));
+    q = sse_add(sse_mul(q, x2), sse_set1((NeuralScalar)TANH_B0));
+    return sse_div(sse_mul(x, p), q);
+}
+
+__attribute__((target("sse2")))
+KERNEL_INLINE void tanh_fast_sse2(NeuralScalar *values, int count)
+{
+    int i = 0;
+    for (; i + SSE_LANES <= count; i += SSE_LANES)
+        sse_storeu(&values[i], sse_tanh(sse_loadu(&values[i])));
+    for (; i < count; i++)
+        values[i] = fast_tanh(values[i]);
+}
+
+__attribute__((target(AVX2_TARGET)))
+static inline AvxVector avx_tanh(AvxVector x)
+{
+    const AvxVector clamp = avx_set1((NeuralScalar)TANH_CLAMP);
+    x = avx_min(avx_max(x, avx_set1(-(NeuralScalar)TANH_CLAMP)), clamp);
+
+    const AvxVector x2 = avx_mul(x, x);
+    AvxVector p = avx_set1((NeuralScalar)TANH_A13);
+    p = avx_fmadd(p, x2, avx_set1((NeuralScalar)TANH_A11));
+    p = avx_fmadd(p, x2, avx_set1((NeuralScalar)TANH_A9));
+    p = avx_fmadd(p, x2, avx_set1((NeuralScalar)TANH_A7));
+    p = avx_fmadd(p, x2, avx_set1((NeuralScalar)TANH_A5));
+    p = avx_fmadd(p, x2, avx_set1((NeuralScalar)TANH_A3));
+    p = avx_fmadd(p, x2, avx_set1((NeuralScalar)TANH_A1));
+    AvxVector q = avx_set1((NeuralScalar)TANH_B6);
+    q = avx_fmadd(q, x2, avx_set1((NeuralScalar)TANH_B4));
+    q = avx_fmadd(q, x2, avx_set1((NeuralScalar)TANH_B2));
+    q = avx_fmadd(q, x2, avx_set1((NeuralScalar)TANH_B0));
+    return avx_div(avx_mul(x, p), q);
+}
+
+__attribute__((target(AVX2_TARGET)))
+KERNEL_INLINE void tanh_fast_avx2(NeuralScalar *values, int count)
+{
+    int i = 0;
+    for (; i + AVX_LANES <= count; i += AVX_LANES)
+        avx_storeu(&values[i], avx_tanh(avx_loadu(&values[i])));
+    for (; i < count; i++)
+        values[i] = fast_tanh(values[i]);
+}
+
+__attribute__((target("avx512f")))
+static inline Avx512Vector avx512_tanh(Avx512Vector x)
+{
+    const Avx512Vector clamp = avx512_set1((NeuralScalar)TANH_CLAMP);
+    x = avx512_min(avx512_max(x, avx512_set1(-(NeuralScalar)TANH_CLAMP)), clamp);
+
+    const Avx512Vector x2 = avx512_mul(x, x);
+    Avx512Vector p = avx512_set1((NeuralScalar)TANH_A13);
+    p = avx512_fmadd(p, x2, avx512_set1((NeuralScalar)TANH_A11));
+    p = avx512_fmadd(p, x2, avx512_set1((NeuralScalar)TANH_A9));
+    p = avx512_fmadd(p, x2, avx512_set1((NeuralScalar)TANH_A7));
+    p = avx512_fmadd(p, x2, avx512_set1((NeuralScalar)TANH_A5));
+    p = avx512_fmadd(p, x2, avx512_set1((NeuralScalar)TANH_A3));
+    p = avx512_fmadd(p, x2, avx512_set1((NeuralScalar)TANH_A1));
+    Avx512Vector q = avx512_set1((NeuralScalar)TANH_B6);
+    q = avx512_fmadd(q, x2, avx512_set1((NeuralScalar)TANH_B4));
+    q = avx512_fmadd(q, x2, avx512_set1((NeuralScalar)TANH_B2));
+    q = avx512_fmadd(q, x2, avx512_set1((NeuralScalar)TANH_B0));
+    return avx512_div(avx512_mul(x, p), q);
+}
+
+__attribute__((target("avx512f")))
+KERNEL_INLINE void tanh_fast_avx512(NeuralScalar *values, int count)
+{
+    int i = 0;
+    for (; i + AVX512_LANES <= count; i += AVX512_LANES)
+        avx512_storeu(&values[i], avx512_tanh(avx512_loadu(&values[i])));
+    if (i < count)
+    {
+        const Avx512Mask mask = (Avx512Mask)((1u << (count - i)) - 1);
+        avx512_mask_storeu(&values[i], mask, avx512_tanh(avx512_maskz_loadu(mask, &values[i])));
+    }
+}
+
+#endif // CPU_HAS_X86_SIMD
+
+
+// ============================================================================
+// Whole layers, every row of the weights: the dispatch pointers
+// ============================================================================
+
+#define DEFINE_LAYER_KERNELS(target, suffix)                                                                    \
+    target KERNEL_INLINE void dense_##suffix(int n, int m, const NeuralParameter *weights,                       \
+                                             const NeuralParameter *biases, const NeuralScalar *inputs,          \
+                                             NeuralScalar *outputs)                                              \
+    {                                                                                                            \
+        dense_rows_##suffix(n, m, weights, biases, inputs, outputs, NULL);                                       \
+    }                                                                                                            \
+                                                                                                                 \
+    target KERNEL_INLINE void batch_##suffix(int n, int m, const NeuralParameter *weights,                       \
+                                             const NeuralParameter *biases, const NeuralScalar *inputs,          \
+                                             NeuralScalar *outputs)                                              \
+    {                                                                                                            \
+        batch_rows_##suffix(n, m, weights, biases, inputs, outputs, NULL, n);                                    \
+    }
+
+DEFINE_LAYER_KERNELS(, scalar)
+#if CPU_HAS_X86_SIMD
+DEFINE_LAYER_KERNELS(__attribute__((target("sse2"))), sse2)
+DEFINE_LAYER_KERNELS(__attribute__((target(AVX2_TARGET))), avx2)
+DEFINE_LAYER_KERNELS(__attribute__((target("avx512f"))), avx512)
+#endif
+
+
+// ============================================================================
+// Fixed topology passes: the layer loop is fully unrolled, so each layer
+// inlines its kernel and activation with constant sizes. Given a list of
+// rows (the non-zero inputs), the first layer only accumulates those.
+// ============================================================================
+
+static const int g_fixedTopology[] = NEURAL_NETWORK_TOPOLOGY;
+#define FIXED_LAYER_COUNT ((int)(sizeof(g_fixedTopology) / sizeof(g_fixedTopology[0])) - 1)
+
+#define DEFINE_FIXED_FORWARDS(target, suffix, dense, batch, fastTanh)                                          \
+    target static void forward_fixed_##suffix(const NeuralLayer *layers, const NeuralScalar *inputs,             \
+                                              const uint8_t *rows, int rowCount,                                 \
+                                              NeuralScalar *outputs, NeuralScalar *const *buffers)               \
+    {                                                                                                            \
+        const NeuralScalar *current = inputs;                                                                    \
+        _Pragma("GCC unroll 16")                                                                                 \
+        for (int i = 0; i < FIXED_LAYER_COUNT; i++)                                                              \
+        {                                                                                                        \
+            const int m = g_fixedTopology[i + 1];                                                                \
+            NeuralScalar *next = i == FIXED_LAYER_COUNT - 1 ? outputs : buffers[i & 1];                          \
+            if (i == 0 && rows != NULL)                                                                          \
+                dense(rowCount, m, layers[i].weights, layers[i].biases, current, next, rows);                   \
+            else                                                                                                 \
+                dense(g_fixedTopology[i], m, layers[i].weights, layers[i].biases, current, next, NULL);         \
+            if (g_activation == NEURAL_ACTIVATION_EXACT)                                                         \
+                tanh_exact(next, m);                                                                             \
+            else                                                                                                 \
+                fastTanh(next, m);                                                                               \
+            current = next;                                                                                      \
+        }                                                                                                        \
+    }                                                                                                            \
+                                                                                                                 \
+    target static const NeuralScalar *batch_forward_fixed_##suffix(const NeuralParameter *parameters,           \
+                                                                   const uint8_t *rows, int rowCount,            \
+                                                                   NeuralScalar *const *buffers)                 \
+    {                                                                                                            \
+        const int lanes = NEURAL_BATCH_LANES;                                                                    \
+        const NeuralScalar *current = buffers[0];                                                                \
+        _Pragma("GCC unroll 16")                                                                                 \
+        for (int i = 0; i < FIXED_LAYER_COUNT; i++)                                                              \
+        {                                                                                                        \
+            const int n = g_fixedTopology[i];                                                                    \
+            const int m = g_fixedTopology[i + 1];                                                                \
+            NeuralScalar *next = buffers[(i + 1) & 1];                                                           \
+            if (i == 0 && rows != NULL)                                                                          \
+                batch(n, m, parameters, parameters + n * m * lanes, current, next, rows, rowCount);              \
+            else                                                                                                 \
+                batch(n, m, parameters, parameters + n * m * lanes, current, next, NULL, n);                     \
+            if (g_activation == NEURAL_ACTIVATION_EXACT)                                                         \
+                tanh_exact(next, m * lanes);                                                                     \
+            else                                                                                                 \
+                fastTanh(next, m * lanes);                                                                       \
+            parameters += (n + 1) * m * lanes;                                                                   \
+            current = next;                                                                                      \
+        }                                                                                                        \
+        return current;                                                                                          \
+    }
+
+DEFINE_FIXED_FORWARDS(, scalar, dense_rows_scalar, batch_rows_scalar, tanh_fast_scalar)
+#if CPU_HAS_X86_SIMD
+DEFINE_FIXED_FORWARDS(__attribute__((target("sse2"))), sse2, dense_rows_sse2, batch_rows_sse2, tanh_fast_sse2)
+DEFINE_FIXED_FORWARDS(__attribute__((target(AVX2_TARGET))), avx2, dense_rows_avx2, batch_rows_avx2, tanh_fast_avx2)
+DEFINE_FIXED_FORWARDS(__attribute__((target("avx512f"))), avx512, dense_rows_avx512, batch_rows_avx512, tanh_fast_avx512)
+#endif
+
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+NeuralKernel NeuralNetwork_SelectKernel(NeuralKernel maxKernel)
+{
+    g_dense = dense_scalar;
+    g_batch = batch_scalar;
+    g_pruned = pruned_scalar;
+    g_fastTanh = tanh_fast_scalar;
+    g_forwardFixed = forward_fixed_scalar;
+    g_batchForwardFixed = batch_forward_fixed_scalar;
+    g_kernel = NEURAL_KERNEL_SCALAR;
+
+#if CPU_HAS_X86_SIMD
+    const CpuFeatures *features = CpuFeatures_Get();
+    if (maxKernel >= NEURAL_KERNEL_AVX512 && features->avx512f) {
+        g_dense = dense_avx512;
+        g_batch = batch_avx512;
+        g_pruned = pruned_avx512;
+        g_fastTanh = tanh_fast_avx512;
+        g_forwardFixed = forward_fixed_avx512;
+        g_batchForwardFixed = batch_forward_fixed_avx512;
+        g_kernel = NEURAL_KERNEL_AVX512;
+    } else if (maxKernel >= NEURAL_KERNEL_AVX2 && features->avx2 && features->fma
+               && (features->f16c || !AVX2_NEEDS_F16C)) {
+        g_dense = dense_avx2;
+        g_batch = batch_avx2;
+        g_pruned = pruned_avx2;
+        g_fastTanh = tanh_fast_avx2;
+        g_forwardFixed = forward_fixed_avx2;
+        g_batchForwardFixed = batch_forward_fixed_avx2;
+        g_kernel = NEURAL_KERNEL_AVX2;
+    } else if (maxKernel >= NEURAL_KERNEL_SSE2 && features->sse2) {
+        g_dense = dense_sse2;
+        g_batch = batch_sse2;
+        g_pruned = pruned_sse2;
+        g_fastTanh = tanh_fast_sse2;
+        g_forwardFixed = forward_fixed_sse2;
+        g_batchForwardFixed = batch_forward_fixed_sse2;
+        g_kernel = NEURAL_KERNEL_SSE2;
+    }
+#else
+    (void)maxKernel;
+#endif
+
+    return g_kernel;
+}
+
+NeuralKernel NeuralNetwork_ActiveKernel(void)
+{
+    if (g_dense == NULL)
+        NeuralNetwork_SelectKernel(NEURAL_KERNEL_COUNT - 1);
+    return g_kernel;
+}
+
+const char *NeuralNetwork_KernelName(NeuralKernel kernel)
+{
+    if ((unsigned int)kernel >= NEURAL_KERNEL_COUNT)
+        return "unknown";
+    return g_kernelNames[kernel];
+}
+
+void NeuralNetwork_DenseLayer(const NeuralLayer *layer, const NeuralScalar *inputs, NeuralScalar *outputs)
+{
+    if (g_dense == NULL)
+        NeuralNetwork_SelectKernel(NEURAL_KERNEL_COUNT - 1);
+
+    g_dense(layer->neuronCount, layer->nextLayerNeuronCount, layer->weights, layer->biases, inputs, outputs);
+    NeuralNetwork_Activate(outputs, layer->nextLayerNeuronCount);
+}
+
+// Scalar kernel whatever the selection: the reference the others are checked against
+void NeuralNetwork_DenseLayerReference(const NeuralLayer *layer, const NeuralScalar *inputs, NeuralScalar *outputs)
+{
+    dense_scalar(layer->neuronCount, layer->nextLayerNeuronCount, layer->weights, layer->biases, inputs, outputs);
+    if (g_activation == NEURAL_ACTIVATION_EXACT)
+        tanh_exact(outputs, layer->nextLayerNeuronCount);
+    else
+        tanh_fast_scalar(outputs, layer->nextLayerNeuronCount);
+}
+
+bool NeuralNetwork_IsFixedTopology(const int *topology, int topologySize)
+{
+    if (topologySize != FIXED_LAYER_COUNT + 1)
+        return false;
+    return memcmp(topology, g_fixedTopology, sizeof(g_fixedTopology)) == 0;
+}
+
+void NeuralNetwork_ForwardFixed(const NeuralNetwork *nn, const NeuralScalar *inputs, NeuralScalar *outputs,
+                                NeuralWorkspace *workspace)
+{
+    if (g_forwardFixed == NULL)
+        NeuralNetwork_SelectKernel(NEURAL_KERNEL_COUNT - 1);
+    g_forwardFixed(nn->layers, inputs, NULL, 0, outputs, workspace->buffers);
+}
+
+void NeuralNetwork_ForwardFixedSparse(const NeuralNetwork *nn, const NeuralScalar *inputs, const uint8_t *activeInputs,
+                                      int activeCount, NeuralScalar *outputs, NeuralWorkspace *workspace)
+{
+    if (g_forwardFixed == NULL)
+        NeuralNetwork_SelectKernel(NEURAL_KERNEL_COUNT - 1);
+    g_forwardFixed(nn->layers, inputs, activeInputs, activeCount, outputs, workspace->buffers);
+}
+
+void NeuralNetwork_ForwardFixedReference(const NeuralNetwork *nn, const NeuralScalar *inputs, NeuralScalar *outputs,
+                                         NeuralWorkspace *workspace)
+{
+    forward_fixed_scalar(nn->layers, inputs, NULL, 0, outputs, workspace->buffers);
+}
+
+const NeuralScalar *NeuralNetwork_BatchForwardFixed(const NeuralParameter *parameters, const uint8_t *activeInputs,
+                                                    int activeCount, NeuralWorkspace *workspace)
+{
+    if (g_batchForwardFixed == NULL)
+        NeuralNetwork_SelectKernel(NEURAL_KERNEL_COUNT - 1);
+    return g_batchForwardFixed(parameters, activeInputs, activeCount, workspace->buffers);
+}
+
+int NeuralNetwork_ActiveInputs(const NeuralScalar *inputs, int count, uint8_t *activeInputs)
+{
+    int activeCount = 0;
+    for (int k = 0; k < count; k++)
+    {
+        activeInputs[activeCount] = (uint8_t)k;
+        activeCount += inputs[k] != 0;
+    }
+    return activeCount;
+}
+
+void NeuralNetwork_BatchLayer(int neuronCount, int nextLayerNeuronCount, const NeuralParameter *weights,
+                              const NeuralParameter *biases, const NeuralScalar *inputs, NeuralScalar *outputs)
+{
+    if (g_batch == NULL)
+        NeuralNetwork_SelectKernel(NEURAL_KERNEL_COUNT - 1);
+
+    g_batch(neuronCount, nextLayerNeuronCount, weights, biases, inputs, outputs);
+    NeuralNetwork_Activate(outputs, nextLayerNeuronCount * NEURAL_BATCH_LANES);
+}
+
+void NeuralNetwork_PrunedLayer(int nextLayerNeuronCount, const int32_t *blockStart,
+                               const uint16_t *blockInputs, const NeuralParameter *weights,
+                               const NeuralParameter *biases, const NeuralScalar *inputs, NeuralScalar *outputs)
+{
+    if (g_pruned == NULL)
+        NeuralNetwork_SelectKernel(NEURAL_KERNEL_COUNT - 1);
+
+    g_pruned(nextLayerNeuronCount, blockStart, blockInputs, weights, biases, inputs, outputs);
+    NeuralNetwork_Activate(outputs, nextLayerNeuronCount);
+}
+
+void NeuralNetwork_SetActivation(NeuralActivation activation)
+{
+    if ((unsigned int)activation < NEURAL_ACTIVATION_COUNT)
+        g_activation = activation;
+}
+
+NeuralActivation NeuralNetwork_ActiveActivation(void)
+{
+    return g_activation;
+}
+
+const char *NeuralNetwork_ActivationName(NeuralActivation activation)
+{
+    if ((unsigned int)activation >= NEURAL_ACTIVATION_COUNT)
+        return "unknown";
+    return g_activationNames[activation];
+}
+
+NeuralScalar NeuralNetwork_FastTanh(NeuralScalar x)
+{
+    return fast_tanh(x);
+}
+
+void NeuralNetwork_Activate(NeuralScalar *values, int count)
+{
+    if (g_activation == NEURAL_ACTIVATION_EXACT)
+    {
+        tanh_exact(values, count);
+        return;
+    }
+
+    if (g_fastTanh == NULL)
+        NeuralNetwork_SelectKernel(NEURAL_KERNEL_COUNT - 1);
+    g_fastTanh(values, count);
+}
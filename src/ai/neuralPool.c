@@ -0,0 +1,225 @@
+/**
+ * @file neuralPool.c
+ * @brief Implementation of the network slab allocator
+ */
+
+#include "../../include/ai/neuralNetwork.h"
+#include "../../include/ai/neuralPool.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool NeuralPool_Init(NeuralPool *pool, const int *topology, int topologySize)
+{
+    memset(pool, 0, sizeof(NeuralPool));
+
+    pool->topology = malloc(topologySize * sizeof(int));
+    if (pool->topology == NULL)
+    {
+        fprintf(stderr, "Failed to allocate memory for NeuralPool !\n");
+        return false;
+    }
+    memcpy(pool->topology, topology, topologySize * sizeof(int));
+    pool->topologySize = topologySize;
+
+    // The block header takes one alignment unit, the parameters follow
+    pool->parameterCount = NeuralNetwork_ParameterCount(topology, topologySize);
+    pool->blockSize = NEURAL_NETWORK_ALIGNMENT + pool->parameterCount * sizeof(NeuralParameter);
+
+    return true;
+}
+
+void NeuralPool_Free(NeuralPool *pool)
+{
+    for (int i = 0; i < pool->networkCount; i++)
+    {
+        free(pool->networks[i]->deltas);
+        free(pool->networks[i]);
+    }
+    for (int i = 0; i < pool->slabCount; i++)
+        Utils_alignedFree(pool->slabs[i]);
+    free(pool->networks);
+    free(pool->freeNetworks);
+    free(pool->slabs);
+    free(pool->freeBlocks);
+    free(pool->topology);
+    memset(pool, 0, sizeof(NeuralPool));
+}
+
+static NeuralParameter *block_parameters(NeuralBlock *block)
+{
+    return (NeuralParameter *)((char *)block + NEURAL_NETWORK_ALIGNMENT);
+}
+
+// Lay out a new slab once, its blocks go to the free list
+static bool add_slab(NeuralPool *pool)
+{
+    int capacity = (pool->slabCount + 1) * NEURAL_POOL_SLAB_BLOCKS;
+    char **slabs = realloc(pool->slabs, (pool->slabCount + 1) * sizeof(char *));
+    if (slabs == NULL)
+        return false;
+    pool->slabs = slabs;
+
+    NeuralBlock **freeBlocks = realloc(pool->freeBlocks, capacity * sizeof(NeuralBlock *));
+    if (freeBlocks == NULL)
+        return false;
+    pool->freeBlocks = freeBlocks;
+
+    size_t slabSize = pool->blockSize * NEURAL_POOL_SLAB_BLOCKS;
+    char *slab = Utils_alignedAlloc(NEURAL_NETWORK_ALIGNMENT, slabSize);
+    if (slab == NULL)
+        return false;
+    memset(slab, 0, slabSize);
+    pool->slabs[pool->slabCount++] = slab;
+
+    // Pushed backwards so the blocks are handed out in address order
+    for (int b = NEURAL_POOL_SLAB_BLOCKS - 1; b >= 0; b--)
+        pool->freeBlocks[pool->freeBlockCount++] = (NeuralBlock *)(slab + b * pool->blockSize);
+
+    return true;
+}
+
+static NeuralBlock *acquire_block(NeuralPool *pool)
+{
+    if (pool->freeBlockCount == 0 && !add_slab(pool))
+    {
+        fprintf(stderr, "Failed to allocate memory for NeuralPool slab !\n");
+        return NULL;
+    }
+
+    NeuralBlock *block = pool->freeBlocks[--pool->freeBlockCount];
+    block->refCount = 1;
+    pool->usedBlockCount++;
+    return block;
+}
+
+static void release_block(NeuralPool *pool, NeuralBlock *block)
+{
+    if (--block->refCount > 0)
+        return;
+    pool->usedBlockCount--;
+    pool->freeBlocks[pool->freeBlockCount++] = block;
+}
+
+static void bind_block(NeuralNetwork *nn, NeuralBlock *block)
+{
+    nn->block = block;
+    NeuralNetwork_BindParameters(nn, block_parameters(block));
+}
+
+// A header without a block, made once and recycled afterwards
+static NeuralNetwork *acquire_network(NeuralPool *pool)
+{
+    if (pool->freeCount == 0)
+    {
+        NeuralNetwork **networks = realloc(pool->networks, (pool->networkCount + 1) * sizeof(NeuralNetwork *));
+        if (networks == NULL)
+            return NULL;
+        pool->networks = networks;
+
+        NeuralNetwork **freeNetworks = realloc(pool->freeNetworks, (pool->networkCount + 1) * sizeof(NeuralNetwork *));
+        if (freeNetworks == NULL)
+            return NULL;
+        pool->freeNetworks = freeNetworks;
+
+        void *header = calloc(1, NeuralNetwork_HeaderSize(pool->topologySize));
+        if (header == NULL)
+            return NULL;
+        NeuralNetwork *nn = NeuralNetwork_InitHeader(header, pool->topology, pool->topologySize);
+        nn->pool = pool;
+        pool->networks[pool->networkCount++] = nn;
+        pool->freeNetworks[pool->freeCount++] = nn;
+    }
+
+    pool->usedCount++;
+    return pool->freeNetworks[--pool->freeCount];
+}
+
+static void release_network(NeuralPool *pool, NeuralNetwork *nn)
+{
+    pool->usedCount--;
+    pool->freeNetworks[pool->freeCount++] = nn;
+}
+
+NeuralNetwork *NeuralPool_Acquire(NeuralPool *pool)
+{
+    NeuralNetwork *nn = acquire_network(pool);
+    if (nn == NULL)
+    {
+        fprintf(stderr, "Failed to allocate memory for NeuralPool network !\n");
+        return NULL;
+    }
+
+    NeuralBlock *block = acquire_block(pool);
+    if (block == NULL)
+    {
+        release_network(pool, nn);
+        return NULL;
+    }
+    bind_block(nn, block);
+    return nn;
+}
+
+NeuralNetwork *NeuralPool_Clone(NeuralPool *pool, const NeuralNetwork *source)
+{
+    NeuralNetwork *nn = acquire_network(pool);
+    if (nn == NULL)
+    {
+        fprintf(stderr, "Failed to allocate memory for NeuralPool network !\n");
+        return NULL;
+    }
+
+    if (!NeuralPool_Share(nn, source))
+    {
+        release_network(pool, nn);
+        return NULL;
+    }
+    return nn;
+}
+
+bool NeuralPool_Share(NeuralNetwork *nn, const NeuralNetwork *source)
+{
+    if (nn == source)
+        return true;
+    if (!NeuralNetwork_ReserveDeltas(nn, source->deltaCount))
+        return false;
+
+    // Taken before the release, the blocks may be the same
+    source->block->refCount++;
+    if (nn->block != NULL)
+        release_block(nn->pool, nn->block);
+    bind_block(nn, source->block);
+
+    if (source->deltaCount > 0)
+        memcpy(nn->deltas, source->deltas, source->deltaCount * sizeof(NeuralDelta));
+    nn->deltaCount = source->deltaCount;
+    return true;
+}
+
+bool NeuralPool_Detach(NeuralNetwork *nn, bool keepValues)
+{
+    if (nn->block->refCount > 1)
+    {
+        NeuralBlock *block = acquire_block(nn->pool);
+        if (block == NULL)
+            return false;
+
+        if (keepValues)
+            memcpy(block_parameters(block), nn->parameters, nn->parameterCount * sizeof(NeuralParameter));
+        release_block(nn->pool, nn->block);
+        bind_block(nn, block);
+    }
+
+    if (keepValues)
+        NeuralNetwork_ApplyDeltas(nn, nn->parameters);
+    nn->deltaCount = 0;
+    return true;
+}
+
+void NeuralPool_Release(NeuralPool *pool, NeuralNetwork *nn)
+{
+    release_block(pool, nn->block);
+    nn->block = NULL;
+    nn->parameters = NULL;
+    nn->deltaCount = 0;
+    release_network(pool, nn);
+}
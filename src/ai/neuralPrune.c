@@ -0,0 +1,281 @@
+/**
+ * @file neuralPrune.c
+ * @brief Implementation of the pruned networks (kernels in neuralNetwork_kernels.c)
+ */
+
+#include "../../include/ai/neuralNetwork.h"
+#include "../../include/ai/neuralPrune.h"
+#include "../../include/system/performance.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int round_up(int value, int multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+// Offsets of the arrays of each layer for the current fraction, every array
+// on NEURAL_NETWORK_ALIGNMENT
+static void layout(NeuralPrune *prune)
+{
+    size_t offset = 0;
+    prune->maxWidth = 0;
+
+    for (int i = 0; i < prune->topologySize - 1; i++)
+    {
+        NeuralPruneLayer *layer = &prune->layers[i];
+        layer->inputCount = prune->topology[i];
+        layer->outputCount = prune->topology[i + 1];
+        layer->columnCount = round_up(layer->outputCount, NEURAL_PRUNE_BLOCK) / NEURAL_PRUNE_BLOCK;
+
+        int total = layer->columnCount * layer->inputCount;
+        layer->blockCount = MAX(1, total - (int)(prune->fraction * total));
+
+        layer->startOffset = offset;
+        offset += round_up((layer->columnCount + 1) * sizeof(int32_t), NEURAL_NETWORK_ALIGNMENT);
+        layer->inputOffset = offset;
+        offset += round_up(layer->blockCount * sizeof(uint16_t), NEURAL_NETWORK_ALIGNMENT);
+        layer->biasOffset = offset;
+        offset += round_up(layer->columnCount * NEURAL_PRUNE_BLOCK * sizeof(NeuralParameter), NEURAL_NETWORK_ALIGNMENT);
+        layer->weightOffset = offset;
+        offset += round_up(layer->blockCount * NEURAL_PRUNE_BLOCK * sizeof(NeuralParameter), NEURAL_NETWORK_ALIGNMENT);
+
+        prune->maxWidth = MAX(prune->maxWidth, layer->inputCount);
+        prune->maxWidth = MAX(prune->maxWidth, layer->columnCount * NEURAL_PRUNE_BLOCK);
+    }
+    prune->networkSize = offset;
+}
+
+// Pruning every block would leave a layer without weights
+static bool valid_fraction(double fraction)
+{
+    if (fraction >= 0.0 && fraction < 1.0)
+        return true;
+    fprintf(stderr, "Invalid share of pruned weights %g, it must be in [0, 1) !\n", fraction);
+    return false;
+}
+
+bool NeuralPrune_Init(NeuralPrune *prune, const int *topology, int topologySize, int slotCapacity, double fraction)
+{
+    memset(prune, 0, sizeof(NeuralPrune));
+    if (!valid_fraction(fraction))
+        return false;
+
+    for (int i = 0; i < topologySize - 1; i++)
+    {
+        int columnCount = round_up(topology[i + 1], NEURAL_PRUNE_BLOCK) / NEURAL_PRUNE_BLOCK;
+        prune->rankCapacity = MAX(prune->rankCapacity, columnCount * topology[i]);
+    }
+
+    prune->topology = malloc(topologySize * sizeof(int));
+    prune->layers = malloc((topologySize - 1) * sizeof(NeuralPruneLayer));
+    prune->slotCapacity = slotCapacity;
+    prune->networks = calloc(slotCapacity, sizeof(char *));
+    prune->packed = calloc(slotCapacity, sizeof(bool));
+    prune->scratchCount = NeuralNetwork_ParameterCount(topology, topologySize);
+    prune->scratch = malloc(prune->scratchCount * sizeof(NeuralParameter));
+    prune->ranks = malloc(prune->rankCapacity * sizeof(NeuralPruneRank));
+    if (prune->topology == NULL || prune->layers == NULL || prune->networks == NULL || prune->packed == NULL ||
+        prune->scratch == NULL || prune->ranks == NULL)
+    {
+        fprintf(stderr, "Failed to allocate memory for NeuralPrune !\n");
+        NeuralPrune_Free(prune);
+        return false;
+    }
+
+    memcpy(prune->topology, topology, topologySize * sizeof(int));
+    prune->topologySize = topologySize;
+    prune->fraction = fraction;
+    layout(prune);
+    return true;
+}
+
+void NeuralPrune_Free(NeuralPrune *prune)
+{
+    if (prune->networks != NULL)
+    {
+        for (int slot = 0; slot < prune->slotCapacity; slot++)
+            Utils_alignedFree(prune->networks[slot]);
+    }
+    free(prune->networks);
+    free(prune->packed);
+    free(prune->scratch);
+    free(prune->ranks);
+    free(prune->layers);
+    free(prune->topology);
+    memset(prune, 0, sizeof(NeuralPrune));
+}
+
+bool NeuralPrune_SetFraction(NeuralPrune *prune, double fraction)
+{
+    if (!valid_fraction(fraction))
+        return false;
+    if (fraction == prune->fraction)
+        return true;
+
+    // Networks of the old size: reallocated on their next pack
+    for (int slot = 0; slot < prune->slotCapacity; slot++)
+    {
+        Utils_alignedFree(prune->networks[slot]);
+        prune->networks[slot] = NULL;
+        prune->packed[slot] = false;
+    }
+    prune->fraction = fraction;
+    layout(prune);
+    return true;
+}
+
+static bool same_shape(const NeuralPrune *prune, const NeuralNetwork *nn)
+{
+    if (nn->topologySize != prune->topologySize)
+        return false;
+    return memcmp(nn->topology, prune->topology, prune->topologySize * sizeof(int)) == 0;
+}
+
+// Largest norm first, ties by position so the blocks kept do not depend on qsort
+static int compare_norm(const void *a, const void *b)
+{
+    const NeuralPruneRank *left = a;
+    const NeuralPruneRank *right = b;
+    if (left->norm != right->norm)
+        return left->norm < right->norm ? 1 : -1;
+    return left->block - right->block;
+}
+
+static int compare_block(const void *a, const void *b)
+{
+    return ((const NeuralPruneRank *)a)->block - ((const NeuralPruneRank *)b)->block;
+}
+
+bool NeuralPrune_Pack(NeuralPrune *prune, int slot, const NeuralNetwork *nn)
+{
+    if (nn == NULL || !same_shape(prune, nn) || nn->parameterCount > prune->scratchCount)
+    {
+        NeuralPrune_Release(prune, slot);
+        return false;
+    }
+
+    if (prune->networks[slot] == NULL)
+    {
+        prune->networks[slot] = Utils_alignedAlloc(NEURAL_NETWORK_ALIGNMENT, prune->networkSize);
+        if (prune->networks[slot] == NULL)
+        {
+            fprintf(stderr, "Failed to allocate memory for NeuralPrune network !\n");
+            return false;
+        }
+        // Alignment padding between the arrays stays at zero
+        memset(prune->networks[slot], 0, prune->networkSize);
+    }
+
+    // Values of the genome, its deltas included
+    memcpy(prune->scratch, nn->parameters, nn->parameterCount * sizeof(NeuralParameter));
+    NeuralNetwork_ApplyDeltas(nn, prune->scratch);
+
+    char *network = prune->networks[slot];
+    for (int i = 0; i < prune->topologySize - 1; i++)
+    {
+        const NeuralPruneLayer *layer = &prune->layers[i];
+        const NeuralParameter *weights = prune->scratch + (nn->layers[i].weights - nn->parameters);
+        const NeuralParameter *biases = prune->scratch + (nn->layers[i].biases - nn->parameters);
+        int32_t *blockStart = (int32_t *)(network + layer->startOffset);
+        uint16_t *blockInputs = (uint16_t *)(network + layer->inputOffset);
+        NeuralParameter *prunedBiases = (NeuralParameter *)(network + layer->biasOffset);
+        NeuralParameter *prunedWeights = (NeuralParameter *)(network + layer->weightOffset);
+        const int n = layer->inputCount;
+        const int m = layer->outputCount;
+        const int columns = layer->columnCount;
+
+        // Rank the blocks by norm, then keep the largest ones by output block and input
+        for (int c = 0; c < columns; c++)
+        {
+            for (int k = 0; k < n; k++)
+            {
+                double norm = 0.0;
+                for (int j = c * NEURAL_PRUNE_BLOCK; j < MIN(m, (c + 1) * NEURAL_PRUNE_BLOCK); j++)
+                {
+                    double w = NeuralParameter_Load(weights[k * m + j]);
+                    norm += w * w;
+                }
+                prune->ranks[c * n + k] = (NeuralPruneRank) { norm, c * n + k };
+            }
+        }
+        qsort(prune->ranks, columns * n, sizeof(NeuralPruneRank), compare_norm);
+        qsort(prune->ranks, layer->blockCount, sizeof(NeuralPruneRank), compare_block);
+
+        int b = 0;
+        for (int c = 0; c < columns; c++)
+        {
+            blockStart[c] = b;
+            for (; b < layer->blockCount && prune->ranks[b].block / n == c; b++)
+            {
+                int k = prune->ranks[b].block % n;
+                blockInputs[b] = (uint16_t)k;
+                for (int l = 0; l < NEURAL_PRUNE_BLOCK; l++)
+                {
+                    int j = c * NEURAL_PRUNE_BLOCK + l;
+                    prunedWeights[b * NEURAL_PRUNE_BLOCK + l] = j < m ? weights[k * m + j] : (NeuralParameter)0;
+                }
+            }
+        }
+        blockStart[columns] = b;
+
+        for (int j = 0; j < columns * NEURAL_PRUNE_BLOCK; j++)
+            prunedBiases[j] = j < m ? biases[j] : (NeuralParameter)0;
+    }
+
+    prune->packed[slot] = true;
+    return true;
+}
+
+void NeuralPrune_Release(NeuralPrune *prune, int slot)
+{
+    prune->packed[slot] = false;
+}
+
+bool NeuralPrune_IsPacked(const NeuralPrune *prune, int slot)
+{
+    return prune->packed[slot];
+}
+
+int NeuralPrune_KeptWeights(const NeuralPrune *prune)
+{
+    int count = 0;
+    for (int i = 0; i < prune->topologySize - 1; i++)
+        count += prune->layers[i].blockCount * NEURAL_PRUNE_BLOCK;
+    return count;
+}
+
+int NeuralPrune_WorkspaceSize(const NeuralPrune *prune)
+{
+    return prune->maxWidth;
+}
+
+void NeuralPrune_Forward(const NeuralPrune *prune, int slot, const NeuralScalar *inputs, NeuralScalar *outputs,
+                         NeuralWorkspace *workspace)
+{
+    const int layerCount = prune->topologySize - 1;
+
+    if (!prune->packed[slot] || !NeuralWorkspace_Reserve(workspace, NeuralPrune_WorkspaceSize(prune)))
+    {
+        memset(outputs, 0, prune->topology[layerCount] * sizeof(NeuralScalar));
+        return;
+    }
+
+    PERF_MEASURE(PERF_NEURAL_NETWORK) {
+        const char *network = prune->networks[slot];
+        const NeuralScalar *current = inputs;
+
+        // Padded outputs stay at zero, the next layer has no block for them
+        for (int i = 0; i < layerCount; i++)
+        {
+            const NeuralPruneLayer *layer = &prune->layers[i];
+            NeuralScalar *next = workspace->buffers[i & 1];
+            NeuralNetwork_PrunedLayer(layer->outputCount, (const int32_t *)(network + layer->startOffset),
+                                      (const uint16_t *)(network + layer->inputOffset),
+                                      (const NeuralParameter *)(network + layer->weightOffset),
+                                      (const NeuralParameter *)(network + layer->biasOffset), current, next);
+            current = next;
+        }
+        memcpy(outputs, current, prune->topology[layerCount] * sizeof(NeuralScalar));
+    } // PERF_MEASURE
+}
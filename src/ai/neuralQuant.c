@@ -0,0 +1,435 @@
+/**
+ * @file neuralQuant.c
+ * @brief Implementation of the int8 networks and their layer kernels
+ */
+
+#include "../../include/ai/neuralNetwork.h"
+#include "../../include/ai/neuralQuant.h"
+#include "../../include/system/cpu_features.h"
+#include "../../include/system/performance.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if CPU_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+// acc[j] = biases[j] + sum_k codes[k] * weights[k / 4][j][k % 4], for every padded output
+typedef void (*QuantKernel)(const int8_t *weights, const int32_t *biases, const uint8_t *codes,
+                            int groupCount, int paddedOutputs, int32_t *acc);
+
+#define TANH_CENTER (NEURAL_QUANT_TANH_RANGE * NEURAL_QUANT_TANH_RESOLUTION)
+
+static QuantKernel g_layer = NULL;
+static NeuralQuantKernel g_kernel = NEURAL_QUANT_KERNEL_SCALAR;
+static uint8_t g_tanhCodes[2 * TANH_CENTER + 1];   // Code of tanh((i - TANH_CENTER) / NEURAL_QUANT_TANH_RESOLUTION)
+static bool g_tanhReady = false;
+
+static const char *const g_kernelNames[NEURAL_QUANT_KERNEL_COUNT] = { "scalar", "avx2", "avx512-vnni" };
+
+
+// ============================================================================
+// Layer kernels
+// ============================================================================
+
+static void layer_scalar(const int8_t *weights, const int32_t *biases, const uint8_t *codes,
+                         int groupCount, int paddedOutputs, int32_t *acc)
+{
+    // Group by group, so the weights are read in order
+    memcpy(acc, biases, paddedOutputs * sizeof(int32_t));
+    for (int g = 0; g < groupCount; g++)
+    {
+        const int8_t *w = &weights[g * paddedOutputs * NEURAL_QUANT_GROUP];
+        const uint8_t *x = &codes[g * NEURAL_QUANT_GROUP];
+        for (int j = 0; j < paddedOutputs; j++, w += NEURAL_QUANT_GROUP)
+            acc[j] += w[0] * x[0] + w[1] * x[1] + w[2] * x[2] + w[3] * x[3];
+    }
+}
+
+#if CPU_HAS_X86_SIMD
+
+// The 4 codes of a group, for a broadcast
+static inline int32_t group_codes(const uint8_t *codes, int group)
+{
+    int32_t value;
+    memcpy(&value, &codes[group * NEURAL_QUANT_GROUP], sizeof(value));
+    return value;
+}
+
+// maddubs sums pairs of u8 * s8 products into int16 (at most 2 * 127 * 127, no
+// saturation with 7-bit codes), madd by ones sums the pairs into int32
+__attribute__((target("avx2")))
+static inline __m256i avx2_dot(__m256i acc, __m256i x, const int8_t *w)
+{
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i pairs = _mm256_maddubs_epi16(x, _mm256_loadu_si256((const __m256i *)w));
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, ones));
+}
+
+// 4 vectors of 8 outputs per block, then one vector at a time
+__attribute__((target("avx2")))
+static void layer_avx2(const int8_t *weights, const int32_t *biases, const uint8_t *codes,
+                       int groupCount, int paddedOutputs, int32_t *acc)
+{
+    const int stride = paddedOutputs * NEURAL_QUANT_GROUP;
+    int j = 0;
+
+    for (; j + 32 <= paddedOutputs; j += 32)
+    {
+        __m256i a0 = _mm256_loadu_si256((const __m256i *)&biases[j]);
+        __m256i a1 = _mm256_loadu_si256((const __m256i *)&biases[j + 8]);
+        __m256i a2 = _mm256_loadu_si256((const __m256i *)&biases[j + 16]);
+        __m256i a3 = _mm256_loadu_si256((const __m256i *)&biases[j + 24]);
+
+        for (int g = 0; g < groupCount; g++)
+        {
+            const __m256i x = _mm256_set1_epi32(group_codes(codes, g));
+            const int8_t *w = &weights[g * stride + j * NEURAL_QUANT_GROUP];
+            a0 = avx2_dot(a0, x, w);
+            a1 = avx2_dot(a1, x, w + 32);
+            a2 = avx2_dot(a2, x, w + 64);
+            a3 = avx2_dot(a3, x, w + 96);
+        }
+
+        _mm256_storeu_si256((__m256i *)&acc[j], a0);
+        _mm256_storeu_si256((__m256i *)&acc[j + 8], a1);
+        _mm256_storeu_si256((__m256i *)&acc[j + 16], a2);
+        _mm256_storeu_si256((__m256i *)&acc[j + 24], a3);
+    }
+
+    for (; j < paddedOutputs; j += 8)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)&biases[j]);
+        for (int g = 0; g < groupCount; g++)
+            a = avx2_dot(a, _mm256_set1_epi32(group_codes(codes, g)), &weights[g * stride + j * NEURAL_QUANT_GROUP]);
+        _mm256_storeu_si256((__m256i *)&acc[j], a);
+    }
+}
+
+// 4 vectors of 16 outputs per block, then one vector at a time
+__attribute__((target("avx512f,avx512vnni")))
+static void layer_avx512_vnni(const int8_t *weights, const int32_t *biases, const uint8_t *codes,
+                              int groupCount, int paddedOutputs, int32_t *acc)
+{
+    const int stride = paddedOutputs * NEURAL_QUANT_GROUP;
+    int j = 0;
+
+    for (; j + 64 <= paddedOutputs; j += 64)
+    {
+        __m512i a0 = _mm512_loadu_si512(&biases[j]);
+        __m512i a1 = _mm512_loadu_si512(&biases[j + 16]);
+        __m512i a2 = _mm512_loadu_si512(&biases[j + 32]);
+        __m512i a3 = _mm512_loadu_si512(&biases[j + 48]);
+
+        for (int g = 0; g < groupCount; g++)
+        {
+            const __m512i x = _mm512_set1_epi32(group_codes(codes, g));
+            const int8_t *w = &weights[g * stride + j * NEURAL_QUANT_GROUP];
+            a0 = _mm512_dpbusd_epi32(a0, x, _mm512_loadu_si512(w));
+            a1 = _mm512_dpbusd_epi32(a1, x, _mm512_loadu_si512(w + 64));
+            a2 = _mm512_dpbusd_epi32(a2, x, _mm512_loadu_si512(w + 128));
+            a3 = _mm512_dpbusd_epi32(a3, x, _mm512_loadu_si512(w + 192));
+        }
+
+        _mm512_storeu_si512(&acc[j], a0);
+        _mm512_storeu_si512(&acc[j + 16], a1);
+        _mm512_storeu_si512(&acc[j + 32], a2);
+        _mm512_storeu_si512(&acc[j + 48], a3);
+    }
+
+    for (; j < paddedOutputs; j += 16)
+    {
+        __m512i a = _mm512_loadu_si512(&biases[j]);
+        for (int g = 0; g < groupCount; g++)
+            a = _mm512_dpbusd_epi32(a, _mm512_set1_epi32(group_codes(codes, g)),
+                                    _mm512_loadu_si512(&weights[g * stride + j * NEURAL_QUANT_GROUP]));
+        _mm512_storeu_si512(&acc[j], a);
+    }
+}
+
+#endif // CPU_HAS_X86_SIMD
+
+NeuralQuantKernel NeuralQuant_SelectKernel(NeuralQuantKernel maxKernel)
+{
+    g_layer = layer_scalar;
+    g_kernel = NEURAL_QUANT_KERNEL_SCALAR;
+
+#if CPU_HAS_X86_SIMD
+    const CpuFeatures *features = CpuFeatures_Get();
+    if (maxKernel >= NEURAL_QUANT_KERNEL_AVX512_VNNI && features->avx512f && features->avx512vnni) {
+        g_layer = layer_avx512_vnni;
+        g_kernel = NEURAL_QUANT_KERNEL_AVX512_VNNI;
+    } else if (maxKernel >= NEURAL_QUANT_KERNEL_AVX2 && features->avx2) {
+        g_layer = layer_avx2;
+        g_kernel = NEURAL_QUANT_KERNEL_AVX2;
+    }
+#else
+    (void)maxKernel;
+#endif
+
+    return g_kernel;
+}
+
+NeuralQuantKernel NeuralQuant_ActiveKernel(void)
+{
+    if (g_layer == NULL)
+        NeuralQuant_SelectKernel(NEURAL_QUANT_KERNEL_COUNT - 1);
+    return g_kernel;
+}
+
+const char *NeuralQuant_KernelName(NeuralQuantKernel kernel)
+{
+    if ((unsigned int)kernel >= NEURAL_QUANT_KERNEL_COUNT)
+        return "unknown";
+    return g_kernelNames[kernel];
+}
+
+
+// ============================================================================
+// Networks
+// ============================================================================
+
+static int round_up(int value, int multiple)
+{
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+static void init_tanh_codes(void)
+{
+    for (int i = 0; i <= 2 * TANH_CENTER; i++)
+    {
+        double x = (double)(i - TANH_CENTER) / NEURAL_QUANT_TANH_RESOLUTION;
+        g_tanhCodes[i] = (uint8_t)(NEURAL_QUANT_ACTIVATION_ZERO + lrint(tanh(x) * NEURAL_QUANT_ACTIVATION_STEPS));
+    }
+    g_tanhReady = true;
+}
+
+bool NeuralQuant_Init(NeuralQuant *quant, const int *topology, int topologySize, int slotCapacity)
+{
+    memset(quant, 0, sizeof(NeuralQuant));
+
+    quant->topology = malloc(topologySize * sizeof(int));
+    quant->layers = malloc((topologySize - 1) * sizeof(NeuralQuantLayer));
+    quant->slotCapacity = slotCapacity;
+    quant->networks = calloc(slotCapacity, sizeof(char *));
+    quant->packed = calloc(slotCapacity, sizeof(bool));
+    quant->scratchCount = NeuralNetwork_ParameterCount(topology, topologySize);
+    quant->scratch = malloc(quant->scratchCount * sizeof(NeuralParameter));
+    if (quant->topology == NULL || quant->layers == NULL || quant->networks == NULL || quant->packed == NULL ||
+        quant->scratch == NULL)
+    {
+        fprintf(stderr, "Failed to allocate memory for NeuralQuant !\n");
+        NeuralQuant_Free(quant);
+        return false;
+    }
+
+    memcpy(quant->topology, topology, topologySize * sizeof(int));
+    quant->topologySize = topologySize;
+
+    // One accumulator scale per layer, then per layer: int32 biases and int8 weights,
+    // every array on NEURAL_NETWORK_ALIGNMENT
+    size_t offset = round_up((topologySize - 1) * sizeof(float), NEURAL_NETWORK_ALIGNMENT);
+    for (int i = 0; i < topologySize - 1; i++)
+    {
+        NeuralQuantLayer *layer = &quant->layers[i];
+        layer->inputCount = topology[i];
+        layer->outputCount = topology[i + 1];
+        layer->groupCount = round_up(topology[i], NEURAL_QUANT_GROUP) / NEURAL_QUANT_GROUP;
+        layer->paddedOutputs = round_up(topology[i + 1], NEURAL_QUANT_OUTPUT_BLOCK);
+        layer->biasOffset = offset;
+        offset += round_up(layer->paddedOutputs * sizeof(int32_t), NEURAL_NETWORK_ALIGNMENT);
+        layer->weightOffset = offset;
+        offset += round_up(layer->groupCount * layer->paddedOutputs * NEURAL_QUANT_GROUP, NEURAL_NETWORK_ALIGNMENT);
+
+        quant->maxCodes = MAX(quant->maxCodes, layer->groupCount * NEURAL_QUANT_GROUP);
+        quant->maxCodes = MAX(quant->maxCodes, layer->paddedOutputs);
+    }
+    quant->networkSize = offset;
+    quant->maxCodes = round_up(quant->maxCodes, NEURAL_NETWORK_ALIGNMENT);
+
+    if (!g_tanhReady)
+        init_tanh_codes();
+    return true;
+}
+
+void NeuralQuant_Free(NeuralQuant *quant)
+{
+    if (quant->networks != NULL)
+    {
+        for (int slot = 0; slot < quant->slotCapacity; slot++)
+            Utils_alignedFree(quant->networks[slot]);
+    }
+    free(quant->networks);
+    free(quant->packed);
+    free(quant->scratch);
+    free(quant->layers);
+    free(quant->topology);
+    memset(quant, 0, sizeof(NeuralQuant));
+}
+
+static bool same_shape(const NeuralQuant *quant, const NeuralNetwork *nn)
+{
+    if (nn->topologySize != quant->topologySize)
+        return false;
+    return memcmp(nn->topology, quant->topology, quant->topologySize * sizeof(int)) == 0;
+}
+
+bool NeuralQuant_Pack(NeuralQuant *quant, int slot, const NeuralNetwork *nn)
+{
+    if (nn == NULL || !same_shape(quant, nn) || nn->parameterCount > quant->scratchCount)
+    {
+        NeuralQuant_Release(quant, slot);
+        return false;
+    }
+
+    if (quant->networks[slot] == NULL)
+    {
+        quant->networks[slot] = Utils_alignedAlloc(NEURAL_NETWORK_ALIGNMENT, quant->networkSize);
+        if (quant->networks[slot] == NULL)
+        {
+            fprintf(stderr, "Failed to allocate memory for NeuralQuant network !\n");
+            return false;
+        }
+        // The padding stays at zero: padded weights and biases add nothing
+        memset(quant->networks[slot], 0, quant->networkSize);
+    }
+
+    // Values of the genome, its deltas included
+    memcpy(quant->scratch, nn->parameters, nn->parameterCount * sizeof(NeuralParameter));
+    NeuralNetwork_ApplyDeltas(nn, quant->scratch);
+
+    char *network = quant->networks[slot];
+    float *scales = (float *)network;
+    double inputScale = 1.0 / NEURAL_QUANT_INPUT_STEPS;
+    int zero = 0;
+
+    for (int i = 0; i < quant->topologySize - 1; i++)
+    {
+        const NeuralQuantLayer *layer = &quant->layers[i];
+        const NeuralParameter *weights = quant->scratch + (nn->layers[i].weights - nn->parameters);
+        const NeuralParameter *biases = quant->scratch + (nn->layers[i].biases - nn->parameters);
+        int8_t *quantWeights = (int8_t *)(network + layer->weightOffset);
+        int32_t *quantBiases = (int32_t *)(network + layer->biasOffset);
+        int n = layer->inputCount;
+        int m = layer->outputCount;
+
+        double maxWeight = 0.0;
+        for (int w = 0; w < n * m; w++)
+            maxWeight = MAX(maxWeight, fabs((double)NeuralParameter_Load(weights[w])));
+        double weightScale = maxWeight > 0.0 ? maxWeight / NEURAL_QUANT_WEIGHT_MAX : 1.0;
+        double accScale = weightScale * inputScale;
+
+        // acc = sum w_q * code = sum w_q * (x / inputScale + zero), so the bias
+        // takes away zero * sum w_q
+        for (int j = 0; j < m; j++)
+        {
+            int32_t weightSum = 0;
+            for (int k = 0; k < n; k++)
+            {
+                long value = lrint(NeuralParameter_Load(weights[k * m + j]) / weightScale);
+                value = CLAMP(value, -NEURAL_QUANT_WEIGHT_MAX, NEURAL_QUANT_WEIGHT_MAX);
+                int g = k / NEURAL_QUANT_GROUP;
+                quantWeights[(g * layer->paddedOutputs + j) * NEURAL_QUANT_GROUP + k % NEURAL_QUANT_GROUP] = (int8_t)value;
+                weightSum += (int32_t)value;
+            }
+            double bias = CLAMP(NeuralParameter_Load(biases[j]) / accScale, -1e9, 1e9);
+            quantBiases[j] = (int32_t)lrint(bias) - zero * weightSum;
+        }
+        scales[i] = (float)accScale;
+
+        inputScale = 1.0 / NEURAL_QUANT_ACTIVATION_STEPS;
+        zero = NEURAL_QUANT_ACTIVATION_ZERO;
+    }
+
+    quant->packed[slot] = true;
+    return true;
+}
+
+void NeuralQuant_Release(NeuralQuant *quant, int slot)
+{
+    quant->packed[slot] = false;
+}
+
+bool NeuralQuant_IsPacked(const NeuralQuant *quant, int slot)
+{
+    return quant->packed[slot];
+}
+
+int NeuralQuant_WorkspaceSize(const NeuralQuant *quant)
+{
+    // buffers[0] holds the int32 accumulators, buffers[1] two arrays of codes
+    return (int)((quant->maxCodes * sizeof(int32_t) + sizeof(NeuralScalar) - 1) / sizeof(NeuralScalar));
+}
+
+// Inputs are observations in [0, 1]
+static inline uint8_t input_code(NeuralScalar x)
+{
+    double clamped = CLAMP((double)x, 0.0, 1.0);
+    return (uint8_t)(clamped * NEURAL_QUANT_INPUT_STEPS + 0.5);
+}
+
+// tanh of the pre-activations as the codes of the next layer (acc is overwritten)
+static void tanh_codes(int32_t *acc, int count, float scale, uint8_t *codes)
+{
+    // Table indices first, a loop that vectorizes: positions are kept positive
+    // so the truncation rounds to nearest
+    const float toIndex = scale * NEURAL_QUANT_TANH_RESOLUTION;
+    for (int j = 0; j < count; j++)
+    {
+        float position = CLAMP(acc[j] * toIndex + (TANH_CENTER + 0.5f), 0.0f, 2 * TANH_CENTER + 0.5f);
+        acc[j] = (int32_t)position;
+    }
+    for (int j = 0; j < count; j++)
+        codes[j] = g_tanhCodes[acc[j]];
+}
+
+void NeuralQuant_Forward(const NeuralQuant *quant, int slot, const NeuralScalar *inputs, NeuralScalar *outputs,
+                         NeuralWorkspace *workspace)
+{
+    const int layerCount = quant->topologySize - 1;
+
+    if (!quant->packed[slot] || !NeuralWorkspace_Reserve(workspace, NeuralQuant_WorkspaceSize(quant)))
+    {
+        memset(outputs, 0, quant->topology[layerCount] * sizeof(NeuralScalar));
+        return;
+    }
+    if (g_layer == NULL)
+        NeuralQuant_SelectKernel(NEURAL_QUANT_KERNEL_COUNT - 1);
+
+    PERF_MEASURE(PERF_NEURAL_NETWORK) {
+        const char *network = quant->networks[slot];
+        const float *scales = (const float *)network;
+        int32_t *acc = (int32_t *)workspace->buffers[0];
+        uint8_t *codes = (uint8_t *)workspace->buffers[1];
+        uint8_t *nextCodes = codes + quant->maxCodes;
+
+        const NeuralQuantLayer *first = &quant->layers[0];
+        for (int k = 0; k < first->inputCount; k++)
+            codes[k] = input_code(inputs[k]);
+        for (int k = first->inputCount; k < first->groupCount * NEURAL_QUANT_GROUP; k++)
+            codes[k] = 0;
+
+        for (int i = 0; i < layerCount; i++)
+        {
+            const NeuralQuantLayer *layer = &quant->layers[i];
+            g_layer((const int8_t *)(network + layer->weightOffset), (const int32_t *)(network + layer->biasOffset),
+                    codes, layer->groupCount, layer->paddedOutputs, acc);
+
+            if (i < layerCount - 1)
+            {
+                // Padded outputs give the code of tanh(0), their weights in the next layer are zero
+                tanh_codes(acc, layer->paddedOutputs, scales[i], nextCodes);
+                uint8_t *swap = codes;
+                codes = nextCodes;
+                nextCodes = swap;
+            }
+            else
+            {
+                for (int j = 0; j < layer->outputCount; j++)
+                    outputs[j] = (NeuralScalar)(acc[j] * (double)scales[i]);
+                NeuralNetwork_Activate(outputs, layer->outputCount);
+            }
+        }
+    } // PERF_MEASURE
+}
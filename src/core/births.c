@@ -0,0 +1,205 @@
+/**
+ * @file births.c
+ * @brief Implementation of deferred births and free cell slot allocation
+ */
+
+#include "../../include/core/births.h"
+#include "../../include/core/game.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Slot 0 is never reused (it may hold the player cell)
+#define BIRTHS_FIRST_REUSABLE_SLOT 1
+
+static bool slot_before(Map *map, int a, int b)
+{
+    int scoreA = map->population.score[a];
+    int scoreB = map->population.score[b];
+    if (scoreA != scoreB)
+        return scoreA < scoreB;
+    return a < b;
+}
+
+static void heap_push(Births *births, Map *map, int slot)
+{
+    int *heap = births->freeSlots;
+    int i = births->freeSlotCount++;
+    heap[i] = slot;
+
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!slot_before(map, heap[i], heap[parent]))
+            break;
+        int tmp = heap[i];
+        heap[i] = heap[parent];
+        heap[parent] = tmp;
+        i = parent;
+    }
+}
+
+static int heap_pop(Births *births, Map *map)
+{
+    int *heap = births->freeSlots;
+    int top = heap[0];
+    heap[0] = heap[--births->freeSlotCount];
+
+    int i = 0;
+    for (;;) {
+        int left = 2 * i + 1;
+        int right = left + 1;
+        int smallest = i;
+        if (left < births->freeSlotCount && slot_before(map, heap[left], heap[smallest]))
+            smallest = left;
+        if (right < births->freeSlotCount && slot_before(map, heap[right], heap[smallest]))
+            smallest = right;
+        if (smallest == i)
+            break;
+        int tmp = heap[i];
+        heap[i] = heap[smallest];
+        heap[smallest] = tmp;
+        i = smallest;
+    }
+
+    return top;
+}
+
+static int compare_indices(const void *a, const void *b)
+{
+    return *(const int *)a - *(const int *)b;
+}
+
+bool Births_Init(Births *births, int threadCount)
+{
+    if (births == NULL) return false;
+
+    memset(births, 0, sizeof(Births));
+    births->parents = malloc(MEM_CELL_COUNT * sizeof(int));
+    births->freeSlots = malloc(MEM_CELL_COUNT * sizeof(int));
+    if (births->parents == NULL || births->freeSlots == NULL) {
+        fprintf(stderr, "Failed to allocate memory for births!\n");
+        Births_Free(births);
+        return false;
+    }
+
+    if (!Births_Reserve(births, threadCount)) {
+        Births_Free(births);
+        return false;
+    }
+
+    return true;
+}
+
+void Births_Free(Births *births)
+{
+    if (births == NULL) return;
+
+    for (int t = 0; t < births->queueCount; t++) {
+        free(births->queues[t].parents);
+        free(births->queues[t].deaths);
+    }
+    free(births->queues);
+    free(births->parents);
+    free(births->freeSlots);
+    memset(births, 0, sizeof(Births));
+}
+
+bool Births_Reserve(Births *births, int threadCount)
+{
+    if (threadCount <= births->queueCount)
+        return true;
+
+    BirthQueue *queues = realloc(births->queues, threadCount * sizeof(BirthQueue));
+    if (queues == NULL) {
+        fprintf(stderr, "Failed to allocate memory for birth queues!\n");
+        return false;
+    }
+    births->queues = queues;
+
+    // A thread sees each cell at most once per tick, so MEM_CELL_COUNT entries always fit
+    for (int t = births->queueCount; t < threadCount; t++) {
+        BirthQueue *queue = &births->queues[t];
+        queue->parents = malloc(MEM_CELL_COUNT * sizeof(int));
+        queue->deaths = malloc(MEM_CELL_COUNT * sizeof(int));
+        queue->parentCount = 0;
+        queue->deathCount = 0;
+        if (queue->parents == NULL || queue->deaths == NULL) {
+            fprintf(stderr, "Failed to allocate memory for birth queues!\n");
+            free(queue->parents);
+            free(queue->deaths);
+            return false;
+        }
+        births->queueCount++;
+    }
+
+    return true;
+}
+
+void Births_RecordParent(Births *births, int thread, int index)
+{
+    BirthQueue *queue = &births->queues[thread];
+    queue->parents[queue->parentCount++] = index;
+}
+
+void Births_RecordDeath(Births *births, int thread, int index)
+{
+    BirthQueue *queue = &births->queues[thread];
+    queue->deaths[queue->deathCount++] = index;
+}
+
+void Births_Apply(Births *births, Map *map)
+{
+    Population *population = &map->population;
+    int parentCount = 0;
+
+    for (int t = 0; t < births->queueCount; t++) {
+        BirthQueue *queue = &births->queues[t];
+
+        for (int i = 0; i < queue->deathCount; i++) {
+            if (queue->deaths[i] >= BIRTHS_FIRST_REUSABLE_SLOT)
+                heap_push(births, map, queue->deaths[i]);
+        }
+
+        memcpy(&births->parents[parentCount], queue->parents, queue->parentCount * sizeof(int));
+        parentCount += queue->parentCount;
+
+        queue->deathCount = 0;
+        queue->parentCount = 0;
+    }
+
+    // Thread chunks depend on the schedule, cell order does not
+    qsort(births->parents, parentCount, sizeof(int), compare_indices);
+
+    for (int i = 0; i < parentCount; i++) {
+        int parent = births->parents[i];
+        population->cells[parent].birthPending = false;
+
+        int slot;
+        if (births->freeSlotCount > 0) {
+            slot = heap_pop(births, map);
+        } else if (population->count < population->capacity) {
+            slot = population->count;
+        } else {
+            printf("No more space for new cells !\n");
+            continue;
+        }
+
+        if (!Cell_GiveBirth(population, parent, slot, map)) {
+            // A failed birth leaves the slot as it was: dead and reusable, or unused
+            if (slot < population->count)
+                heap_push(births, map, slot);
+            continue;
+        }
+
+        if (slot == population->count)
+            population->count++;
+    }
+}
+
+void Births_RebuildFreeSlots(Births *births, Map *map)
+{
+    births->freeSlotCount = 0;
+    for (int i = BIRTHS_FIRST_REUSABLE_SLOT; i < map->population.count; i++) {
+        if (!map->population.alive[i])
+            heap_push(births, map, i);
+    }
+}
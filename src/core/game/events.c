@@ -21,16 +21,16 @@ void Game_events(Map *map, SDL_Event *event)
                 break;
 #if CELL_AS_PLAYER
             case SDLK_z:
-                map->cells[0]->goingUp = true;
+                map->population.cells[0].goingUp = true;
                 break;
             case SDLK_q:
-                map->cells[0]->goingLeft = true;
+                map->population.cells[0].goingLeft = true;
                 break;
             case SDLK_s:
-                map->cells[0]->goingDown = true;
+                map->population.cells[0].goingDown = true;
                 break;
             case SDLK_d:
-                map->cells[0]->goingRight = true;
+                map->population.cells[0].goingRight = true;
                 break;
 #endif
             case SDLK_n:
@@ -96,16 +96,16 @@ void Game_events(Map *map, SDL_Event *event)
         switch(event->key.keysym.sym)
         {
             case SDLK_z:
-                map->cells[0]->goingUp = false;
+                map->population.cells[0].goingUp = false;
                 break;
             case SDLK_q:
-                map->cells[0]->goingLeft = false;
+                map->population.cells[0].goingLeft = false;
                 break;
             case SDLK_s:
-                map->cells[0]->goingDown = false;
+                map->population.cells[0].goingDown = false;
                 break;
             case SDLK_d:
-                map->cells[0]->goingRight = false;
+                map->population.cells[0].goingRight = false;
                 break;
             default:
                 break;
@@ -0,0 +1,463 @@
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef HAVE_OPENMP
+#include <omp.h>
+#endif
+
+#include "../../../include/core/game.h"
+#include "../../../include/system/performance.h"
+
+// One backend: bring its copies of the networks in line with the population,
+// run the think phase, and run one cell on its own (shadow samples)
+typedef struct {
+    const char *name;
+    void (*sync)(Map *map);
+    void (*think)(Map *map, bool parallel);
+    void (*evaluate)(Map *map, int index, NeuralScalar *outputs, NeuralWorkspace *workspace);
+} InferenceOps;
+
+static int thread_index(void)
+{
+#ifdef HAVE_OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+// Queue the death or reproduction of a cell that just thought, for the apply phase
+static void record_cell(Map *map, int index, int thread)
+{
+    Population *population = &map->population;
+
+    // Only cells alive at the start of the tick get here
+    if (!population->alive[index])
+        Births_RecordDeath(&map->births, thread, index);
+    if (population->cells[index].birthPending)
+        Births_RecordParent(&map->births, thread, index);
+}
+
+// Whether the cells of this stagger (index, or block of lanes) decide this
+// tick: one tick in decisionInterval, a different one for each stagger, so
+// every tick runs about as many networks
+static bool decision_tick(const Map *map, int stagger)
+{
+    return map->decisionInterval <= 1 || (stagger + map->frames) % map->decisionInterval == 0;
+}
+
+// A new cell has no outputs of its own yet, so it decides on its first tick
+static void plan_decision(const Map *map, Cell *cell, int stagger)
+{
+    cell->deciding = cell->frame == 0 || decision_tick(map, stagger);
+}
+
+// Think phase cell by cell: sense, encode, run the network, apply the outputs.
+// Between two decisions a cell skips the rays and the network.
+static void think_each(Map *map, bool parallel,
+                       void (*evaluate)(Map *, int, NeuralScalar *, NeuralWorkspace *))
+{
+    Population *population = &map->population;
+    (void)parallel;
+
+    #pragma omp parallel for schedule(dynamic, 16) if (parallel)
+    for (int k = 0; k < population->aliveCount; ++k)
+    {
+        int index = population->aliveIndex[k];
+        Cell *cell = &population->cells[index];
+        plan_decision(map, cell, index);
+
+        PERF_MEASURE(PERF_CELL_UPDATE) {
+            if (cell->deciding)
+                Cell_sense(population, index, map);
+            Cell_encodeInputs(population, index);
+            if (cell->isAI && cell->deciding)
+                evaluate(map, index, cell->outputs, &map->workspaces[thread_index()]);
+            Cell_applyOutputs(population, index);
+        }
+
+        record_cell(map, index, thread_index());
+    }
+}
+
+// ============================================================================
+// Cell by cell, on the genomes
+// ============================================================================
+
+// Copy-on-write genomes get dense parameters first, on one thread
+static void sync_genomes(Map *map)
+{
+    Population *population = &map->population;
+
+    for (int k = 0; k < population->aliveCount; ++k)
+    {
+        Cell *cell = &population->cells[population->aliveIndex[k]];
+        if (cell->isAI)
+            NeuralNetwork_Materialize(cell->nn);
+    }
+}
+
+static void evaluate_reference(Map *map, int index, NeuralScalar *outputs, NeuralWorkspace *workspace)
+{
+    Cell *cell = &map->population.cells[index];
+    NeuralNetwork_ForwardReference(cell->nn, cell->inputs, outputs, workspace);
+}
+
+// The first layer only reads the rows of the non-zero inputs
+static void evaluate_simd(Map *map, int index, NeuralScalar *outputs, NeuralWorkspace *workspace)
+{
+    Cell *cell = &map->population.cells[index];
+    NeuralNetwork_ForwardSparse(cell->nn, cell->inputs, cell->activeInputs, cell->activeInputCount, outputs, workspace);
+}
+
+static void think_reference(Map *map, bool parallel)
+{
+    think_each(map, parallel, evaluate_reference);
+}
+
+static void think_simd(Map *map, bool parallel)
+{
+    think_each(map, parallel, evaluate_simd);
+}
+
+// ============================================================================
+// Blocks of cells (NeuralBatch)
+// ============================================================================
+
+// Bring the packed networks in line with the population: repack the networks
+// that changed and release the lanes of dead or manually controlled cells.
+// Lanes move around, so this runs before the think phase, on one thread.
+// A network left unpacked runs on its own and needs dense parameters
+static void sync_batch(Map *map)
+{
+    Population *population = &map->population;
+
+    for (int i = 0; i < population->count; ++i)
+    {
+        if (!population->alive[i] || !population->cells[i].isAI)
+            NeuralBatch_Release(&map->batch, i);
+        else if (population->networkChanged[i] && !NeuralBatch_Pack(&map->batch, i, population->cells[i].nn))
+            NeuralNetwork_Materialize(population->cells[i].nn);
+    }
+}
+
+// One interleaved pass over the lanes of a block
+static void think_block(Map *map, int block, int thread)
+{
+    Population *population = &map->population;
+    const NeuralBatch *batch = &map->batch;
+    const NeuralScalar *inputs[NEURAL_BATCH_LANES] = { NULL };
+    NeuralScalar *outputs[NEURAL_BATCH_LANES] = { NULL };
+    int first = block * NEURAL_BATCH_LANES;
+
+    for (int lane = 0; lane < NEURAL_BATCH_LANES && first + lane < batch->laneCount; lane++)
+    {
+        Cell *cell = &population->cells[batch->laneSlot[first + lane]];
+        inputs[lane] = cell->inputs;
+        outputs[lane] = cell->outputs;
+    }
+
+    NeuralBatch_Forward(batch, block, inputs, outputs, &map->workspaces[thread]);
+}
+
+// The block of the cell, with only its lane filled in
+static void evaluate_batched(Map *map, int index, NeuralScalar *outputs, NeuralWorkspace *workspace)
+{
+    const NeuralBatch *batch = &map->batch;
+    Cell *cell = &map->population.cells[index];
+    int lane = batch->slotLane[index];
+
+    if (lane < 0)
+    {
+        NeuralNetwork_Forward(cell->nn, cell->inputs, outputs, workspace);
+        return;
+    }
+
+    const NeuralScalar *inputs[NEURAL_BATCH_LANES] = { NULL };
+    NeuralScalar *laneOutputs[NEURAL_BATCH_LANES] = { NULL };
+    inputs[lane % NEURAL_BATCH_LANES] = cell->inputs;
+    laneOutputs[lane % NEURAL_BATCH_LANES] = outputs;
+    NeuralBatch_Forward(batch, lane / NEURAL_BATCH_LANES, inputs, laneOutputs, workspace);
+}
+
+// Think phase by blocks of NEURAL_BATCH_LANES cells: every cell senses and
+// encodes its inputs, the networks run block by block, then every cell applies
+// its outputs. Each step only writes the cells' own slots.
+// The cells of a block decide on the same ticks, so the blocks in between are
+// skipped; a new cell off its block's tick runs the block for its lane alone.
+static void think_batched(Map *map, bool parallel)
+{
+    Population *population = &map->population;
+    const NeuralBatch *batch = &map->batch;
+    int blockCount = NeuralBatch_BlockCount(batch);
+    (void)parallel;
+
+    #pragma omp parallel if (parallel)
+    {
+        #pragma omp for schedule(dynamic, 16)
+        for (int k = 0; k < population->aliveCount; ++k)
+        {
+            int index = population->aliveIndex[k];
+            Cell *cell = &population->cells[index];
+            bool packed = NeuralBatch_IsPacked(batch, index);
+            int block = packed ? batch->slotLane[index] / NEURAL_BATCH_LANES : -1;
+            plan_decision(map, cell, packed ? block : index);
+
+            PERF_MEASURE(PERF_CELL_UPDATE) {
+                if (cell->deciding)
+                    Cell_sense(population, index, map);
+                Cell_encodeInputs(population, index);
+            }
+
+            // Networks of another shape are never packed
+            NeuralWorkspace *workspace = &map->workspaces[thread_index()];
+            if (!cell->isAI || !cell->deciding)
+                continue;
+            if (!packed)
+                NeuralNetwork_Forward(cell->nn, cell->inputs, cell->outputs, workspace);
+            else if (!decision_tick(map, block))
+                evaluate_batched(map, index, cell->outputs, workspace);
+        }
+
+        #pragma omp for schedule(dynamic, 1)
+        for (int block = 0; block < blockCount; ++block)
+            if (decision_tick(map, block))
+                think_block(map, block, thread_index());
+
+        #pragma omp for schedule(dynamic, 16)
+        for (int k = 0; k < population->aliveCount; ++k)
+        {
+            int index = population->aliveIndex[k];
+            Cell_applyOutputs(population, index);
+            record_cell(map, index, thread_index());
+        }
+    }
+}
+
+// ============================================================================
+// Int8 copies (NeuralQuant)
+// ============================================================================
+
+// Same as sync_batch for the int8 copies
+static void sync_quant(Map *map)
+{
+    Population *population = &map->population;
+
+    for (int i = 0; i < population->count; ++i)
+    {
+        if (!population->alive[i] || !population->cells[i].isAI)
+            NeuralQuant_Release(&map->quant, i);
+        else if (population->networkChanged[i] && !NeuralQuant_Pack(&map->quant, i, population->cells[i].nn))
+            NeuralNetwork_Materialize(population->cells[i].nn);
+    }
+}
+
+// Networks of another shape run in float
+static void evaluate_quantized(Map *map, int index, NeuralScalar *outputs, NeuralWorkspace *workspace)
+{
+    Cell *cell = &map->population.cells[index];
+    if (NeuralQuant_IsPacked(&map->quant, index))
+        NeuralQuant_Forward(&map->quant, index, cell->inputs, outputs, workspace);
+    else
+        NeuralNetwork_Forward(cell->nn, cell->inputs, outputs, workspace);
+}
+
+static void think_quantized(Map *map, bool parallel)
+{
+    think_each(map, parallel, evaluate_quantized);
+}
+
+// ============================================================================
+// Pruned copies (NeuralPrune)
+// ============================================================================
+
+// Same as sync_batch for the pruned copies
+static void sync_pruned(Map *map)
+{
+    Population *population = &map->population;
+
+    for (int i = 0; i < population->count; ++i)
+    {
+        if (!population->alive[i] || !population->cells[i].isAI)
+            NeuralPrune_Release(&map->prune, i);
+        else if (population->networkChanged[i] && !NeuralPrune_Pack(&map->prune, i, population->cells[i].nn))
+            NeuralNetwork_Materialize(population->cells[i].nn);
+    }
+}
+
+// Networks of another shape run unpruned
+static void evaluate_pruned(Map *map, int index, NeuralScalar *outputs, NeuralWorkspace *workspace)
+{
+    Cell *cell = &map->population.cells[index];
+    if (NeuralPrune_IsPacked(&map->prune, index))
+        NeuralPrune_Forward(&map->prune, index, cell->inputs, outputs, workspace);
+    else
+        NeuralNetwork_Forward(cell->nn, cell->inputs, outputs, workspace);
+}
+
+static void think_pruned(Map *map, bool parallel)
+{
+    think_each(map, parallel, evaluate_pruned);
+}
+
+// ============================================================================
+// Registry
+// ============================================================================
+
+static const InferenceOps g_backends[INFERENCE_BACKEND_COUNT] = {
+    [INFERENCE_REFERENCE] = { "reference", sync_genomes, think_reference, evaluate_reference },
+    [INFERENCE_SIMD] = { "simd", sync_genomes, think_simd, evaluate_simd },
+    [INFERENCE_BATCHED] = { "batched", sync_batch, think_batched, evaluate_batched },
+    [INFERENCE_QUANTIZED] = { "int8", sync_quant, think_quantized, evaluate_quantized },
+    [INFERENCE_PRUNED] = { "pruned", sync_pruned, think_pruned, evaluate_pruned },
+};
+
+static double seconds_between(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// Run both backends again on the sampled cells, on one thread, and compare the
+// shadow with the outputs the cells acted on. The backend itself must give
+// them again: any other outputs show that it is not deterministic. The cells
+// are left untouched.
+static void run_shadow(Map *map, const InferenceOps *backend, const InferenceOps *shadow)
+{
+    Population *population = &map->population;
+    InferenceDivergence *divergence = &map->divergence;
+    NeuralWorkspace *workspace = &map->workspaces[0];
+    int interval = map->shadowInterval;
+
+    for (int k = 0; k < population->aliveCount; ++k)
+    {
+        int index = population->aliveIndex[k];
+        Cell *cell = &population->cells[index];
+        if (!cell->isAI || !cell->deciding || (index + map->frames) % interval != 0)
+            continue;
+
+        NeuralScalar again[sizeof(cell->outputs) / sizeof(cell->outputs[0])];
+        NeuralScalar shadowed[sizeof(cell->outputs) / sizeof(cell->outputs[0])];
+        struct timespec start, middle, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        backend->evaluate(map, index, again, workspace);
+        clock_gettime(CLOCK_MONOTONIC, &middle);
+        shadow->evaluate(map, index, shadowed, workspace);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        divergence->backendTime += seconds_between(&start, &middle);
+        divergence->shadowTime += seconds_between(&middle, &end);
+
+        const int outputCount = (int)(sizeof(shadowed) / sizeof(shadowed[0]));
+        for (int j = 0; j < outputCount; j++)
+        {
+            if (again[j] != cell->outputs[j])
+            {
+                divergence->mismatches++;
+                break;
+            }
+        }
+        Inference_CompareOutputs(divergence, cell->outputs, shadowed, outputCount);
+    }
+}
+
+void Inference_CompareOutputs(InferenceDivergence *divergence, const NeuralScalar *reference,
+                              const NeuralScalar *outputs, int outputCount)
+{
+    double sampleDifference = 0.0;
+    for (int j = 0; j < outputCount; j++)
+    {
+        double difference = fabs((double)outputs[j] - (double)reference[j]);
+        divergence->maxDifference = MAX(divergence->maxDifference, difference);
+        sampleDifference += difference;
+    }
+    divergence->samples++;
+    divergence->totalDifference += sampleDifference / outputCount;
+    divergence->flips[INFERENCE_DECISION_DIRECTION] += (reference[0] < 0) != (outputs[0] < 0);
+    divergence->flips[INFERENCE_DECISION_TURN] += (reference[1] < 0) != (outputs[1] < 0);
+    divergence->flips[INFERENCE_DECISION_REPRODUCE] += (reference[2] > 0.5) != (outputs[2] > 0.5);
+}
+
+void Inference_Think(Map *map, bool parallel)
+{
+    Population *population = &map->population;
+    const InferenceOps *backend = &g_backends[map->inferenceBackend];
+    const InferenceOps *shadow = map->shadowInterval > 0 ? &g_backends[map->shadowBackend] : NULL;
+
+    // Every backend in use sees the changed networks before the flags are cleared
+    backend->sync(map);
+    if (shadow != NULL && shadow->sync != backend->sync)
+        shadow->sync(map);
+    memset(population->networkChanged, 0, population->count * sizeof(bool));
+
+    backend->think(map, parallel);
+
+    if (shadow != NULL)
+        run_shadow(map, backend, shadow);
+}
+
+// A backend that was not in use missed the changes, so it repacks everything
+static void mark_networks_changed(Map *map)
+{
+    Population *population = &map->population;
+    for (int i = 0; i < population->count; ++i)
+        population->networkChanged[i] = true;
+}
+
+void Inference_SetBackend(Map *map, InferenceBackend backend)
+{
+    if ((unsigned int)backend >= INFERENCE_BACKEND_COUNT || backend == map->inferenceBackend)
+        return;
+
+    map->inferenceBackend = backend;
+    mark_networks_changed(map);
+}
+
+void Inference_SetShadow(Map *map, InferenceBackend shadow, int interval)
+{
+    if ((unsigned int)shadow >= INFERENCE_BACKEND_COUNT)
+        interval = 0;
+
+    map->shadowBackend = shadow;
+    map->shadowInterval = MAX(interval, 0);
+    Inference_ResetDivergence(&map->divergence);
+    mark_networks_changed(map);
+}
+
+void Inference_SetDecisionInterval(Map *map, int interval)
+{
+    map->decisionInterval = MAX(interval, 1);
+}
+
+bool Inference_SetPruning(Map *map, double fraction)
+{
+    if (!NeuralPrune_SetFraction(&map->prune, fraction))
+        return false;
+    mark_networks_changed(map);
+    return true;
+}
+
+void Inference_ResetDivergence(InferenceDivergence *divergence)
+{
+    memset(divergence, 0, sizeof(InferenceDivergence));
+}
+
+const char *Inference_BackendName(InferenceBackend backend)
+{
+    if ((unsigned int)backend >= INFERENCE_BACKEND_COUNT)
+        return "unknown";
+    return g_backends[backend].name;
+}
+
+bool Inference_ParseBackend(const char *name, InferenceBackend *backend)
+{
+    for (int i = 0; i < INFERENCE_BACKEND_COUNT; i++)
+    {
+        if (strcmp(name, g_backends[i].name) == 0)
+        {
+            *backend = (InferenceBackend)i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,194 @@
+#include "../../../include/core/game.h"
+#include "../../../include/entities/cell.h"
+#include <stdlib.h>  // For malloc/free
+#include <string.h>  // For memset
+
+// Simulation state only: window, renderer and view settings belong to Game_start
+bool Game_init(Map *map, int w, int h)
+{
+    map->width = w;
+    map->height = h;
+
+    map->startTime = time(NULL);
+    map->pausedTime = 0;
+
+    map->generation = 1;
+    map->maxGeneration = 1;
+    map->frames = 1;
+    map->maxScore = 0;
+    map->isRunning = true;
+    map->useMultithreading = true;
+    map->inferenceBackend = INFERENCE_BATCHED;
+    map->shadowBackend = INFERENCE_REFERENCE;
+    map->shadowInterval = 0;
+    Inference_ResetDivergence(&map->divergence);
+    map->decisionInterval = CELL_DECISION_INTERVAL;
+    map->quit = false;
+    map->currentBestCellIndex = 1;
+
+    // Initialize checkpoint variables
+    map->lastCheckpointGeneration = 0;
+    map->checkpointCounter = 0;
+
+    // Initialize performance tracking
+    map->previousGenFrames = 0;
+    map->currentFPS = 0;
+    map->currentUPS = 0;
+    map->currentGPS = 0.0f;
+
+    // Initialize graph system
+    if (!Graph_Init(&map->graphData)) {
+        fprintf(stderr, "Failed to initialize graph system!\n");
+        return false;
+    }
+
+    // Initialize evolution system
+    Evolution_InitMutationParams(&map->mutationParams);
+    memset(&map->evolutionMetrics, 0, sizeof(EvolutionMetrics));
+
+    // Initialize walls
+    for (int i = 0; i < GAME_START_WALL_COUNT; ++i)
+    {
+        map->walls[i] = Wall_init(0, 0, 40, 40);
+        if (map->walls[i] == NULL)
+        {
+            fprintf(stderr, "Error while initializing wall %d !\n", i);
+            for (int j = 0; j < i; ++j)
+            {
+                Wall_destroy(map->walls[j]);
+            }
+            return false;
+        }
+        Wall_reset(map->walls[i], map);
+    }
+
+    // Initialize foods
+    for (int i = 0; i < MEM_FOOD_COUNT; ++i)
+    {
+        if (i > GAME_START_FOOD_COUNT)
+        {
+            map->foods[i] = NULL;
+            continue;
+        }
+        map->foods[i] = Food_init(irand(0, map->width), irand(0, map->height));
+        if (map->foods[i] == NULL)
+        {
+            fprintf(stderr, "Error while initializing food %d !\n", i);
+            for (int j = 0; j < i; ++j)
+            {
+                Food_destroy(map->foods[j]);
+            }
+            return false;
+        }
+    }
+
+    // Initialize cells
+    if (GAME_START_CELL_COUNT <= 0 || GAME_START_CELL_COUNT > MEM_CELL_COUNT)
+    {
+        fprintf(stderr, "Error while initializing cells !\n");
+        return false;
+    }
+    if (!Population_Init(&map->population, MEM_CELL_COUNT))
+        return false;
+    for (int i = 0; i < GAME_START_CELL_COUNT; ++i)
+    {
+        if (!Cell_create(&map->population, i, map->width / 2, map->height / 2, !CELL_AS_PLAYER || i > 0))
+        {
+            fprintf(stderr, "Error while initializing cell %d !\n", i);
+            Population_Free(&map->population);
+            return false;
+        }
+        map->population.count++;
+    }
+    Population_UpdateAlive(&map->population);
+
+    // Initialize spatial grid used by ray sensing
+    if (!SpatialGrid_Init(&map->grid, map->width, map->height))
+    {
+        fprintf(stderr, "Failed to initialize spatial grid!\n");
+        return false;
+    }
+
+    // Initialize birth queues (more are added if the thread count grows)
+    if (!Births_Init(&map->births, 1))
+    {
+        fprintf(stderr, "Failed to initialize birth queues!\n");
+        return false;
+    }
+
+    // Inference workspaces are created per thread on the first update
+    map->workspaces = NULL;
+    map->workspaceCount = 0;
+
+    // Pick the dense layer kernels now rather than from the first parallel update
+    NeuralNetwork_ActiveKernel();
+
+    // Blocks are packed on demand, from the networkChanged flags set by Cell_create
+    int batchTopology[] = NEURAL_NETWORK_TOPOLOGY;
+    if (!NeuralBatch_Init(&map->batch, batchTopology, sizeof(batchTopology) / sizeof(batchTopology[0]), MEM_CELL_COUNT))
+        return false;
+    if (!NeuralQuant_Init(&map->quant, batchTopology, sizeof(batchTopology) / sizeof(batchTopology[0]), MEM_CELL_COUNT))
+        return false;
+    NeuralQuant_ActiveKernel();
+    if (!NeuralPrune_Init(&map->prune, batchTopology, sizeof(batchTopology) / sizeof(batchTopology[0]), MEM_CELL_COUNT,
+                          NEURAL_NETWORK_PRUNE_FRACTION))
+        return false;
+
+    // Initialize best cell ever
+    int topology[] = NEURAL_NETWORK_TOPOLOGY;
+    map->bestCellEver.nn = createNeuralNetwork(topology, sizeof(topology) / sizeof(topology[0]));
+    map->bestCellEver.score = 0;
+    map->bestCellEver.generation = 1;
+    if (map->bestCellEver.nn == NULL)
+    {
+        fprintf(stderr, "Error while initializing best cell !\n");
+        return false;
+    }
+    setRandomWeights(map->bestCellEver.nn, -1, 1);
+
+    return true;
+}
+
+void Game_destroy(Map *map)
+{
+    Population_Free(&map->population);
+
+    for (int i = 0; i < MEM_FOOD_COUNT; ++i)
+    {
+        if (map->foods[i] != NULL)
+            Food_destroy(map->foods[i]);
+        map->foods[i] = NULL;
+    }
+
+    for (int i = 0; i < GAME_START_WALL_COUNT; ++i)
+    {
+        if (map->walls[i] != NULL)
+            Wall_destroy(map->walls[i]);
+        map->walls[i] = NULL;
+    }
+
+    if (map->bestCellEver.nn != NULL)
+        freeNeuralNetwork(map->bestCellEver.nn);
+    map->bestCellEver.nn = NULL;
+
+    // Free graph system
+    Graph_Free(&map->graphData);
+
+    // Free spatial grid
+    SpatialGrid_Free(&map->grid);
+
+    // Free birth queues
+    Births_Free(&map->births);
+
+    // Free the packed networks
+    NeuralBatch_Free(&map->batch);
+    NeuralQuant_Free(&map->quant);
+    NeuralPrune_Free(&map->prune);
+
+    // Free inference workspaces
+    for (int t = 0; t < map->workspaceCount; t++)
+        NeuralWorkspace_Free(&map->workspaces[t]);
+    free(map->workspaces);
+    map->workspaces = NULL;
+    map->workspaceCount = 0;
+}
@@ -3,20 +3,21 @@
 
 void Game_reset(Map *map, bool fullReset)
 {
-    Cell *bestParents[MEM_CELL_COUNT];
+    Population *population = &map->population;
+    int bestParents[MEM_CELL_COUNT];  // Slots, or -1 for the best cell ever
     int parentCount = 0;
 
     if (fullReset)
     {
         // Use the best cell ever for full reset
-        bestParents[0] = map->bestCellEver;
+        bestParents[0] = -1;
         parentCount = 1;
     }
     else
     {
         // Create array of all cells with their scores
         typedef struct {
-            Cell *cell;
+            int index;
             int score;
         } CellScore;
 
@@ -24,12 +25,10 @@ void Game_reset(Map *map, bool fullReset)
         int validCellCount = 0;
 
         // Collect all valid cells
-        for (int i = 0; i < map->cellCount; ++i) {
-            if (map->cells[i] != NULL) {
-                cellScores[validCellCount].cell = map->cells[i];
-                cellScores[validCellCount].score = map->cells[i]->score;
-                validCellCount++;
-            }
+        for (int i = 0; i < population->count; ++i) {
+            cellScores[validCellCount].index = i;
+            cellScores[validCellCount].score = population->score[i];
+            validCellCount++;
         }
 
         // Sort cells by score (descending)
@@ -48,7 +47,8 @@ void Game_reset(Map *map, bool fullReset)
         if (parentCount < 1) parentCount = 1;
 
         for (int i = 0; i < parentCount; i++) {
-            bestParents[i] = cellScores[i].cell;
+            // No cell to pick from: fall back to the best cell ever
+            bestParents[i] = i < validCellCount ? cellScores[i].index : -1;
         }
 
         // Update evolution metrics and adapt mutation parameters BEFORE adding graph point
@@ -67,15 +67,12 @@ void Game_reset(Map *map, bool fullReset)
         int worstScore = INT_MAX;
 
         // Find worst performing cell to replace
-        for (int i = 0; i < map->cellCount; ++i)
+        for (int i = 0; i < population->count; ++i)
         {
-            if (map->cells[i] == NULL)
-                continue;
-
-            if (!map->cells[i]->isAlive && map->cells[i]->score < worstScore)
+            if (!population->alive[i] && population->score[i] < worstScore)
             {
                 targetIndex = i;
-                worstScore = map->cells[i]->score;
+                worstScore = population->score[i];
             }
         }
         if (targetIndex == -1)
@@ -85,29 +82,34 @@ void Game_reset(Map *map, bool fullReset)
         }
 
         // Select a random parent from the top 20%
-        Cell *selectedParent = bestParents[revived % parentCount];
+        int selectedParent = bestParents[revived % parentCount];
+        NeuralNetwork *parentNN = selectedParent < 0 ? map->bestCellEver.nn : population->cells[selectedParent].nn;
 
-        NeuralNetwork *newNN = NeuralNetwork_Copy(selectedParent->nn);
-        if (newNN == NULL)
+        // Copied in place: no allocation unless the shapes differ
+        if (!NeuralNetwork_Assign(&population->cells[targetIndex].nn, parentNN))
         {
             fprintf(stderr, "Failed to copy NeuralNetwork !\n");
             return;
         }
 
-        Cell_reset(map->cells[targetIndex]);
-        freeNeuralNetwork(map->cells[targetIndex]->nn);
-        map->cells[targetIndex]->nn = newNN;
+        Cell_reset(population, targetIndex);
 
         // Use dynamic mutation parameters
+        Random_NewStream(&population->cells[targetIndex].rng);
         Cell_mutate(
-            map->cells[targetIndex],
+            &population->cells[targetIndex],
             map->mutationParams.resetMutationRate,
             map->mutationParams.resetMutationProb
         );
+        population->networkChanged[targetIndex] = true;
 
         revived++;
     }
 
+    // Revived cells left the free slots
+    Births_RebuildFreeSlots(&map->births, map);
+    Population_UpdateAlive(population);
+
     // Reset foods state
     for (int i = 0; i < GAME_START_FOOD_COUNT; ++i)
         Food_reset(map->foods[i], map);
@@ -11,6 +11,7 @@
 bool Game_start(SDL_Window *window, SDL_Renderer *renderer, int w, int h)
 {
     Map map;
+    memset(&map, 0, sizeof(Map));
     map.width = w;
     map.height = h;
     map.viewOffset = (SDL_Point) { 0, 0 };
@@ -19,94 +20,29 @@ bool Game_start(SDL_Window *window, SDL_Renderer *renderer, int w, int h)
     map.dragStartMouse = (SDL_Point) { 0, 0 };
     map.dragStartView = (SDL_Point) { 0, 0 };
 
-    map.startTime = time(NULL);
-    map.pausedTime = 0;
-
-    map.generation = 1;
-    map.maxGeneration = 1;
-    map.frames = 1;
-    map.maxScore = 0;
-    map.isRunning = true;
     map.verticalSync = true;
     map.renderText = true;
     map.renderRays = false;
     map.renderNeuralNetwork = false;
     map.renderScoreGraph = false;
     map.renderEnabled = true;
-    map.useMultithreading = true;
-    map.useGpuAcceleration = true;
-    map.cellCount = 0;
-    map.quit = false;
 
     // Initialize default values
     map.mode = SCREEN_NORMAL;
-    map.currentBestCellIndex = 1;
     map.renderer = renderer;
     map.window = window;
 
-    // Apply startup mode
+    // Apply startup mode (resizes the map, so it comes before the world is created)
     Screen_Set(&map, GAME_START_MODE);
 
-    // Initialize checkpoint variables
-    map.lastCheckpointGeneration = 0;
-    map.checkpointCounter = 0;
-
-    // Initialize performance tracking
-    map.previousGenFrames = 0;
-    map.currentFPS = 0;
-    map.currentUPS = 0;
-    map.currentGPS = 0.0f;
-
-    // Initialize graph system
-    if (!Graph_Init(&map.graphData)) {
-        fprintf(stderr, "Failed to initialize graph system!\n");
-        return false;
-    }
-
-    // Initialize evolution system
-    Evolution_InitMutationParams(&map.mutationParams);
-    memset(&map.evolutionMetrics, 0, sizeof(EvolutionMetrics));
-
     // Initialize graph window
     map.graphWindow = NULL;
     map.graphRenderer = NULL;
     map.graphWindowOpen = false;
 
-    // Initialize walls
-    for (int i = 0; i < GAME_START_WALL_COUNT; ++i)
-    {
-        map.walls[i] = Wall_init(0, 0, 40, 40);
-        if (map.walls[i] == NULL)
-        {
-            fprintf(stderr, "Error while initializing wall %d !\n", i);
-            for (int j = 0; j < i; ++j)
-            {
-                Wall_destroy(map.walls[j]);
-            }
-            return false;
-        }
-        Wall_reset(map.walls[i], &map);
-    }
-
-    // Initialize foods
-    for (int i = 0; i < MEM_FOOD_COUNT; ++i)
-    {
-        if (i > GAME_START_FOOD_COUNT)
-        {
-            map.foods[i] = NULL;
-            continue;
-        }
-        map.foods[i] = Food_init(irand(0, map.width), irand(0, map.height));
-        if (map.foods[i] == NULL)
-        {
-            fprintf(stderr, "Error while initializing food %d !\n", i);
-            for (int j = 0; j < i; ++j)
-            {
-                Food_destroy(map.foods[j]);
-            }
-            return false;
-        }
-    }
+    // Initialize simulation state (cells, foods, walls, evolution)
+    if (!Game_init(&map, map.width, map.height))
+        return false;
 
     // Load textures once if sprite rendering is enabled (optimized loading)
     SDL_Texture *normalSprite = NULL;
@@ -130,36 +66,6 @@ bool Game_start(SDL_Window *window, SDL_Renderer *renderer, int w, int h)
         }
     }
 
-    // Initialize cells
-    if (GAME_START_CELL_COUNT <= 0 || GAME_START_CELL_COUNT > MEM_CELL_COUNT)
-    {
-        fprintf(stderr, "Error while initializing cells !\n");
-        return false;
-    }
-    for (int i = 0; i < MEM_CELL_COUNT; ++i)
-    {
-        if (i >= GAME_START_CELL_COUNT)
-        {
-            map.cells[i] = NULL;
-            continue;
-        }
-
-        // Create cell with shared sprite texture (no individual loading)
-        map.cells[i] = Cell_create(map.width / 2, map.height / 2, !CELL_AS_PLAYER || i > 0);
-        if (map.cells[i] == NULL)
-        {
-            fprintf(stderr, "Error while initializing cell %d !\n", i);
-            for (int j = 0; j < i; ++j)
-                if (map.cells[j] != NULL)
-                    Cell_destroy(map.cells[j]);
-            return false;
-        }
-        map.cellCount++;
-    }
-
-    // Initialize best cell ever with shiny sprite
-    map.bestCellEver = Cell_create(map.width / 2, map.height / 2, false);
-
     // Load a neural network if file exists
     char filename[] = "../ressources/best.nn";
 
@@ -177,20 +83,14 @@ bool Game_start(SDL_Window *window, SDL_Renderer *renderer, int w, int h)
     if (popup_result == 1)
     {
         nn = Game_load(&map, filename);
-        for (int i = 0; i < map.cellCount; ++i)
+        for (int i = 0; i < map.population.count; ++i)
         {
-            if (map.cells[i] != NULL)
+            if (!NeuralNetwork_Assign(&map.population.cells[i].nn, nn))
             {
-                NeuralNetwork *newNN = NeuralNetwork_Copy(nn);
-                if (newNN == NULL)
-                {
-                    fprintf(stderr, "Failed to copy NeuralNetwork !\n");
-                    return false;
-                }
-
-                freeNeuralNetwork(map.cells[i]->nn);
-                map.cells[i]->nn = newNN;
+                fprintf(stderr, "Failed to copy NeuralNetwork !\n");
+                return false;
             }
+            map.population.networkChanged[i] = true;
         }
         printf("Neural network loaded !\n");
     }
@@ -292,8 +192,8 @@ bool Game_start(SDL_Window *window, SDL_Renderer *renderer, int w, int h)
     // Clean up graph window
     GraphWindow_Destroy(&map);
 
-    // Free graph system
-    Graph_Free(&map.graphData);
+    // Free simulation state
+    Game_destroy(&map);
 
     return true;
 }
@@ -12,6 +12,12 @@ bool Game_exists(char *filename)
 
 bool Game_save(Map *map, char *filename)
 {
+    // A copy-on-write genome is written out dense
+    NeuralNetwork *nn = map->population.cells[map->currentBestCellIndex].nn;
+    if (!NeuralNetwork_Materialize(nn)) {
+        return false;
+    }
+
     FILE *file = fopen(filename, "w");
     if (file == NULL) {
         perror("Erreur en ouvrant le fichier");
@@ -23,7 +29,6 @@ bool Game_save(Map *map, char *filename)
     fprintf(file, "%ld %d\n", duration, map->generation);
 
     // Save the topology
-    NeuralNetwork *nn = map->cells[map->currentBestCellIndex]->nn;
     fprintf(file, "%d\n", nn->topologySize);
     for (int i = 0; i < nn->topologySize; i++) {
         fprintf(file, "%d ", nn->topology[i]);
@@ -32,16 +37,16 @@ bool Game_save(Map *map, char *filename)
 
     // Save the weights
     for (int i = 0; i < nn->topologySize - 1; i++) {
-        for (int j = 0; j < nn->layers[i]->neuronCount * nn->layers[i]->nextLayerNeuronCount; j++) {
-            fprintf(file, "%.10lf ", nn->layers[i]->weights[j]);
+        for (int j = 0; j < nn->layers[i].neuronCount * nn->layers[i].nextLayerNeuronCount; j++) {
+            fprintf(file, "%.10lf ", (double)NeuralParameter_Load(nn->layers[i].weights[j]));
         }
         fprintf(file, "\n");
     }
 
     // Save the biases
     for (int i = 0; i < nn->topologySize - 1; i++) {
-        for (int j = 0; j < nn->layers[i]->nextLayerNeuronCount; j++) {
-            fprintf(file, "%.10lf ", nn->layers[i]->biases[j]);
+        for (int j = 0; j < nn->layers[i].nextLayerNeuronCount; j++) {
+            fprintf(file, "%.10lf ", (double)NeuralParameter_Load(nn->layers[i].biases[j]));
         }
         fprintf(file, "\n");
     }
@@ -74,17 +79,20 @@ NeuralNetwork* Game_load(Map *map, char *filename)
     NeuralNetwork *nn = createNeuralNetwork(topology, topologySize);
     free(topology);
 
-    // Load the weights
+    // Load the weights (files are text, converted to the build's NeuralParameter)
+    double value;
     for (int i = 0; i < topologySize - 1; i++) {
-        for (int j = 0; j < nn->layers[i]->neuronCount * nn->layers[i]->nextLayerNeuronCount; j++) {
-            fscanf(file, "%lf", &nn->layers[i]->weights[j]);
+        for (int j = 0; j < nn->layers[i].neuronCount * nn->layers[i].nextLayerNeuronCount; j++) {
+            fscanf(file, "%lf", &value);
+            nn->layers[i].weights[j] = NeuralParameter_Store((NeuralScalar)value);
         }
     }
 
     // Load the biases
     for (int i = 0; i < topologySize - 1; i++) {
-        for (int j = 0; j < nn->layers[i]->nextLayerNeuronCount; j++) {
-            fscanf(file, "%lf", &nn->layers[i]->biases[j]);
+        for (int j = 0; j < nn->layers[i].nextLayerNeuronCount; j++) {
+            fscanf(file, "%lf", &value);
+            nn->layers[i].biases[j] = NeuralParameter_Store((NeuralScalar)value);
         }
     }
 
@@ -1,4 +1,5 @@
 #include <math.h>
+#include <stdlib.h>
 
 #ifdef HAVE_OPENMP
 #include <omp.h>
@@ -7,6 +8,32 @@
 #include "../../../include/core/game.h"
 #include "../../../include/system/performance.h"
 
+// Make sure every thread has its own inference workspace
+static bool reserve_workspaces(Map *map, int threadCount)
+{
+    if (threadCount <= map->workspaceCount)
+        return true;
+
+    NeuralWorkspace *workspaces = realloc(map->workspaces, threadCount * sizeof(NeuralWorkspace));
+    if (workspaces == NULL) {
+        fprintf(stderr, "Failed to allocate memory for inference workspaces!\n");
+        return false;
+    }
+    map->workspaces = workspaces;
+
+    int topology[] = NEURAL_NETWORK_TOPOLOGY;
+    int width = 0;
+    for (int i = 1; i < (int)(sizeof(topology) / sizeof(topology[0])); i++)
+        width = MAX(width, topology[i]);
+
+    for (int t = map->workspaceCount; t < threadCount; t++) {
+        if (!NeuralWorkspace_Init(&map->workspaces[t], width))
+            return false;
+        map->workspaceCount++;
+    }
+    return true;
+}
+
 void Game_update(Map *map)
 {
     if (!map->isRunning)
@@ -26,35 +53,40 @@ void Game_update(Map *map)
     }
     lastUPSTime = currentUPSTime;
 
-    // Update cells - Parallelized with OpenMP (if enabled)
+    Population *population = &map->population;
+    Population_UpdateAlive(population);
+
+    // Snapshot foods and living cells: the sense phase only sees this frozen copy
+    SpatialGrid_Rebuild(&map->grid, map);
+
+    // Sense and think - Parallelized with OpenMP (if enabled)
+    // Each cell reads the snapshot and writes nothing but its own slot, so the
+    // result does not depend on the thread schedule
+    bool parallel = false;
 #ifdef HAVE_OPENMP
-    if (map->useMultithreading) {
-        #pragma omp parallel for
-        for (int i = 0; i < map->cellCount; ++i) {
-            if (map->cells[i] != NULL) {
-                PERF_MEASURE(PERF_CELL_UPDATE) {
-                    Cell_update(map->cells[i], map);
-                }
-            }
-        }
-    } else {
+    // One birth queue per thread, so recording needs no lock
+    parallel = map->useMultithreading && Births_Reserve(&map->births, omp_get_max_threads()) &&
+               reserve_workspaces(map, omp_get_max_threads());
 #endif
-        for (int i = 0; i < map->cellCount; ++i) {
-            if (map->cells[i] != NULL) {
-                PERF_MEASURE(PERF_CELL_UPDATE) {
-                    Cell_update(map->cells[i], map);
-                }
-            }
-        }
-#ifdef HAVE_OPENMP
+    if (parallel || reserve_workspaces(map, 1)) {
+        Inference_Think(map, parallel);
     }
-#endif
+
+    // Move every cell with the heading and speed it just decided
+    Cell_move(population, map);
+
+    // Apply - food consumption and births touch shared state, so they run in cell order
+    for (int k = 0; k < population->aliveCount; ++k)
+        Cell_act(population, population->aliveIndex[k], map);
+
+    // Births last, so newborns are only updated from the next tick
+    Births_Apply(&map->births, map);
 
     // Check generation
     bool allDead = true;
-    for (int i = 0; i < map->cellCount; ++i)
+    for (int i = 0; i < population->count; ++i)
     {
-        if (map->cells[i] != NULL && map->cells[i]->isAlive)
+        if (population->alive[i])
         {
             allDead = false;
             break;
@@ -67,35 +99,28 @@ void Game_update(Map *map)
 
     // Update best cell
     int bestCellIndex = 0;
-    for (int i = 0; i < map->cellCount; ++i)
+    for (int i = 0; i < population->count; ++i)
     {
-        if (map->cells[i] == NULL || map->cells[bestCellIndex] == NULL)
-            continue;
-        if (map->cells[i]->score > map->cells[bestCellIndex]->score)
+        if (population->score[i] > population->score[bestCellIndex])
             bestCellIndex = i;
     }
     map->currentBestCellIndex = bestCellIndex;
 
-    if (map->cells[bestCellIndex]->score > map->bestCellEver->score)
+    if (population->score[bestCellIndex] > map->bestCellEver.score)
     {
-        NeuralNetwork *bestNN = NeuralNetwork_Copy(map->cells[bestCellIndex]->nn);
-        if (bestNN != NULL)
-        {
-            freeNeuralNetwork(map->bestCellEver->nn);
-            map->bestCellEver->nn = bestNN;
-        }
+        NeuralNetwork_Assign(&map->bestCellEver.nn, population->cells[bestCellIndex].nn);
 
-        map->bestCellEver->score = map->cells[bestCellIndex]->score;
-        map->bestCellEver->generation = map->generation;
+        map->bestCellEver.score = population->score[bestCellIndex];
+        map->bestCellEver.generation = map->generation;
     }
 
     // Update oldest cell
-    Cell *oldestCell = map->cells[0];
-    for (int i = 0; i < map->cellCount; ++i)
-        if (map->cells[i] != NULL && map->cells[i]->generation > oldestCell->generation)
-            oldestCell = map->cells[i];
-    if (oldestCell->generation > map->maxGeneration)
-        map->maxGeneration = oldestCell->generation;
+    int oldestGeneration = population->generation[0];
+    for (int i = 0; i < population->count; ++i)
+        if (population->generation[i] > oldestGeneration)
+            oldestGeneration = population->generation[i];
+    if (oldestGeneration > map->maxGeneration)
+        map->maxGeneration = oldestGeneration;
 
     // Check graph timeout
     Graph_CheckTimeout(&map->graphData, map);
@@ -0,0 +1,77 @@
+/**
+ * @file population.c
+ * @brief Implementation of the structure-of-arrays cell storage
+ */
+
+#include "../../include/core/population.h"
+#include "../../include/entities/cell.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool Population_Init(Population *population, int capacity)
+{
+    if (population == NULL) return false;
+
+    memset(population, 0, sizeof(Population));
+    population->capacity = capacity;
+
+    population->x = calloc(capacity, sizeof(float));
+    population->y = calloc(capacity, sizeof(float));
+    population->angle = calloc(capacity, sizeof(float));
+    population->speed = calloc(capacity, sizeof(float));
+    population->health = calloc(capacity, sizeof(int));
+    population->score = calloc(capacity, sizeof(int));
+    population->generation = calloc(capacity, sizeof(int));
+    population->alive = calloc(capacity, sizeof(bool));
+    population->networkChanged = calloc(capacity, sizeof(bool));
+    population->aliveIndex = calloc(capacity, sizeof(int));
+    population->cells = calloc(capacity, sizeof(Cell));
+
+    int topology[] = NEURAL_NETWORK_TOPOLOGY;
+    bool poolReady = NeuralPool_Init(&population->networks, topology, sizeof(topology) / sizeof(topology[0]));
+
+    if (!poolReady || population->x == NULL || population->y == NULL || population->angle == NULL ||
+        population->speed == NULL || population->health == NULL || population->score == NULL ||
+        population->generation == NULL || population->alive == NULL || population->networkChanged == NULL ||
+        population->aliveIndex == NULL || population->cells == NULL) {
+        fprintf(stderr, "Failed to allocate memory for population!\n");
+        Population_Free(population);
+        return false;
+    }
+
+    return true;
+}
+
+void Population_Free(Population *population)
+{
+    if (population == NULL) return;
+
+    if (population->cells != NULL) {
+        for (int i = 0; i < population->count; i++)
+            Cell_destroy(population, i);
+    }
+    NeuralPool_Free(&population->networks);
+
+    free(population->x);
+    free(population->y);
+    free(population->angle);
+    free(population->speed);
+    free(population->health);
+    free(population->score);
+    free(population->generation);
+    free(population->alive);
+    free(population->networkChanged);
+    free(population->aliveIndex);
+    free(population->cells);
+    memset(population, 0, sizeof(Population));
+}
+
+void Population_UpdateAlive(Population *population)
+{
+    int aliveCount = 0;
+    for (int i = 0; i < population->count; i++) {
+        if (population->alive[i])
+            population->aliveIndex[aliveCount++] = i;
+    }
+    population->aliveCount = aliveCount;
+}
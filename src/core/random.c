@@ -0,0 +1,227 @@
+/**
+ * @file random.c
+ * @brief xoshiro256** streams seeded with splitmix64
+ */
+
+#include "../../include/core/random.h"
+#include "../../include/system/cpu_features.h"
+#include <stdbool.h>
+
+#if CPU_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+typedef void (*FillKernel)(uint64_t state[4][RANDOM_FILL_LANES], double *values, int count);
+
+static FillKernel g_fill = NULL;
+
+static Rng g_main;
+static uint64_t g_seed = RANDOM_DEFAULT_SEED;
+static uint64_t g_nextStream = 1;   // Stream 0 is the main stream
+static bool g_seeded = false;
+
+
+// ============================================================================
+// Scalar generator
+// ============================================================================
+
+static inline uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t splitmix64(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Top 52 bits as the mantissa of a double in [1, 2), minus one
+static inline double bits_to_unit(uint64_t x)
+{
+    union { uint64_t u; double d; } bits = { (x >> 12) | 0x3FF0000000000000ULL };
+    return bits.d - 1.0;
+}
+
+void Rng_Seed(Rng *rng, uint64_t seed, uint64_t stream)
+{
+    uint64_t state = seed;
+    state = splitmix64(&state) ^ (stream * 0xD1B54A32D192ED03ULL);
+    for (int i = 0; i < 4; i++)
+        rng->s[i] = splitmix64(&state);
+
+    // All-zero is the one state xoshiro never leaves
+    if ((rng->s[0] | rng->s[1] | rng->s[2] | rng->s[3]) == 0)
+        rng->s[0] = 1;
+}
+
+uint64_t Rng_Next(Rng *rng)
+{
+    uint64_t *s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+double Rng_Double(Rng *rng)
+{
+    return (Rng_Next(rng) >> 11) * 0x1.0p-53;
+}
+
+double Rng_Range(Rng *rng, double min, double max)
+{
+    return min + (max - min) * Rng_Double(rng);
+}
+
+int Rng_Int(Rng *rng, int min, int max)
+{
+    // Multiply-shift of the high bits: no division, no visible bias at 32 bits
+    uint64_t span = (uint64_t)((int64_t)max - (int64_t)min) + 1;
+    return (int)((int64_t)min + (int64_t)(((Rng_Next(rng) >> 32) * span) >> 32));
+}
+
+
+// ============================================================================
+// Bulk kernels: state[word][lane], values[i] comes from lane i % RANDOM_FILL_LANES
+// ============================================================================
+
+static void fill_scalar(uint64_t state[4][RANDOM_FILL_LANES], double *values, int count)
+{
+    for (int i = 0; i < count; i += RANDOM_FILL_LANES)
+    {
+        for (int l = 0; l < RANDOM_FILL_LANES; l++)
+        {
+            uint64_t s1 = state[1][l];
+            uint64_t result = rotl(s1 * 5, 7) * 9;
+            uint64_t t = s1 << 17;
+
+            state[2][l] ^= state[0][l];
+            state[3][l] ^= s1;
+            state[1][l] ^= state[2][l];
+            state[0][l] ^= state[3][l];
+            state[2][l] ^= t;
+            state[3][l] = rotl(state[3][l], 45);
+
+            if (i + l < count)
+                values[i + l] = bits_to_unit(result);
+        }
+    }
+}
+
+#if CPU_HAS_X86_SIMD
+
+#define avx_rotl(x, k) _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - (k)))
+
+__attribute__((target("avx2")))
+static void fill_avx2(uint64_t state[4][RANDOM_FILL_LANES], double *values, int count)
+{
+    __m256i s0 = _mm256_loadu_si256((const __m256i *)state[0]);
+    __m256i s1 = _mm256_loadu_si256((const __m256i *)state[1]);
+    __m256i s2 = _mm256_loadu_si256((const __m256i *)state[2]);
+    __m256i s3 = _mm256_loadu_si256((const __m256i *)state[3]);
+    const __m256i exponent = _mm256_set1_epi64x(0x3FF0000000000000LL);
+    const __m256d one = _mm256_set1_pd(1.0);
+
+    for (int i = 0; i < count; i += RANDOM_FILL_LANES)
+    {
+        // AVX2 has no 64-bit multiply: x * 5 and x * 9 as shifts and adds
+        __m256i times5 = _mm256_add_epi64(s1, _mm256_slli_epi64(s1, 2));
+        __m256i rotated = avx_rotl(times5, 7);
+        __m256i result = _mm256_add_epi64(rotated, _mm256_slli_epi64(rotated, 3));
+        __m256i t = _mm256_slli_epi64(s1, 17);
+
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = avx_rotl(s3, 45);
+
+        __m256i mantissa = _mm256_or_si256(_mm256_srli_epi64(result, 12), exponent);
+        __m256d unit = _mm256_sub_pd(_mm256_castsi256_pd(mantissa), one);
+        if (i + RANDOM_FILL_LANES <= count)
+            _mm256_storeu_pd(&values[i], unit);
+        else
+        {
+            double tail[RANDOM_FILL_LANES];
+            _mm256_storeu_pd(tail, unit);
+            for (int l = 0; i + l < count; l++)
+                values[i + l] = tail[l];
+        }
+    }
+
+    _mm256_storeu_si256((__m256i *)state[0], s0);
+    _mm256_storeu_si256((__m256i *)state[1], s1);
+    _mm256_storeu_si256((__m256i *)state[2], s2);
+    _mm256_storeu_si256((__m256i *)state[3], s3);
+}
+
+#endif // CPU_HAS_X86_SIMD
+
+// First call only, from serial code like every other user of the streams
+static void select_fill(void)
+{
+    g_fill = fill_scalar;
+#if CPU_HAS_X86_SIMD
+    if (CpuFeatures_Get()->avx2)
+        g_fill = fill_avx2;
+#endif
+}
+
+void Rng_Fill(Rng *rng, double *values, int count)
+{
+    if (g_fill == NULL)
+        select_fill();
+
+    uint64_t state[4][RANDOM_FILL_LANES];
+    for (int l = 0; l < RANDOM_FILL_LANES; l++)
+    {
+        uint64_t laneSeed = Rng_Next(rng);
+        for (int w = 0; w < 4; w++)
+            state[w][l] = splitmix64(&laneSeed);
+    }
+
+    g_fill(state, values, count);
+}
+
+
+// ============================================================================
+// Run streams
+// ============================================================================
+
+void Random_Seed(uint64_t seed)
+{
+    g_seed = seed;
+    g_nextStream = 1;
+    Rng_Seed(&g_main, seed, 0);
+    g_seeded = true;
+}
+
+uint64_t Random_GetSeed(void)
+{
+    return g_seed;
+}
+
+Rng *Random_Main(void)
+{
+    if (!g_seeded)
+        Random_Seed(RANDOM_DEFAULT_SEED);
+    return &g_main;
+}
+
+void Random_NewStream(Rng *rng)
+{
+    if (!g_seeded)
+        Random_Seed(RANDOM_DEFAULT_SEED);
+    Rng_Seed(rng, g_seed, g_nextStream++);
+}
@@ -0,0 +1,378 @@
+/**
+ * @file spatial_grid.c
+ * @brief Implementation of the uniform grid used by ray sensing
+ */
+
+#include "../../include/core/spatial_grid.h"
+#include "../../include/core/game.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Objects are inserted slightly inflated so a hit exactly on a bucket border is never missed
+#define SPATIAL_GRID_EPSILON 0.5f
+
+static int clamp_bucket(float coordinate, int count)
+{
+    int bucket = (int)floorf(coordinate / SPATIAL_GRID_BUCKET_SIZE);
+    if (bucket < 0) return 0;
+    if (bucket >= count) return count - 1;
+    return bucket;
+}
+
+static void bucket_range(const SpatialGrid *grid, const SDL_FRect *rect, int *x0, int *y0, int *x1, int *y1)
+{
+    *x0 = clamp_bucket(rect->x - SPATIAL_GRID_EPSILON - grid->originX, grid->cols);
+    *y0 = clamp_bucket(rect->y - SPATIAL_GRID_EPSILON - grid->originY, grid->rows);
+    *x1 = clamp_bucket(rect->x + rect->w + SPATIAL_GRID_EPSILON - grid->originX, grid->cols);
+    *y1 = clamp_bucket(rect->y + rect->h + SPATIAL_GRID_EPSILON - grid->originY, grid->rows);
+}
+
+// Padding entries sit far outside the world, so every kernel misses them
+#define SPATIAL_GRID_PADDING_POSITION -1.0e9f
+
+// Only the buckets are counted here, the item totals are derived from the offsets
+static void count_item(int *bucketStart, const SpatialGrid *grid, const SDL_FRect *rect)
+{
+    int x0, y0, x1, y1;
+    bucket_range(grid, rect, &x0, &y0, &x1, &y1);
+    for (int by = y0; by <= y1; by++)
+        for (int bx = x0; bx <= x1; bx++)
+            bucketStart[by * grid->cols + bx + 1]++;
+}
+
+// Turn per-bucket counts into offsets, each bucket padded to a multiple of the lane width
+static int prefix_padded(int *bucketStart, int *bucketFill, int bucketCount, int lanes)
+{
+    for (int b = 0; b < bucketCount; b++) {
+        int count = bucketStart[b + 1];
+        int padded = (count + lanes - 1) / lanes * lanes;
+        bucketStart[b + 1] = bucketStart[b] + padded;
+        bucketFill[b] = bucketStart[b];
+    }
+    return bucketStart[bucketCount];
+}
+
+static void free_boxes(SpatialGridBoxes *boxes)
+{
+    free(boxes->minX);
+    free(boxes->minY);
+    free(boxes->maxX);
+    free(boxes->maxY);
+    free(boxes->value);
+    free(boxes->index);
+    boxes->minX = boxes->minY = boxes->maxX = boxes->maxY = boxes->value = NULL;
+    boxes->index = NULL;
+    boxes->count = 0;
+    boxes->capacity = 0;
+}
+
+static void free_circles(SpatialGridCircles *circles)
+{
+    free(circles->centerX);
+    free(circles->centerY);
+    free(circles->radius);
+    free(circles->value);
+    free(circles->index);
+    circles->centerX = circles->centerY = circles->radius = circles->value = NULL;
+    circles->index = NULL;
+    circles->count = 0;
+    circles->capacity = 0;
+}
+
+// Contents are rebuilt every tick, so growing does not need to preserve them
+static bool reserve_boxes(SpatialGridBoxes *boxes, int capacity)
+{
+    if (capacity <= boxes->capacity)
+        return true;
+
+    free_boxes(boxes);
+    boxes->minX = malloc(capacity * sizeof(float));
+    boxes->minY = malloc(capacity * sizeof(float));
+    boxes->maxX = malloc(capacity * sizeof(float));
+    boxes->maxY = malloc(capacity * sizeof(float));
+    boxes->value = malloc(capacity * sizeof(float));
+    boxes->index = malloc(capacity * sizeof(int));
+    if (boxes->minX == NULL || boxes->minY == NULL || boxes->maxX == NULL ||
+        boxes->maxY == NULL || boxes->value == NULL || boxes->index == NULL) {
+        fprintf(stderr, "Failed to allocate memory for spatial grid foods!\n");
+        free_boxes(boxes);
+        return false;
+    }
+
+    boxes->capacity = capacity;
+    return true;
+}
+
+static bool reserve_circles(SpatialGridCircles *circles, int capacity)
+{
+    if (capacity <= circles->capacity)
+        return true;
+
+    free_circles(circles);
+    circles->centerX = malloc(capacity * sizeof(float));
+    circles->centerY = malloc(capacity * sizeof(float));
+    circles->radius = malloc(capacity * sizeof(float));
+    circles->value = malloc(capacity * sizeof(float));
+    circles->index = malloc(capacity * sizeof(int));
+    if (circles->centerX == NULL || circles->centerY == NULL || circles->radius == NULL ||
+        circles->value == NULL || circles->index == NULL) {
+        fprintf(stderr, "Failed to allocate memory for spatial grid cells!\n");
+        free_circles(circles);
+        return false;
+    }
+
+    circles->capacity = capacity;
+    return true;
+}
+
+static void insert_box(SpatialGrid *grid, int index, const SDL_FRect *rect, float value)
+{
+    SpatialGridBoxes *boxes = &grid->foods;
+    int x0, y0, x1, y1;
+    bucket_range(grid, rect, &x0, &y0, &x1, &y1);
+    for (int by = y0; by <= y1; by++) {
+        for (int bx = x0; bx <= x1; bx++) {
+            int j = boxes->bucketFill[by * grid->cols + bx]++;
+            boxes->minX[j] = rect->x;
+            boxes->minY[j] = rect->y;
+            boxes->maxX[j] = rect->x + rect->w;
+            boxes->maxY[j] = rect->y + rect->h;
+            boxes->value[j] = value;
+            boxes->index[j] = index;
+        }
+    }
+}
+
+static void insert_circle(SpatialGrid *grid, int index, const SDL_FRect *rect, float value)
+{
+    SpatialGridCircles *circles = &grid->cells;
+    float radius = rect->w * 0.5f;
+    int x0, y0, x1, y1;
+    bucket_range(grid, rect, &x0, &y0, &x1, &y1);
+    for (int by = y0; by <= y1; by++) {
+        for (int bx = x0; bx <= x1; bx++) {
+            int j = circles->bucketFill[by * grid->cols + bx]++;
+            circles->centerX[j] = rect->x + radius;
+            circles->centerY[j] = rect->y + radius;
+            circles->radius[j] = radius;
+            circles->value[j] = value;
+            circles->index[j] = index;
+        }
+    }
+}
+
+// Square around a cell, the grid stores it as the inscribed circle
+static SDL_FRect cell_hitbox(const Population *population, int index)
+{
+    int radius = population->cells[index].radius;
+    return (SDL_FRect) {
+        population->x[index] - radius, population->y[index] - radius,
+        radius * 2, radius * 2
+    };
+}
+
+// Fill the end of every bucket with entries no ray can hit
+static void pad_buckets(SpatialGrid *grid, int bucketCount)
+{
+    SpatialGridBoxes *boxes = &grid->foods;
+    SpatialGridCircles *circles = &grid->cells;
+
+    for (int b = 0; b < bucketCount; b++) {
+        for (int j = boxes->bucketFill[b]; j < boxes->bucketStart[b + 1]; j++) {
+            boxes->minX[j] = boxes->maxX[j] = SPATIAL_GRID_PADDING_POSITION;
+            boxes->minY[j] = boxes->maxY[j] = SPATIAL_GRID_PADDING_POSITION;
+            boxes->value[j] = 0.0f;
+            boxes->index[j] = -1;
+        }
+        for (int j = circles->bucketFill[b]; j < circles->bucketStart[b + 1]; j++) {
+            circles->centerX[j] = circles->centerY[j] = SPATIAL_GRID_PADDING_POSITION;
+            circles->radius[j] = 0.0f;
+            circles->value[j] = 0.0f;
+            circles->index[j] = -1;
+        }
+    }
+}
+
+bool SpatialGrid_Init(SpatialGrid *grid, int worldWidth, int worldHeight)
+{
+    if (grid == NULL) return false;
+
+    memset(grid, 0, sizeof(SpatialGrid));
+    grid->worldWidth = worldWidth;
+    grid->worldHeight = worldHeight;
+    grid->originX = -SPATIAL_GRID_MARGIN;
+    grid->originY = -SPATIAL_GRID_MARGIN;
+    grid->cols = (int)ceilf((worldWidth + 2.0f * SPATIAL_GRID_MARGIN) / SPATIAL_GRID_BUCKET_SIZE);
+    grid->rows = (int)ceilf((worldHeight + 2.0f * SPATIAL_GRID_MARGIN) / SPATIAL_GRID_BUCKET_SIZE);
+    grid->lanes = 1;
+
+    int bucketCount = grid->cols * grid->rows;
+    grid->foods.bucketStart = calloc(bucketCount + 1, sizeof(int));
+    grid->foods.bucketFill = malloc(bucketCount * sizeof(int));
+    grid->cells.bucketStart = calloc(bucketCount + 1, sizeof(int));
+    grid->cells.bucketFill = malloc(bucketCount * sizeof(int));
+    if (grid->foods.bucketStart == NULL || grid->foods.bucketFill == NULL ||
+        grid->cells.bucketStart == NULL || grid->cells.bucketFill == NULL) {
+        fprintf(stderr, "Failed to allocate memory for spatial grid!\n");
+        SpatialGrid_Free(grid);
+        return false;
+    }
+
+    // Objects are smaller than a bucket, so each one overlaps at most 4 buckets
+    if (!reserve_boxes(&grid->foods, MEM_FOOD_COUNT * 4) ||
+        !reserve_circles(&grid->cells, MEM_CELL_COUNT * 4)) {
+        SpatialGrid_Free(grid);
+        return false;
+    }
+
+    return true;
+}
+
+void SpatialGrid_Free(SpatialGrid *grid)
+{
+    if (grid == NULL) return;
+
+    free(grid->foods.bucketStart);
+    free(grid->foods.bucketFill);
+    free(grid->cells.bucketStart);
+    free(grid->cells.bucketFill);
+    free_boxes(&grid->foods);
+    free_circles(&grid->cells);
+    memset(grid, 0, sizeof(SpatialGrid));
+}
+
+void SpatialGrid_Rebuild(SpatialGrid *grid, Map *map)
+{
+    // The map follows the window size, so the buckets may have to be reallocated
+    if (grid->foods.bucketStart == NULL || grid->worldWidth != map->width || grid->worldHeight != map->height) {
+        SpatialGrid_Free(grid);
+        if (!SpatialGrid_Init(grid, map->width, map->height))
+            return;
+    }
+
+    grid->lanes = SpatialGrid_KernelLanes();
+
+    int bucketCount = grid->cols * grid->rows;
+    memset(grid->foods.bucketStart, 0, (bucketCount + 1) * sizeof(int));
+    memset(grid->cells.bucketStart, 0, (bucketCount + 1) * sizeof(int));
+
+    // Pass 1: count items per bucket
+    for (int i = 0; i < GAME_START_FOOD_COUNT; i++) {
+        if (map->foods[i] != NULL)
+            count_item(grid->foods.bucketStart, grid, &map->foods[i]->rect);
+    }
+    const Population *population = &map->population;
+    for (int k = 0; k < population->aliveCount; k++) {
+        SDL_FRect hitbox = cell_hitbox(population, population->aliveIndex[k]);
+        count_item(grid->cells.bucketStart, grid, &hitbox);
+    }
+
+    // Pass 2: prefix sum into padded bucket offsets
+    int foodTotal = prefix_padded(grid->foods.bucketStart, grid->foods.bucketFill, bucketCount, grid->lanes);
+    int cellTotal = prefix_padded(grid->cells.bucketStart, grid->cells.bucketFill, bucketCount, grid->lanes);
+
+    if (!reserve_boxes(&grid->foods, foodTotal) || !reserve_circles(&grid->cells, cellTotal)) {
+        // Leave an empty grid: rays simply see nothing this tick
+        memset(grid->foods.bucketStart, 0, (bucketCount + 1) * sizeof(int));
+        memset(grid->cells.bucketStart, 0, (bucketCount + 1) * sizeof(int));
+        grid->foods.count = 0;
+        grid->cells.count = 0;
+        return;
+    }
+
+    // Pass 3: scatter object snapshots into their buckets
+    for (int i = 0; i < GAME_START_FOOD_COUNT; i++) {
+        if (map->foods[i] != NULL)
+            insert_box(grid, i, &map->foods[i]->rect, (float)map->foods[i]->value);
+    }
+    for (int k = 0; k < population->aliveCount; k++) {
+        int i = population->aliveIndex[k];
+        SDL_FRect hitbox = cell_hitbox(population, i);
+        insert_circle(grid, i, &hitbox, (float)population->health[i]);
+    }
+    pad_buckets(grid, bucketCount);
+
+    grid->foods.count = foodTotal;
+    grid->cells.count = cellTotal;
+}
+
+void SpatialGrid_BeginRay(const SpatialGrid *grid, SpatialGridRayWalk *walk, const SpatialGridRay *ray)
+{
+    float dirX = ray->dirX;
+    float dirY = ray->dirY;
+
+    walk->grid = grid;
+    walk->maxDistance = ray->maxDistance;
+    walk->done = true;
+
+    if (grid->foods.bucketStart == NULL || (grid->foods.count == 0 && grid->cells.count == 0))
+        return;
+
+    // Origin in bucket units (cell positions are always wrapped inside the map)
+    float fx = (ray->originX - grid->originX) / SPATIAL_GRID_BUCKET_SIZE;
+    float fy = (ray->originY - grid->originY) / SPATIAL_GRID_BUCKET_SIZE;
+    if (fx < 0.0f || fy < 0.0f || fx >= grid->cols || fy >= grid->rows)
+        return;
+
+    walk->bucketX = (int)fx;
+    walk->bucketY = (int)fy;
+    walk->done = false;
+
+    if (dirX > 0.0f) {
+        walk->stepX = 1;
+        walk->tDeltaX = SPATIAL_GRID_BUCKET_SIZE / dirX;
+        walk->tMaxX = (walk->bucketX + 1 - fx) * walk->tDeltaX;
+    } else if (dirX < 0.0f) {
+        walk->stepX = -1;
+        walk->tDeltaX = SPATIAL_GRID_BUCKET_SIZE / -dirX;
+        walk->tMaxX = (fx - walk->bucketX) * walk->tDeltaX;
+    } else {
+        walk->stepX = 0;
+        walk->tDeltaX = FLT_MAX;
+        walk->tMaxX = FLT_MAX;
+    }
+
+    if (dirY > 0.0f) {
+        walk->stepY = 1;
+        walk->tDeltaY = SPATIAL_GRID_BUCKET_SIZE / dirY;
+        walk->tMaxY = (walk->bucketY + 1 - fy) * walk->tDeltaY;
+    } else if (dirY < 0.0f) {
+        walk->stepY = -1;
+        walk->tDeltaY = SPATIAL_GRID_BUCKET_SIZE / -dirY;
+        walk->tMaxY = (fy - walk->bucketY) * walk->tDeltaY;
+    } else {
+        walk->stepY = 0;
+        walk->tDeltaY = FLT_MAX;
+        walk->tMaxY = FLT_MAX;
+    }
+}
+
+bool SpatialGrid_NextBucket(SpatialGridRayWalk *walk, int *bucket, float *exitDistance)
+{
+    if (walk->done)
+        return false;
+
+    const SpatialGrid *grid = walk->grid;
+    *bucket = walk->bucketY * grid->cols + walk->bucketX;
+
+    float exit = fminf(walk->tMaxX, walk->tMaxY);
+    if (exit >= walk->maxDistance) {
+        exit = walk->maxDistance;
+        walk->done = true;
+    } else if (walk->tMaxX < walk->tMaxY) {
+        walk->bucketX += walk->stepX;
+        walk->tMaxX += walk->tDeltaX;
+        if (walk->bucketX < 0 || walk->bucketX >= grid->cols)
+            walk->done = true;
+    } else {
+        walk->bucketY += walk->stepY;
+        walk->tMaxY += walk->tDeltaY;
+        if (walk->bucketY < 0 || walk->bucketY >= grid->rows)
+            walk->done = true;
+    }
+
+    *exitDistance = exit;
+    return true;
+}
@@ -0,0 +1,414 @@
+/**
+ * @file spatial_grid_kernels.c
+ * @brief Packet ray kernels over the structure-of-arrays grid buckets
+ *
+ * Each kernel tests one ray against a bucket range and returns the closest hit.
+ * The SIMD versions test 4 (SSE) or 8 (AVX2) obstacles per instruction; bucket
+ * ranges are padded to the lane width so they never need a scalar tail.
+ */
+
+#include "../../include/core/spatial_grid.h"
+#include "../../include/system/cpu_features.h"
+#include <math.h>
+
+#if CPU_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+typedef bool (*ClosestBoxKernel)(const SpatialGridBoxes *boxes, const SpatialGridRay *ray,
+                                 int first, int last, float *closestDistance, int *hit);
+typedef bool (*ClosestCircleKernel)(const SpatialGridCircles *circles, const SpatialGridRay *ray,
+                                    int first, int last, int skipIndex, float *closestDistance, int *hit);
+
+static ClosestBoxKernel g_closestBox = NULL;
+static ClosestCircleKernel g_closestCircle = NULL;
+static int g_lanes = 1;
+static const char *g_kernelName = "scalar";
+
+
+// ============================================================================
+// Scalar kernels (reference and fallback)
+// ============================================================================
+
+// Slab test; a ray starting inside the box reports where it leaves it
+static bool closest_box_scalar(const SpatialGridBoxes *boxes, const SpatialGridRay *ray,
+                               int first, int last, float *closestDistance, int *hit)
+{
+    bool found = false;
+
+    for (int j = first; j < last; j++)
+    {
+        float tx1 = (boxes->minX[j] - ray->originX) * ray->invDirX;
+        float tx2 = (boxes->maxX[j] - ray->originX) * ray->invDirX;
+        float ty1 = (boxes->minY[j] - ray->originY) * ray->invDirY;
+        float ty2 = (boxes->maxY[j] - ray->originY) * ray->invDirY;
+
+        // fminf/fmaxf drop the NaN produced when the origin lies on an axis-aligned edge
+        float tNear = fmaxf(fminf(tx1, tx2), fminf(ty1, ty2));
+        float tFar = fminf(fmaxf(tx1, tx2), fmaxf(ty1, ty2));
+        if (tFar < 0.0f || tNear > tFar)
+            continue;
+
+        float t = (tNear >= 0.0f) ? tNear : tFar;
+        if (t > ray->maxDistance || t >= *closestDistance)
+            continue;
+
+        *closestDistance = t;
+        *hit = j;
+        found = true;
+    }
+
+    return found;
+}
+
+// Exact ray/circle test; a ray starting inside the circle reports where it leaves it
+static bool closest_circle_scalar(const SpatialGridCircles *circles, const SpatialGridRay *ray,
+                                  int first, int last, int skipIndex, float *closestDistance, int *hit)
+{
+    bool found = false;
+
+    for (int j = first; j < last; j++)
+    {
+        if (circles->index[j] == skipIndex)
+            continue;
+
+        float lx = circles->centerX[j] - ray->originX;
+        float ly = circles->centerY[j] - ray->originY;
+        float tc = lx * ray->dirX + ly * ray->dirY;
+        float lengthSq = lx * lx + ly * ly;
+        float radiusSq = circles->radius[j] * circles->radius[j];
+        bool inside = lengthSq <= radiusSq;
+
+        // Everything stays squared until the circle is known to be a closer hit
+        if (!inside && (tc < 0.0f || tc - circles->radius[j] >= *closestDistance))
+            continue;
+
+        float perpendicularSq = lengthSq - tc * tc;
+        if (perpendicularSq > radiusSq)
+            continue;
+
+        float halfChord = sqrtf(radiusSq - perpendicularSq);
+        float t = inside ? tc + halfChord : tc - halfChord;
+        if (t > ray->maxDistance || t >= *closestDistance)
+            continue;
+
+        *closestDistance = t;
+        *hit = j;
+        found = true;
+    }
+
+    return found;
+}
+
+
+#if CPU_HAS_X86_SIMD
+
+// Infinite inverse directions would turn 0 * inf into NaN, which min/max
+// instructions do not drop like fminf/fmaxf; a huge finite value acts the same
+static float finite_inverse(float inverse)
+{
+    if (inverse > 1.0e30f) return 1.0e30f;
+    if (inverse < -1.0e30f) return -1.0e30f;
+    return inverse;
+}
+
+// Pick the closest lane, lowest position on ties so results do not depend on the lane width
+static bool reduce_lanes(const float *distances, const int *positions, int lanes, float *closestDistance, int *hit)
+{
+    bool found = false;
+
+    for (int l = 0; l < lanes; l++)
+    {
+        if (positions[l] < 0)
+            continue;
+        if (!found || distances[l] < *closestDistance ||
+            (distances[l] == *closestDistance && positions[l] < *hit))
+        {
+            *closestDistance = distances[l];
+            *hit = positions[l];
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+
+// ============================================================================
+// SSE kernels (4 obstacles per instruction)
+// ============================================================================
+
+__attribute__((target("sse2")))
+static inline __m128 select_ps_sse(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+__attribute__((target("sse2")))
+static inline __m128i select_epi32_sse(__m128 mask, __m128i a, __m128i b)
+{
+    __m128i m = _mm_castps_si128(mask);
+    return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+__attribute__((target("sse2")))
+static bool closest_box_sse(const SpatialGridBoxes *boxes, const SpatialGridRay *ray,
+                            int first, int last, float *closestDistance, int *hit)
+{
+    const __m128 originX = _mm_set1_ps(ray->originX);
+    const __m128 originY = _mm_set1_ps(ray->originY);
+    const __m128 invDirX = _mm_set1_ps(finite_inverse(ray->invDirX));
+    const __m128 invDirY = _mm_set1_ps(finite_inverse(ray->invDirY));
+    const __m128 maxDistance = _mm_set1_ps(ray->maxDistance);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128i laneOffsets = _mm_setr_epi32(0, 1, 2, 3);
+
+    __m128 best = _mm_set1_ps(*closestDistance);
+    __m128i bestPosition = _mm_set1_epi32(-1);
+
+    for (int j = first; j < last; j += 4)
+    {
+        __m128 tx1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&boxes->minX[j]), originX), invDirX);
+        __m128 tx2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&boxes->maxX[j]), originX), invDirX);
+        __m128 ty1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&boxes->minY[j]), originY), invDirY);
+        __m128 ty2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&boxes->maxY[j]), originY), invDirY);
+
+        __m128 tNear = _mm_max_ps(_mm_min_ps(tx1, tx2), _mm_min_ps(ty1, ty2));
+        __m128 tFar = _mm_min_ps(_mm_max_ps(tx1, tx2), _mm_max_ps(ty1, ty2));
+        __m128 t = select_ps_sse(_mm_cmpge_ps(tNear, zero), tNear, tFar);
+
+        __m128 valid = _mm_and_ps(_mm_cmpge_ps(tFar, zero), _mm_cmple_ps(tNear, tFar));
+        valid = _mm_and_ps(valid, _mm_cmple_ps(t, maxDistance));
+        valid = _mm_and_ps(valid, _mm_cmplt_ps(t, best));
+
+        best = select_ps_sse(valid, t, best);
+        bestPosition = select_epi32_sse(valid, _mm_add_epi32(_mm_set1_epi32(j), laneOffsets), bestPosition);
+    }
+
+    float distances[4];
+    int positions[4];
+    _mm_storeu_ps(distances, best);
+    _mm_storeu_si128((__m128i *)positions, bestPosition);
+    return reduce_lanes(distances, positions, 4, closestDistance, hit);
+}
+
+__attribute__((target("sse2")))
+static bool closest_circle_sse(const SpatialGridCircles *circles, const SpatialGridRay *ray,
+                               int first, int last, int skipIndex, float *closestDistance, int *hit)
+{
+    const __m128 originX = _mm_set1_ps(ray->originX);
+    const __m128 originY = _mm_set1_ps(ray->originY);
+    const __m128 dirX = _mm_set1_ps(ray->dirX);
+    const __m128 dirY = _mm_set1_ps(ray->dirY);
+    const __m128 maxDistance = _mm_set1_ps(ray->maxDistance);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128i skip = _mm_set1_epi32(skipIndex);
+    const __m128i laneOffsets = _mm_setr_epi32(0, 1, 2, 3);
+
+    __m128 best = _mm_set1_ps(*closestDistance);
+    __m128i bestPosition = _mm_set1_epi32(-1);
+
+    for (int j = first; j < last; j += 4)
+    {
+        __m128 lx = _mm_sub_ps(_mm_loadu_ps(&circles->centerX[j]), originX);
+        __m128 ly = _mm_sub_ps(_mm_loadu_ps(&circles->centerY[j]), originY);
+        __m128 radius = _mm_loadu_ps(&circles->radius[j]);
+
+        __m128 tc = _mm_add_ps(_mm_mul_ps(lx, dirX), _mm_mul_ps(ly, dirY));
+        __m128 lengthSq = _mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly));
+        __m128 radiusSq = _mm_mul_ps(radius, radius);
+        __m128 inside = _mm_cmple_ps(lengthSq, radiusSq);
+        __m128 perpendicularSq = _mm_sub_ps(lengthSq, _mm_mul_ps(tc, tc));
+
+        __m128 halfChord = _mm_sqrt_ps(_mm_max_ps(_mm_sub_ps(radiusSq, perpendicularSq), zero));
+        __m128 t = select_ps_sse(inside, _mm_add_ps(tc, halfChord), _mm_sub_ps(tc, halfChord));
+
+        __m128i self = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)&circles->index[j]), skip);
+        __m128 valid = _mm_or_ps(inside, _mm_cmpge_ps(tc, zero));
+        valid = _mm_and_ps(valid, _mm_cmple_ps(perpendicularSq, radiusSq));
+        valid = _mm_and_ps(valid, _mm_cmple_ps(t, maxDistance));
+        valid = _mm_and_ps(valid, _mm_cmplt_ps(t, best));
+        valid = _mm_andnot_ps(_mm_castsi128_ps(self), valid);
+
+        best = select_ps_sse(valid, t, best);
+        bestPosition = select_epi32_sse(valid, _mm_add_epi32(_mm_set1_epi32(j), laneOffsets), bestPosition);
+    }
+
+    float distances[4];
+    int positions[4];
+    _mm_storeu_ps(distances, best);
+    _mm_storeu_si128((__m128i *)positions, bestPosition);
+    return reduce_lanes(distances, positions, 4, closestDistance, hit);
+}
+
+
+// ============================================================================
+// AVX2 kernels (8 obstacles per instruction)
+// ============================================================================
+
+__attribute__((target("avx2")))
+static bool closest_box_avx2(const SpatialGridBoxes *boxes, const SpatialGridRay *ray,
+                             int first, int last, float *closestDistance, int *hit)
+{
+    const __m256 originX = _mm256_set1_ps(ray->originX);
+    const __m256 originY = _mm256_set1_ps(ray->originY);
+    const __m256 invDirX = _mm256_set1_ps(finite_inverse(ray->invDirX));
+    const __m256 invDirY = _mm256_set1_ps(finite_inverse(ray->invDirY));
+    const __m256 maxDistance = _mm256_set1_ps(ray->maxDistance);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    __m256 best = _mm256_set1_ps(*closestDistance);
+    __m256i bestPosition = _mm256_set1_epi32(-1);
+
+    for (int j = first; j < last; j += 8)
+    {
+        __m256 tx1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&boxes->minX[j]), originX), invDirX);
+        __m256 tx2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&boxes->maxX[j]), originX), invDirX);
+        __m256 ty1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&boxes->minY[j]), originY), invDirY);
+        __m256 ty2 = _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&boxes->maxY[j]), originY), invDirY);
+
+        __m256 tNear = _mm256_max_ps(_mm256_min_ps(tx1, tx2), _mm256_min_ps(ty1, ty2));
+        __m256 tFar = _mm256_min_ps(_mm256_max_ps(tx1, tx2), _mm256_max_ps(ty1, ty2));
+        __m256 t = _mm256_blendv_ps(tFar, tNear, _mm256_cmp_ps(tNear, zero, _CMP_GE_OQ));
+
+        __m256 valid = _mm256_and_ps(_mm256_cmp_ps(tFar, zero, _CMP_GE_OQ), _mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(t, maxDistance, _CMP_LE_OQ));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(t, best, _CMP_LT_OQ));
+
+        best = _mm256_blendv_ps(best, t, valid);
+        bestPosition = _mm256_blendv_epi8(bestPosition, _mm256_add_epi32(_mm256_set1_epi32(j), laneOffsets),
+                                          _mm256_castps_si256(valid));
+    }
+
+    float distances[8];
+    int positions[8];
+    _mm256_storeu_ps(distances, best);
+    _mm256_storeu_si256((__m256i *)positions, bestPosition);
+    return reduce_lanes(distances, positions, 8, closestDistance, hit);
+}
+
+__attribute__((target("avx2")))
+static bool closest_circle_avx2(const SpatialGridCircles *circles, const SpatialGridRay *ray,
+                                int first, int last, int skipIndex, float *closestDistance, int *hit)
+{
+    const __m256 originX = _mm256_set1_ps(ray->originX);
+    const __m256 originY = _mm256_set1_ps(ray->originY);
+    const __m256 dirX = _mm256_set1_ps(ray->dirX);
+    const __m256 dirY = _mm256_set1_ps(ray->dirY);
+    const __m256 maxDistance = _mm256_set1_ps(ray->maxDistance);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256i skip = _mm256_set1_epi32(skipIndex);
+    const __m256i laneOffsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+    __m256 best = _mm256_set1_ps(*closestDistance);
+    __m256i bestPosition = _mm256_set1_epi32(-1);
+
+    for (int j = first; j < last; j += 8)
+    {
+        __m256 lx = _mm256_sub_ps(_mm256_loadu_ps(&circles->centerX[j]), originX);
+        __m256 ly = _mm256_sub_ps(_mm256_loadu_ps(&circles->centerY[j]), originY);
+        __m256 radius = _mm256_loadu_ps(&circles->radius[j]);
+
+        __m256 tc = _mm256_add_ps(_mm256_mul_ps(lx, dirX), _mm256_mul_ps(ly, dirY));
+        __m256 lengthSq = _mm256_add_ps(_mm256_mul_ps(lx, lx), _mm256_mul_ps(ly, ly));
+        __m256 radiusSq = _mm256_mul_ps(radius, radius);
+        __m256 inside = _mm256_cmp_ps(lengthSq, radiusSq, _CMP_LE_OQ);
+        __m256 perpendicularSq = _mm256_sub_ps(lengthSq, _mm256_mul_ps(tc, tc));
+
+        __m256 halfChord = _mm256_sqrt_ps(_mm256_max_ps(_mm256_sub_ps(radiusSq, perpendicularSq), zero));
+        __m256 t = _mm256_blendv_ps(_mm256_sub_ps(tc, halfChord), _mm256_add_ps(tc, halfChord), inside);
+
+        __m256i self = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)&circles->index[j]), skip);
+        __m256 valid = _mm256_or_ps(inside, _mm256_cmp_ps(tc, zero, _CMP_GE_OQ));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(perpendicularSq, radiusSq, _CMP_LE_OQ));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(t, maxDistance, _CMP_LE_OQ));
+        valid = _mm256_and_ps(valid, _mm256_cmp_ps(t, best, _CMP_LT_OQ));
+        valid = _mm256_andnot_ps(_mm256_castsi256_ps(self), valid);
+
+        best = _mm256_blendv_ps(best, t, valid);
+        bestPosition = _mm256_blendv_epi8(bestPosition, _mm256_add_epi32(_mm256_set1_epi32(j), laneOffsets),
+                                          _mm256_castps_si256(valid));
+    }
+
+    float distances[8];
+    int positions[8];
+    _mm256_storeu_ps(distances, best);
+    _mm256_storeu_si256((__m256i *)positions, bestPosition);
+    return reduce_lanes(distances, positions, 8, closestDistance, hit);
+}
+
+#endif // CPU_HAS_X86_SIMD
+
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+int SpatialGrid_SelectKernels(bool allowSimd)
+{
+    g_closestBox = closest_box_scalar;
+    g_closestCircle = closest_circle_scalar;
+    g_lanes = 1;
+    g_kernelName = "scalar";
+
+#if CPU_HAS_X86_SIMD
+    const CpuFeatures *features = CpuFeatures_Get();
+    if (allowSimd && features->avx2) {
+        g_closestBox = closest_box_avx2;
+        g_closestCircle = closest_circle_avx2;
+        g_lanes = 8;
+        g_kernelName = "avx2";
+    } else if (allowSimd && features->sse2) {
+        g_closestBox = closest_box_sse;
+        g_closestCircle = closest_circle_sse;
+        g_lanes = 4;
+        g_kernelName = "sse";
+    }
+#else
+    (void)allowSimd;
+#endif
+
+    return g_lanes;
+}
+
+int SpatialGrid_KernelLanes(void)
+{
+    if (g_closestBox == NULL)
+        SpatialGrid_SelectKernels(true);
+    return g_lanes;
+}
+
+const char *SpatialGrid_KernelName(void)
+{
+    if (g_closestBox == NULL)
+        SpatialGrid_SelectKernels(true);
+    return g_kernelName;
+}
+
+bool SpatialGrid_ClosestBox(const SpatialGrid *grid, const SpatialGridRay *ray, int bucket,
+                            float *closestDistance, int *hit)
+{
+    int first = grid->foods.bucketStart[bucket];
+    int last = grid->foods.bucketStart[bucket + 1];
+    if (first == last)
+        return false;
+
+    // Ranges are padded for the kernels active at rebuild time, fall back if they changed since
+    if (g_closestBox == NULL || grid->lanes % g_lanes != 0)
+        return closest_box_scalar(&grid->foods, ray, first, last, closestDistance, hit);
+    return g_closestBox(&grid->foods, ray, first, last, closestDistance, hit);
+}
+
+bool SpatialGrid_ClosestCircle(const SpatialGrid *grid, const SpatialGridRay *ray, int bucket, int skipIndex,
+                               float *closestDistance, int *hit)
+{
+    int first = grid->cells.bucketStart[bucket];
+    int last = grid->cells.bucketStart[bucket + 1];
+    if (first == last)
+        return false;
+
+    if (g_closestCircle == NULL || grid->lanes % g_lanes != 0)
+        return closest_circle_scalar(&grid->cells, ray, first, last, skipIndex, closestDistance, hit);
+    return g_closestCircle(&grid->cells, ray, first, last, skipIndex, closestDistance, hit);
+}
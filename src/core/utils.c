@@ -1,6 +1,11 @@
 #include "../../include/core/utils.h"
+#include "../../include/core/random.h"
 
+#include <stdlib.h>
 #include <time.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 
 
 const SDL_Color COLOR_TRANSPARENT   = {0};
@@ -29,7 +34,7 @@ void Utils_setBackgroundColor(SDL_Renderer *renderer, SDL_Color color)
 
 void Utils_randInit(void)
 {
-    srand(time(NULL));
+    Random_Seed((uint64_t)time(NULL));
 }
 
 float Utils_map(float value, float min1, float max1, float min2, float max2)
@@ -39,10 +44,30 @@ float Utils_map(float value, float min1, float max1, float min2, float max2)
 
 int irand(int min, int max)
 {
-    return (rand() % (max + 1)) + min;
+    return Rng_Int(Random_Main(), min, max);
 }
 
 double drand(double min, double max)
 {
-    return min + (double)rand() / ((double)RAND_MAX / (max - min));
+    return Rng_Range(Random_Main(), min, max);
+}
+
+void *Utils_alignedAlloc(size_t alignment, size_t size)
+{
+    // aligned_alloc wants a size multiple of the alignment
+    size = (size + alignment - 1) / alignment * alignment;
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    return aligned_alloc(alignment, size);
+#endif
+}
+
+void Utils_alignedFree(void *ptr)
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
 }
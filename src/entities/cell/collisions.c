@@ -2,37 +2,41 @@
 
 // Thanks to ChatGPT
 
-bool check_rect_collision(Cell *cell, SDL_FRect *hitbox)
+bool check_rect_collision(Population *population, int index, SDL_FRect *hitbox)
 {
+    float *x = &population->x[index];
+    float *y = &population->y[index];
+    int radius = population->cells[index].radius;
+
     // Check if the cell is inside the hitbox
-    if (cell->position.x + cell->radius > hitbox->x &&
-        cell->position.x - cell->radius < hitbox->x + hitbox->w &&
-        cell->position.y + cell->radius > hitbox->y &&
-        cell->position.y - cell->radius < hitbox->y + hitbox->h)
+    if (*x + radius > hitbox->x &&
+        *x - radius < hitbox->x + hitbox->w &&
+        *y + radius > hitbox->y &&
+        *y - radius < hitbox->y + hitbox->h)
     {
         // Check if the cell is above the hitbox
-        if (cell->position.y + cell->radius > hitbox->y &&
-            cell->position.y - cell->radius < hitbox->y)
+        if (*y + radius > hitbox->y &&
+            *y - radius < hitbox->y)
         {
-            cell->position.y = hitbox->y - cell->radius;
+            *y = hitbox->y - radius;
         }
         // Check if the cell is below the hitbox
-        else if (cell->position.y - cell->radius < hitbox->y + hitbox->h &&
-                 cell->position.y + cell->radius > hitbox->y + hitbox->h)
+        else if (*y - radius < hitbox->y + hitbox->h &&
+                 *y + radius > hitbox->y + hitbox->h)
         {
-            cell->position.y = hitbox->y + hitbox->h + cell->radius;
+            *y = hitbox->y + hitbox->h + radius;
         }
         // Check if the cell is on the left of the hitbox
-        else if (cell->position.x + cell->radius > hitbox->x &&
-                 cell->position.x - cell->radius < hitbox->x)
+        else if (*x + radius > hitbox->x &&
+                 *x - radius < hitbox->x)
         {
-            cell->position.x = hitbox->x - cell->radius;
+            *x = hitbox->x - radius;
         }
         // Check if the cell is on the right of the hitbox
-        else if (cell->position.x - cell->radius < hitbox->x + hitbox->w &&
-                 cell->position.x + cell->radius > hitbox->x + hitbox->w)
+        else if (*x - radius < hitbox->x + hitbox->w &&
+                 *x + radius > hitbox->x + hitbox->w)
         {
-            cell->position.x = hitbox->x + hitbox->w + cell->radius;
+            *x = hitbox->x + hitbox->w + radius;
         }
 
         return true;
@@ -41,70 +45,21 @@ bool check_rect_collision(Cell *cell, SDL_FRect *hitbox)
     return false;
 }
 
-bool findIntersection(SDL_FPoint lineA1, SDL_FPoint lineA2,
-                      SDL_FPoint lineB1, SDL_FPoint lineB2,
-                      SDL_FPoint *intersection) {
-    float s1_x, s1_y, s2_x, s2_y;
-    s1_x = lineA2.x - lineA1.x;
-    s1_y = lineA2.y - lineA1.y;
-    s2_x = lineB2.x - lineB1.x;
-    s2_y = lineB2.y - lineB1.y;
-
-    float s, t;
-    s = (-s1_y * (lineA1.x - lineB1.x) + s1_x * (lineA1.y - lineB1.y)) / (-s2_x * s1_y + s1_x * s2_y);
-    t = ( s2_x * (lineA1.y - lineB1.y) - s2_y * (lineA1.x - lineB1.x)) / (-s2_x * s1_y + s1_x * s2_y);
-
-    if (s >= 0 && s <= 1 && t >= 0 && t <= 1) {
-        // Collision detected
-        if (intersection != NULL) {
-            intersection->x = lineA1.x + (t * s1_x);
-            intersection->y = lineA1.y + (t * s1_y);
-        }
-        return true;
-    }
-
-    return false; // No collision
-}
-
-// Function to calculate distance between two points
-float distance(SDL_FPoint a, SDL_FPoint b) {
-    return sqrt((a.x - b.x) * (a.x - b.x) + (a.y - b.y) * (a.y - b.y));
-}
-
-// Main function to find intersection distance
-float findIntersectionDistance(SDL_FPoint lineA1, SDL_FPoint lineA2,
-                               SDL_FPoint lineB1, SDL_FPoint lineB2) {
-    SDL_FPoint intersection;
-    if (findIntersection(lineA1, lineA2, lineB1, lineB2, &intersection)) {
-        return distance(lineA1, intersection);
-    } else {
-        return -1; // Pas d'intersection
-    }
-}
-
-float check_ray_collision(Cell *cell, SDL_FRect *hitbox, int rayIndex)
+void update_ray_directions(Cell *cell, float angle)
 {
-    Ray *ray = &(cell->rays[rayIndex]);
+    // One cos/sin per cell, each ray is a fixed rotation of the heading
+    float heading = angle * PI / 180.0f;
+    float c = cos(heading);
+    float s = sin(heading);
 
-    SDL_FPoint corners[4] = {
-        {hitbox->x, hitbox->y},
-        {hitbox->x + hitbox->w, hitbox->y},
-        {hitbox->x + hitbox->w, hitbox->y + hitbox->h},
-        {hitbox->x, hitbox->y + hitbox->h}
-    };
-
-    float angle = (cell->angle * PI / 180.0f) + ray->angle;
-    float nearestDistance = ray->distanceMax;
+    for (int i = 0; i < CELL_PERCEPTION_RAYS; i++)
+    {
+        Ray *ray = &cell->rays[i];
+        ray->direction.x = c * ray->localDirection.x - s * ray->localDirection.y;
+        ray->direction.y = s * ray->localDirection.x + c * ray->localDirection.y;
 
-    for (int i = 0; i < 4; i++) {
-        float newDistance = findIntersectionDistance(cell->position,
-                                                     (SDL_FPoint){cell->position.x + cos(angle) * ray->distanceMax,
-                                                                  cell->position.y + sin(angle) * ray->distanceMax},
-                                                     corners[i], corners[(i + 1) % 4]);
-        if (newDistance != -1 && newDistance < nearestDistance) {
-            nearestDistance = newDistance;
-        }
+        // Axis-aligned rays give +/-inf, which the slab kernels handle
+        ray->inverseDirection.x = 1.0f / ray->direction.x;
+        ray->inverseDirection.y = 1.0f / ray->direction.y;
     }
-
-    return nearestDistance;
 }
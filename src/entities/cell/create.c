@@ -1,13 +1,9 @@
 #include "../../../include/entities/cell.h"
 
-Cell *Cell_create(int x, int y, bool isAI)
+// Set every field except the network
+void Cell_init(Population *population, int index, int x, int y, bool isAI)
 {
-    Cell *cell = malloc(sizeof(Cell));
-    if (cell == NULL)
-    {
-        fprintf(stderr, "Failed to allocate memory for Cell !\n");
-        return NULL;
-    }
+    Cell *cell = &population->cells[index];
 
     cell->isAI = isAI;
     cell->positionInit.x = x;
@@ -21,16 +17,14 @@ Cell *Cell_create(int x, int y, bool isAI)
     cell->angleVelocity = 2.0f;
 
     cell->radius = 10;
-    cell->hitbox.x = x - cell->radius;
-    cell->hitbox.y = y - cell->radius;
-    cell->hitbox.w = cell->radius * 2;
-    cell->hitbox.h = cell->radius * 2;
 
     // Init rays from -PI to PI
     float demiAngle = PI / 4.0f;
     for (int i = 0; i < 7; i++)
     {
         cell->rays[i].angle = -demiAngle + i * demiAngle / 3;
+        cell->rays[i].localDirection.x = cos(cell->rays[i].angle);
+        cell->rays[i].localDirection.y = sin(cell->rays[i].angle);
         cell->rays[i].distance = 0.0f;
         cell->rays[i].distanceMax = 600.0f;
         cell->rays[i].hit.type = RAY_OBJECT_NONE;
@@ -38,65 +32,55 @@ Cell *Cell_create(int x, int y, bool isAI)
         cell->rays[i].hit.value = 0.0f;
     }
 
-    Cell_reset(cell);
-
-    // Create NeuralNetwork
-    int topology[] = NEURAL_NETWORK_TOPOLOGY;
-    int topologySize = sizeof(topology) / sizeof(topology[0]);  // Deduce size from array
-    cell->nn = createNeuralNetwork(topology, topologySize);
-    setRandomWeights(cell->nn, -1, 1);
-
-    return cell;
+    Cell_reset(population, index);
+    update_ray_directions(cell, population->angle[index]);
 }
 
-void Cell_GiveBirth(Cell *cell, Map *map)
+// Fill an unused slot with a new cell and a random network
+bool Cell_create(Population *population, int index, int x, int y, bool isAI)
 {
-    // Priorize lower scores
-    int index = -1;
-    int minValue = -1;
-    for (int i = 1; i < MEM_CELL_COUNT; i++)
-    {
-        if (map->cells[i] == NULL || map->cells[i]->isAlive)
-            continue;
+    Cell_init(population, index, x, y, isAI);
 
-        if (map->cells[i]->score < minValue || minValue == -1)
-        {
-            index = i;
-            minValue = map->cells[i]->score;
-        }
-    }
-
-    if (index == -1 && map->cellCount < MEM_CELL_COUNT)
+    // Take a NeuralNetwork from the population's pool
+    Cell *cell = &population->cells[index];
+    cell->nn = NeuralPool_Acquire(&population->networks);
+    if (cell->nn == NULL)
     {
-        index = map->cellCount++;
+        fprintf(stderr, "Failed to create NeuralNetwork !\n");
+        return false;
     }
+    setRandomWeights(cell->nn, -1, 1);
+    Random_NewStream(&cell->rng);
+    population->networkChanged[index] = true;
 
-    if (index == -1)
-    {
-        printf("No more space for new cells !\n");
-        return;
-    }
+    return true;
+}
 
-    Cell *newCell = Cell_create(cell->positionInit.x, cell->positionInit.y, true);
-    newCell->position.x = cell->position.x;
-    newCell->position.y = cell->position.y;
-    newCell->generation = cell->generation + 1;
+// The slot is chosen by the caller (see Births_Apply); a dead cell already in
+// the slot is reused in place, including its network buffers
+bool Cell_GiveBirth(Population *population, int parent, int index, Map *map)
+{
+    Cell *cell = &population->cells[parent];
+    Cell *newCell = &population->cells[index];
+    if (index >= population->count)
+        newCell->nn = NULL;
 
     // Copy NeuralNetwork and mutate
-    NeuralNetwork *newNN = NeuralNetwork_Copy(cell->nn);
-    if (newNN == NULL)
+    if (!NeuralNetwork_Assign(&newCell->nn, cell->nn))
     {
         fprintf(stderr, "Failed to copy NeuralNetwork !\n");
-        return;
+        return false;
     }
 
-    freeNeuralNetwork(newCell->nn);
-    newCell->nn = newNN;
+    Cell_init(population, index, cell->positionInit.x, cell->positionInit.y, true);
+    population->x[index] = population->x[parent];
+    population->y[index] = population->y[parent];
+    population->generation[index] = population->generation[parent] + 1;
 
     // Use dynamic mutation parameters
+    Random_NewStream(&newCell->rng);
     Cell_mutate(newCell, map->mutationParams.childMutationRate, map->mutationParams.childMutationProb);
+    population->networkChanged[index] = true;
 
-    if (map->cells[index] != NULL)
-        Cell_destroy(map->cells[index]);
-    map->cells[index] = newCell;
+    return true;
 }
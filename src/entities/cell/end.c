@@ -1,17 +1,20 @@
 #include "../../../include/entities/cell.h"
 
-void Cell_reset(Cell *cell)
+void Cell_reset(Population *population, int index)
 {
-    cell->isAlive = true;
-    cell->score = 0;
-    cell->health = cell->healthInit;
+    Cell *cell = &population->cells[index];
+
+    population->alive[index] = true;
+    population->score[index] = 0;
+    population->health[index] = cell->healthInit;
+    population->generation[index] = 1;
     cell->frame = 0;
-    cell->generation = 1;
+    cell->birthPending = false;
 
-    cell->position.x = cell->positionInit.x;
-    cell->position.y = cell->positionInit.y;
-    cell->speed = 0.0f;
-    cell->angle = 0.0f;
+    population->x[index] = cell->positionInit.x;
+    population->y[index] = cell->positionInit.y;
+    population->speed[index] = 0.0f;
+    population->angle[index] = 0.0f;
 
     cell->goingUp = false;
     cell->goingDown = false;
@@ -19,8 +22,10 @@ void Cell_reset(Cell *cell)
     cell->goingRight = false;
 }
 
-void Cell_destroy(Cell *cell)
+void Cell_destroy(Population *population, int index)
 {
-    freeNeuralNetwork(cell->nn);
-    free(cell);
+    if (population->cells[index].nn != NULL)
+        freeNeuralNetwork(population->cells[index].nn);
+    population->cells[index].nn = NULL;
+    population->alive[index] = false;
 }
@@ -18,9 +18,9 @@ static CellSprites *shinySprites = NULL;
 static bool spritesLoaded = false;
 
 // Function prototypes to resolve implicit declaration errors
-void render_healthbar(Cell *cell, SDL_Renderer *renderer);
-void render_face(Cell *cell, SDL_Renderer *renderer);
-void render_rays(Cell *cell, SDL_Renderer *renderer);
+void render_healthbar(Cell *cell, float x, float y, int health, SDL_Renderer *renderer);
+void render_face(Cell *cell, float x, float y, float angle, SDL_Renderer *renderer);
+void render_rays(Cell *cell, float x, float y, float angle, SDL_Renderer *renderer);
 
 // Function to load cell sprites once at program start
 bool load_all_cell_sprites(SDL_Renderer *renderer) {
@@ -125,15 +125,15 @@ void free_cell_sprites() {
     spritesLoaded = false;
 }
 
-void render_healthbar(Cell *cell, SDL_Renderer *renderer)
+void render_healthbar(Cell *cell, float x, float y, int health, SDL_Renderer *renderer)
 {
     SDL_SetRenderDrawColor(renderer, COLOR_WHITE.r, COLOR_WHITE.g, COLOR_WHITE.b, COLOR_WHITE.a);
-    SDL_RenderDrawRect(renderer, &(SDL_Rect){cell->position.x - cell->radius, cell->position.y - cell->radius - 10, cell->radius * 2, 5});
+    SDL_RenderDrawRect(renderer, &(SDL_Rect){x - cell->radius, y - cell->radius - 10, cell->radius * 2, 5});
     SDL_SetRenderDrawColor(renderer, COLOR_GREEN.r, COLOR_GREEN.g, COLOR_GREEN.b, COLOR_GREEN.a);
-    SDL_RenderFillRect(renderer, &(SDL_Rect){cell->position.x - cell->radius, cell->position.y - cell->radius - 10, cell->radius * 2 * (float)cell->health / (float)cell->healthMax, 5});
+    SDL_RenderFillRect(renderer, &(SDL_Rect){x - cell->radius, y - cell->radius - 10, cell->radius * 2 * (float)health / (float)cell->healthMax, 5});
 }
 
-void render_face(Cell *cell, SDL_Renderer *renderer)
+void render_face(Cell *cell, float x, float y, float angle, SDL_Renderer *renderer)
 {
     // Two small eyes with small arc for the mouth
     int eyeRadius = cell->radius / 8;
@@ -144,16 +144,16 @@ void render_face(Cell *cell, SDL_Renderer *renderer)
     int mouthOffsetY = 0;
 
     // Rotate eyes around mouth
-    int eyeX1 = cell->position.x + eyeOffsetX * cos(cell->angle * PI / 180) - eyeOffsetY * sin(cell->angle * PI / 180);
-    int eyeY1 = cell->position.y + eyeOffsetX * sin(cell->angle * PI / 180) + eyeOffsetY * cos(cell->angle * PI / 180);
-    int eyeX2 = cell->position.x + eyeOffsetX * cos(cell->angle * PI / 180) + eyeOffsetY * sin(cell->angle * PI / 180);
-    int eyeY2 = cell->position.y + eyeOffsetX * sin(cell->angle * PI / 180) - eyeOffsetY * cos(cell->angle * PI / 180);
+    int eyeX1 = x + eyeOffsetX * cos(angle * PI / 180) - eyeOffsetY * sin(angle * PI / 180);
+    int eyeY1 = y + eyeOffsetX * sin(angle * PI / 180) + eyeOffsetY * cos(angle * PI / 180);
+    int eyeX2 = x + eyeOffsetX * cos(angle * PI / 180) + eyeOffsetY * sin(angle * PI / 180);
+    int eyeY2 = y + eyeOffsetX * sin(angle * PI / 180) - eyeOffsetY * cos(angle * PI / 180);
 
-    int mouthX = cell->position.x + mouthOffsetX * cos(cell->angle * PI / 180) - mouthOffsetY * sin(cell->angle * PI / 180);
-    int mouthY = cell->position.y + mouthOffsetX * sin(cell->angle * PI / 180) + mouthOffsetY * cos(cell->angle * PI / 180);
+    int mouthX = x + mouthOffsetX * cos(angle * PI / 180) - mouthOffsetY * sin(angle * PI / 180);
+    int mouthY = y + mouthOffsetX * sin(angle * PI / 180) + mouthOffsetY * cos(angle * PI / 180);
 
-    int mouthStartAngle = 180 + cell->angle - 90;
-    int mouthEndAngle = 180 + cell->angle + 90;
+    int mouthStartAngle = 180 + angle - 90;
+    int mouthEndAngle = 180 + angle + 90;
 
     // Draw color
     SDL_SetRenderDrawColor(renderer, COLOR_WHITE.r, COLOR_WHITE.g, COLOR_WHITE.b, COLOR_WHITE.a);
@@ -166,7 +166,7 @@ void render_face(Cell *cell, SDL_Renderer *renderer)
     SDL_RenderDrawArc(renderer, mouthX, mouthY, mouthRadius, mouthStartAngle, mouthEndAngle);
 }
 
-void render_rays(Cell *cell, SDL_Renderer *renderer)
+void render_rays(Cell *cell, float x, float y, float angle, SDL_Renderer *renderer)
 {
     for (int i = 0; i < 7; i++)
     {
@@ -190,10 +190,10 @@ void render_rays(Cell *cell, SDL_Renderer *renderer)
 
         // Render ray
         SDL_RenderDrawLine(renderer,
-                        cell->position.x,
-                        cell->position.y,
-                        cell->position.x + cell->rays[i].distanceMax * cos(cell->rays[i].angle + cell->angle * PI / 180.0f),
-                        cell->position.y + cell->rays[i].distanceMax * sin(cell->rays[i].angle + cell->angle * PI / 180.0f));
+                        x,
+                        y,
+                        x + cell->rays[i].distanceMax * cos(cell->rays[i].angle + angle * PI / 180.0f),
+                        y + cell->rays[i].distanceMax * sin(cell->rays[i].angle + angle * PI / 180.0f));
 
         // Render intersection with color based on detected object type
         if (cell->rays[i].hit.type != RAY_OBJECT_NONE)
@@ -216,32 +216,37 @@ void render_rays(Cell *cell, SDL_Renderer *renderer)
             }
 
             SDL_RenderFillCircle(renderer,
-                                cell->position.x + cell->rays[i].distance * cos(cell->rays[i].angle + cell->angle * PI / 180.0f),
-                                cell->position.y + cell->rays[i].distance * sin(cell->rays[i].angle + cell->angle * PI / 180.0f),
+                                x + cell->rays[i].distance * cos(cell->rays[i].angle + angle * PI / 180.0f),
+                                y + cell->rays[i].distance * sin(cell->rays[i].angle + angle * PI / 180.0f),
                                 3); // Slightly bigger for better visibility
         }
     }
 }
 
-void Cell_render(Cell *cell, SDL_Renderer *renderer, bool renderRays, bool isSelected)
+void Cell_render(Population *population, int index, SDL_Renderer *renderer, float offsetX, float offsetY, bool renderRays, bool isSelected)
 {
-    if (!cell->isAlive)
+    if (!population->alive[index])
         return;
 
+    Cell *cell = &population->cells[index];
+    float x = population->x[index] + offsetX;
+    float y = population->y[index] + offsetY;
+    float angle = population->angle[index];
+
     // Render based on CELL_USE_SPRITE flag
     if (!CELL_USE_SPRITE) {
         // Simple rendering without sprites
         if (isSelected)
         {
             SDL_SetRenderDrawColor(renderer, COLOR_ORANGE.r, COLOR_ORANGE.g, COLOR_ORANGE.b, COLOR_ORANGE.a);
-            SDL_RenderFillCircle(renderer, cell->position.x, cell->position.y, cell->radius);
-            render_face(cell, renderer);
+            SDL_RenderFillCircle(renderer, x, y, cell->radius);
+            render_face(cell, x, y, angle, renderer);
         }
         else
         {
             SDL_SetRenderDrawColor(renderer, COLOR_VIOLET.r, COLOR_VIOLET.g, COLOR_VIOLET.b, COLOR_VIOLET.a);
-            SDL_RenderFillCircle(renderer, cell->position.x, cell->position.y, cell->radius);
-            render_face(cell, renderer);
+            SDL_RenderFillCircle(renderer, x, y, cell->radius);
+            render_face(cell, x, y, angle, renderer);
         }
     }
     else {
@@ -255,22 +260,22 @@ void Cell_render(Cell *cell, SDL_Renderer *renderer, bool renderRays, bool isSel
         CellSprites *sprites = isSelected ? shinySprites : normalSprites;
 
         // Calculate angle in radians
-        float rad = cell->angle * PI / 180.0f;
+        float rad = angle * PI / 180.0f;
 
         // Determine texture to display: if angle is less than 180°, cell is facing down (show eyes)
         // otherwise it's facing up (show back "ass")
-        bool showEyes = (cell->angle < 180);
+        bool showEyes = (angle < 180);
 
         // Calculate horizontal offset based on horizontal component
-        // When cell->angle == 0, cos(0)=1 (max positive offset), and for cell->angle == 180, cos(180)=-1 (max negative offset)
+        // When angle == 0, cos(0)=1 (max positive offset), and for angle == 180, cos(180)=-1 (max negative offset)
         float tOffset = (cos(rad) + 1.0f) / 2.0f;
         float maxOffset = cell->radius * 0.4f;
-        int offsetX = (int)(((tOffset - 0.5f) * 2.0f) * maxOffset);
+        int spriteOffsetX = (int)(((tOffset - 0.5f) * 2.0f) * maxOffset);
 
         int radius = cell->radius * 1.5;
         SDL_Rect destRect = {
-            cell->position.x - radius,
-            cell->position.y - radius,
+            x - radius,
+            y - radius,
             radius * 2,
             radius * 2
         };
@@ -283,12 +288,12 @@ void Cell_render(Cell *cell, SDL_Renderer *renderer, bool renderRays, bool isSel
         if (showEyes) {
             // When cell is facing down (angle < 180°), display eyes
             SDL_Rect eyesRect = destRect;
-            eyesRect.x += offsetX;
+            eyesRect.x += spriteOffsetX;
             SDL_RenderCopyEx(renderer, sprites->eyes, NULL, &eyesRect, 0, NULL, flip);
         } else {
             // When cell is facing up (angle >= 180°), display back (ass) with inverted offset
             SDL_Rect assRect = destRect;
-            assRect.x -= offsetX;
+            assRect.x -= spriteOffsetX;
             SDL_RenderCopyEx(renderer, sprites->ass, NULL, &assRect, 0, NULL, flip);
         }
 
@@ -296,8 +301,8 @@ void Cell_render(Cell *cell, SDL_Renderer *renderer, bool renderRays, bool isSel
         SDL_RenderCopyEx(renderer, sprites->leaf, NULL, &destRect, 0, NULL, flip);
     }
 
-    render_healthbar(cell, renderer);
+    render_healthbar(cell, x, y, population->health[index], renderer);
 
     if (renderRays)
-        render_rays(cell, renderer);
+        render_rays(cell, x, y, angle, renderer);
 }
@@ -0,0 +1,59 @@
+#include "../../../include/entities/cell.h"
+
+void Cell_sense(Population *population, int index, Map *map)
+{
+    if (!population->alive[index])
+        return;
+
+    Cell *cell = &population->cells[index];
+    float x = population->x[index];
+    float y = population->y[index];
+
+    // Ray casting for object detection (only the grid buckets crossed by each ray are visited)
+    update_ray_directions(cell, population->angle[index]);
+    for (int i = 0; i < CELL_PERCEPTION_RAYS; i++)
+    {
+        Ray *ray = &cell->rays[i];
+        SpatialGridRay query = {
+            x, y,
+            ray->direction.x, ray->direction.y,
+            ray->inverseDirection.x, ray->inverseDirection.y,
+            ray->distanceMax
+        };
+        float closestDistance = ray->distanceMax;
+        RayObjectType closestType = RAY_OBJECT_NONE;
+        float closestValue = 0.0f;
+
+        SpatialGridRayWalk walk;
+        SpatialGrid_BeginRay(&map->grid, &walk, &query);
+
+        int bucket, hit;
+        float bucketExit;
+        while (SpatialGrid_NextBucket(&walk, &bucket, &bucketExit))
+        {
+            // Foods first so they win exact ties, like the original per-object loop
+            if (SpatialGrid_ClosestBox(&map->grid, &query, bucket, &closestDistance, &hit))
+            {
+                closestType = RAY_OBJECT_FOOD;
+                closestValue = map->grid.foods.value[hit];
+            }
+
+            // Cells are sensed as circles inscribed in their hitbox, skipping itself
+            if (SpatialGrid_ClosestCircle(&map->grid, &query, bucket, index, &closestDistance, &hit))
+            {
+                closestType = RAY_OBJECT_CELL;
+                closestValue = map->grid.cells.value[hit];
+            }
+
+            // Buckets are visited in ray order: nothing further can be closer
+            if (closestDistance <= bucketExit)
+                break;
+        }
+
+        // Update ray information
+        ray->distance = closestDistance;
+        ray->hit.type = closestType;
+        ray->hit.distance = closestDistance;
+        ray->hit.value = closestValue;
+    }
+}
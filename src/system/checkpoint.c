@@ -1,26 +1,41 @@
 #include "../../include/system/checkpoint.h"
 #include "../../include/core/game.h"
 
+// Directory checkpoints are written to, always ends with a separator
+static char g_checkpointDir[256] = CHECKPOINT_DIR;
+
+void Checkpoint_setDir(const char *dir)
+{
+    size_t length = strlen(dir);
+    bool hasSeparator = length > 0 && (dir[length - 1] == '/' || dir[length - 1] == '\\');
+    snprintf(g_checkpointDir, sizeof(g_checkpointDir), "%s%s", dir, hasSeparator ? "" : "/");
+}
+
+const char *Checkpoint_getDir(void)
+{
+    return g_checkpointDir;
+}
+
 void Checkpoint_createDir(void)
 {
     #ifdef _WIN32
-        _mkdir(CHECKPOINT_DIR);
+        _mkdir(g_checkpointDir);
     #else
-        mkdir(CHECKPOINT_DIR, 0755);
+        mkdir(g_checkpointDir, 0755);
     #endif
 }
 
 void Checkpoint_cleanupOld(void)
 {
-    char command[256];
+    char command[512];
     #ifdef _WIN32
         snprintf(command, sizeof(command),
-            "cd %s && for /f \"skip=%d\" %%i in ('dir checkpoint_*.nn /b /o-d') do del \"%%i\"",
-            CHECKPOINT_DIR, CHECKPOINT_MAX_FILES);
+            "cd \"%s\" && for /f \"skip=%d\" %%i in ('dir checkpoint_*.nn /b /o-d') do del \"%%i\"",
+            g_checkpointDir, CHECKPOINT_MAX_FILES);
     #else
         snprintf(command, sizeof(command),
-            "cd %s && ls -t checkpoint_*.nn 2>/dev/null | tail -n +%d | xargs rm -f",
-            CHECKPOINT_DIR, CHECKPOINT_MAX_FILES + 1);
+            "cd '%s' && ls -t checkpoint_*.nn 2>/dev/null | tail -n +%d | xargs rm -f",
+            g_checkpointDir, CHECKPOINT_MAX_FILES + 1);
     #endif
 
     system(command);
@@ -28,7 +43,7 @@ void Checkpoint_cleanupOld(void)
 
 void Checkpoint_save(Map *map)
 {
-    if (map->bestCellEver == NULL || map->bestCellEver->nn == NULL) {
+    if (map->bestCellEver.nn == NULL) {
         return;
     }
 
@@ -36,12 +51,12 @@ void Checkpoint_save(Map *map)
 
     time_t now = time(NULL);
     struct tm *tm_info = localtime(&now);
-    char filename[256];
+    char filename[512];
     char timestamp[64];
 
     strftime(timestamp, sizeof(timestamp), "%Y%m%d_%H%M%S", tm_info);
     snprintf(filename, sizeof(filename), "%scheckpoint_gen%d_%s_score%d.nn",
-             CHECKPOINT_DIR, map->generation, timestamp, map->bestCellEver->score);
+             g_checkpointDir, map->generation, timestamp, map->bestCellEver.score);
 
     if (Game_save(map, filename)) {
         map->checkpointCounter++;
@@ -0,0 +1,28 @@
+/**
+ * @file cpu_features.c
+ * @brief Implementation of the runtime CPU feature detection
+ */
+
+#include "../../include/system/cpu_features.h"
+
+static CpuFeatures g_features;
+static bool g_detected = false;
+
+const CpuFeatures *CpuFeatures_Get(void)
+{
+    if (g_detected)
+        return &g_features;
+
+#if CPU_HAS_X86_SIMD
+    __builtin_cpu_init();
+    g_features.sse2 = __builtin_cpu_supports("sse2");
+    g_features.avx2 = __builtin_cpu_supports("avx2");
+    g_features.fma = __builtin_cpu_supports("fma");
+    g_features.f16c = __builtin_cpu_supports("f16c");
+    g_features.avx512f = __builtin_cpu_supports("avx512f");
+    g_features.avx512vnni = __builtin_cpu_supports("avx512vnni");
+#endif
+
+    g_detected = true;
+    return &g_features;
+}
@@ -64,15 +64,14 @@ void Graph_AddPoint(GraphData *graph, Map *map) {
     int maxGeneration = 0;
     int validCellCount = 0;
 
-    for (int i = 0; i < map->cellCount; ++i) {
-        if (map->cells[i] != NULL) {
-            validCellCount++;
-            if (map->cells[i]->score > bestScore) {
-                bestScore = map->cells[i]->score;
-            }
-            if (map->cells[i]->generation > maxGeneration) {
-                maxGeneration = map->cells[i]->generation;
-            }
+    const Population *population = &map->population;
+    for (int i = 0; i < population->count; ++i) {
+        validCellCount++;
+        if (population->score[i] > bestScore) {
+            bestScore = population->score[i];
+        }
+        if (population->generation[i] > maxGeneration) {
+            maxGeneration = population->generation[i];
         }
     }
 
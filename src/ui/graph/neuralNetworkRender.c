@@ -5,18 +5,44 @@
 
 #include <SDL2/SDL2_gfxPrimitives.h>
 
-void NeuralNetworkRender_Draw(Cell *cell, SDL_Renderer *renderer, int index, int x, int y, int w, int h)
+// Outputs of one layer inside a NeuralNetwork_ForwardCapture buffer
+static const NeuralScalar *layer_outputs(const NeuralNetwork *nn, const NeuralScalar *activations, int layer)
 {
-    if (cell == NULL || cell->nn == NULL)
+    for (int i = 0; i < layer; i++)
+        activations += nn->layers[i].nextLayerNeuronCount;
+    return activations;
+}
+
+void NeuralNetworkRender_Draw(Population *population, int index, SDL_Renderer *renderer, int x, int y, int w, int h)
+{
+    if (index < 0 || index >= population->count || population->cells[index].nn == NULL)
     {
         return;
     }
 
+    Cell *cell = &population->cells[index];
+
     NeuralNetwork *nn = cell->nn;
+    if (!NeuralNetwork_Materialize(nn))
+        return;
+
+    // The network keeps no activations: replay the cell's last inputs with a debug capture
+    static NeuralScalar *activations = NULL;
+    static int activationCapacity = 0;
+    int activationCount = NeuralNetwork_ActivationCount(nn);
+    if (activationCount > activationCapacity)
+    {
+        NeuralScalar *grown = realloc(activations, activationCount * sizeof(NeuralScalar));
+        if (grown == NULL)
+            return;
+        activations = grown;
+        activationCapacity = activationCount;
+    }
+    NeuralNetwork_ForwardCapture(nn, cell->inputs, activations);
 
     // Show index of cell and legend
     char indexText[50];
-    sprintf(indexText, "Best cell: %d, with score: %d", index, cell->score);
+    sprintf(indexText, "Best cell: %d, with score: %d", index, population->score[index]);
     SDL_Color color = {255, 255, 255, 255};
     stringRGBA(renderer, x, y - 30, indexText, color.r, color.g, color.b, color.a);
     stringRGBA(renderer, x, y - 15, "Bias: Green tint(+) Red tint(-)", 200, 200, 200, 255);
@@ -43,7 +69,9 @@ void NeuralNetworkRender_Draw(Cell *cell, SDL_Renderer *renderer, int index, int
     // PHASE 1: Draw all connections (background layer)
     for (int layerIdx = 0; layerIdx < layerCount; layerIdx++)
     {
-        NeuralLayer *layer = nn->layers[layerIdx];
+        NeuralLayer *layer = &nn->layers[layerIdx];
+        const NeuralScalar *destOutputs = layer_outputs(nn, activations, layerIdx);
+        const NeuralScalar *srcOutputs = (layerIdx == 0) ? cell->inputs : layer_outputs(nn, activations, layerIdx - 1);
 
         // Source layer info (what feeds into this layer)
         int sourceSize = nn->topology[layerIdx];
@@ -64,11 +92,11 @@ void NeuralNetworkRender_Draw(Cell *cell, SDL_Renderer *renderer, int index, int
             {
                 int destY = destStartY + (destIdx + 1) * neuronSpacing;
                 int weightIdx = srcIdx * destSize + destIdx;
-                float weight = layer->weights[weightIdx];
+                float weight = NeuralParameter_Load(layer->weights[weightIdx]);
 
                 // Calculate connection intensity
-                float srcActivation = (layerIdx == 0) ? cell->inputs[srcIdx] : nn->layers[layerIdx - 1]->outputs[srcIdx];
-                float destActivation = layer->outputs[destIdx];
+                float srcActivation = srcOutputs[srcIdx];
+                float destActivation = destOutputs[destIdx];
                 float intensity = fabs(srcActivation * destActivation * weight);
 
                 int opacity = (int)(baseOpacity + intensityRange * fmin(intensity, 1.0f));
@@ -79,7 +107,7 @@ void NeuralNetworkRender_Draw(Cell *cell, SDL_Renderer *renderer, int index, int
                 else
                     SDL_SetRenderDrawColor(renderer, 80, 220, 120, opacity);
 
-                if (!cell->isAlive)
+                if (!population->alive[index])
                     SDL_SetRenderDrawColor(renderer, 100, 100, 100, opacity / 2);
 
                 SDL_RenderDrawLine(renderer, sourceX, srcY, destX, destY);
@@ -114,7 +142,7 @@ void NeuralNetworkRender_Draw(Cell *cell, SDL_Renderer *renderer, int index, int
                 if (opacity == 0)
                 {
                     SDL_SetRenderDrawColor(renderer, red, green, blue, 125);
-                    if (!cell->isAlive)
+                    if (!population->alive[index])
                         SDL_SetRenderDrawColor(renderer, 125, 125, 125, 125);
                     SDL_RenderDrawCircleOutline(renderer, neuronX, neuronY, 10);
                 }
@@ -127,7 +155,7 @@ void NeuralNetworkRender_Draw(Cell *cell, SDL_Renderer *renderer, int index, int
                 red = 125; green = 125; blue = 255;
 
                 // Modulate color based on bias
-                float bias = nn->layers[layerIdx - 1]->biases[neuronIdx];
+                float bias = NeuralParameter_Load(nn->layers[layerIdx - 1].biases[neuronIdx]);
                 if (bias > 0.1f)
                     green = (int)(125 + 80 * fmin(bias, 1.0f));
                 else if (bias < -0.1f)
@@ -136,12 +164,12 @@ void NeuralNetworkRender_Draw(Cell *cell, SDL_Renderer *renderer, int index, int
             else
             {
                 // Hidden layer (green)
-                activation = nn->layers[layerIdx - 1]->outputs[neuronIdx];
+                activation = layer_outputs(nn, activations, layerIdx - 1)[neuronIdx];
                 opacity = (Uint8)(255.0f * (fabs(activation) + 1.0f) / 2.0f);
                 red = 0; green = 200; blue = 161;
 
                 // Modulate color based on bias
-                float bias = nn->layers[layerIdx - 1]->biases[neuronIdx];
+                float bias = NeuralParameter_Load(nn->layers[layerIdx - 1].biases[neuronIdx]);
                 if (bias > 0.1f)
                     green = (int)(200 + 55 * fmin(bias, 1.0f));
                 else if (bias < -0.1f)
@@ -149,7 +177,7 @@ void NeuralNetworkRender_Draw(Cell *cell, SDL_Renderer *renderer, int index, int
             }
 
             SDL_SetRenderDrawColor(renderer, red, green, blue, opacity);
-            if (!cell->isAlive)
+            if (!population->alive[index])
                 SDL_SetRenderDrawColor(renderer, 125, 125, 125, opacity);
 
             SDL_RenderDrawCircle(renderer, neuronX, neuronY, 10);
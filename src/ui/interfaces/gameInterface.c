@@ -49,18 +49,8 @@ void GameInterface_Render(SDL_Renderer *renderer, Map *map)
         }
 
         // Render cells with offset
-        for (int i = 0; i < map->cellCount; ++i) {
-            if (map->cells[i] != NULL) {
-                // Save original position
-                SDL_FPoint originalPos = map->cells[i]->position;
-                // Apply offset
-                map->cells[i]->position.x += offsetX;
-                map->cells[i]->position.y += offsetY;
-                Cell_render(map->cells[i], map->renderer, map->renderRays, i == map->currentBestCellIndex);
-                // Restore original position
-                map->cells[i]->position = originalPos;
-            }
-        }
+        for (int i = 0; i < map->population.count; ++i)
+            Cell_render(&map->population, i, map->renderer, offsetX, offsetY, map->renderRays, i == map->currentBestCellIndex);
 
         // Render walls with offset
         for (int i = 0; i < GAME_START_WALL_COUNT; ++i) {
@@ -75,16 +65,8 @@ void GameInterface_Render(SDL_Renderer *renderer, Map *map)
         }
     } else {
         // Render only the best cell when others are hidden
-        if (map->cells[map->currentBestCellIndex] != NULL) {
-            // Save original position
-            SDL_FPoint originalPos = map->cells[map->currentBestCellIndex]->position;
-            // Apply offset
-            map->cells[map->currentBestCellIndex]->position.x += offsetX;
-            map->cells[map->currentBestCellIndex]->position.y += offsetY;
-            Cell_render(map->cells[map->currentBestCellIndex], map->renderer, map->renderRays, true);
-            // Restore original position
-            map->cells[map->currentBestCellIndex]->position = originalPos;
-        }
+        if (map->currentBestCellIndex < map->population.count)
+            Cell_render(&map->population, map->currentBestCellIndex, map->renderer, offsetX, offsetY, map->renderRays, true);
     }
 
     // === UI RENDERING (screen-fixed) ===
@@ -95,9 +77,7 @@ void GameInterface_Render(SDL_Renderer *renderer, Map *map)
     // Neural network visualization
     if (map->renderNeuralNetwork)
     {
-        int index = map->currentBestCellIndex;
-        if (map->cells[index] != NULL)
-            NeuralNetworkRender_Draw(map->cells[index], renderer, index, 900, 400, 300, 400);
+        NeuralNetworkRender_Draw(&map->population, map->currentBestCellIndex, renderer, 900, 400, 300, 400);
     }
 
     // Score evolution graph
@@ -119,8 +99,8 @@ void GameInterface_RenderText(Map *map, SDL_Color color)
     char message[100];
 
     int aliveCount = 0;
-    for (int i = 0; i < map->cellCount; ++i)
-        if (map->cells[i] != NULL && map->cells[i]->isAlive)
+    for (int i = 0; i < map->population.count; ++i)
+        if (map->population.alive[i])
             aliveCount++;
 
     //
@@ -159,11 +139,11 @@ void GameInterface_RenderText(Map *map, SDL_Color color)
     stringRGBA(map->renderer, 500, 25, message, color.r, color.g, color.b, color.a);
 
     // Cells count
-    sprintf(message, "Cells count: %d (total: %d)", aliveCount, map->cellCount);
+    sprintf(message, "Cells count: %d (total: %d)", aliveCount, map->population.count);
     stringRGBA(map->renderer, 500, 50, message, color.r, color.g, color.b, color.a);
 
     // Best score
-    sprintf(message, "Best score: %d (max: %d)", map->cells[map->currentBestCellIndex]->score, map->maxScore);
+    sprintf(message, "Best score: %d (max: %d)", map->population.score[map->currentBestCellIndex], map->maxScore);
     stringRGBA(map->renderer, 500, 75, message, color.r, color.g, color.b, color.a);
 
     // Diversity and convergence
@@ -194,16 +174,16 @@ void GameInterface_RenderText(Map *map, SDL_Color color)
 
 #if CELL_AS_PLAYER
     // Player informations
-    sprintf(message, "Player pos: %d, %d", (int)map->cells[0]->position.x, (int)map->cells[0]->position.y);
+    sprintf(message, "Player pos: %d, %d", (int)map->population.x[0], (int)map->population.y[0]);
     stringRGBA(map->renderer, 500, 225, message, color.r, color.g, color.b, color.a);
 
-    sprintf(message, "Angle: %f", map->cells[0]->angle);
+    sprintf(message, "Angle: %f", map->population.angle[0]);
     stringRGBA(map->renderer, 500, 250, message, color.r, color.g, color.b, color.a);
 
-    sprintf(message, "Speed: %f", map->cells[0]->speed);
+    sprintf(message, "Speed: %f", map->population.speed[0]);
     stringRGBA(map->renderer, 500, 275, message, color.r, color.g, color.b, color.a);
 
-    sprintf(message, "Score: %d", map->cells[0]->score);
+    sprintf(message, "Score: %d", map->population.score[0]);
     stringRGBA(map->renderer, 500, 300, message, color.r, color.g, color.b, color.a);
 #endif
 
@@ -12,9 +12,9 @@
 
 
 static Button multithreadingButton;
-static Button gpuButton;
+static Button inferenceButton;
 static bool mtButtonInitialized = false;
-static bool gpuButtonInitialized = false;
+static bool inferenceButtonInitialized = false;
 
 void TrainingInterface_RenderDashboard(SDL_Renderer *renderer, Map *map)
 {
@@ -56,10 +56,10 @@ void TrainingInterface_RenderDashboard(SDL_Renderer *renderer, Map *map)
         Button_Init(&multithreadingButton, 400, 10, 120, 25, "");
         mtButtonInitialized = true;
     }
-    // Initialize and draw GPU button
-    if (!gpuButtonInitialized) {
-        Button_Init(&gpuButton, 530, 10, 120, 25, "");
-        gpuButtonInitialized = true;
+    // Initialize and draw inference backend button
+    if (!inferenceButtonInitialized) {
+        Button_Init(&inferenceButton, 530, 10, 120, 25, "");
+        inferenceButtonInitialized = true;
     }
 
     // Update button text to current state
@@ -75,15 +75,13 @@ void TrainingInterface_RenderDashboard(SDL_Renderer *renderer, Map *map)
     multithreadingButton.hoverColor = (SDL_Color){90, 90, 90, 255};
 #endif
 
-    // GPU button state
-    sprintf(gpuButton.label, "GPU: %s", map->useGpuAcceleration ? "ON" : "OFF");
-    gpuButton.bgColor = map->useGpuAcceleration ?
-        (SDL_Color){60, 120, 200, 255} : (SDL_Color){120, 60, 60, 255};
-    gpuButton.hoverColor = map->useGpuAcceleration ?
-        (SDL_Color){80, 140, 220, 255} : (SDL_Color){140, 80, 80, 255};
+    // Inference backend button state, a click switches to the next backend
+    sprintf(inferenceButton.label, "NN: %s", Inference_BackendName(map->inferenceBackend));
+    inferenceButton.bgColor = (SDL_Color){60, 120, 200, 255};
+    inferenceButton.hoverColor = (SDL_Color){80, 140, 220, 255};
 
     Button_Render(renderer, &multithreadingButton);
-    Button_Render(renderer, &gpuButton);
+    Button_Render(renderer, &inferenceButton);
 
     // Calculate column positions for 3-column layout
     int col1_x = 20;  // Text metrics column
@@ -144,8 +142,8 @@ void TrainingInterface_RenderMetrics(SDL_Renderer *renderer, Map *map, int x, in
     // Count alive cells only when needed
     if (updateData || lastUpdateFrame != map->frames) {
         cachedAliveCount = 0;
-        for (int i = 0; i < map->cellCount; ++i) {
-            if (map->cells[i] != NULL && map->cells[i]->isAlive) {
+        for (int i = 0; i < map->population.count; ++i) {
+            if (map->population.alive[i]) {
                 cachedAliveCount++;
             }
         }
@@ -172,11 +170,29 @@ void TrainingInterface_RenderMetrics(SDL_Renderer *renderer, Map *map, int x, in
 #endif
     currentY += lineHeight;
 
-    // GPU status
-    sprintf(text, "GPU Acceleration: %s", map->useGpuAcceleration ? "ENABLED" : "DISABLED");
-    SDL_Color gpuColor = map->useGpuAcceleration ? (SDL_Color){60, 120, 200, 255} : badColor;
-    stringRGBA(renderer, x, currentY, text, gpuColor.r, gpuColor.g, gpuColor.b, gpuColor.a);
-    currentY += lineHeight + 15;
+    // Inference backend, and how far its shadow drifts from it
+    SDL_Color inferenceColor = {60, 120, 200, 255};
+    if (map->decisionInterval > 1)
+        sprintf(text, "Inference: %s, decisions every %d ticks", Inference_BackendName(map->inferenceBackend),
+                map->decisionInterval);
+    else
+        sprintf(text, "Inference: %s", Inference_BackendName(map->inferenceBackend));
+    stringRGBA(renderer, x, currentY, text, inferenceColor.r, inferenceColor.g, inferenceColor.b, inferenceColor.a);
+    currentY += lineHeight;
+
+    const InferenceDivergence *divergence = &map->divergence;
+    if (map->shadowInterval > 0 && divergence->samples > 0) {
+        uint64_t flips = 0;
+        for (int i = 0; i < INFERENCE_DECISION_COUNT; i++)
+            flips += divergence->flips[i];
+        sprintf(text, "Shadow %s: diff %.2g (max %.2g), %.2f%% decisions, %.1fx time",
+                Inference_BackendName(map->shadowBackend), divergence->totalDifference / divergence->samples,
+                divergence->maxDifference, 100.0 * flips / (INFERENCE_DECISION_COUNT * divergence->samples),
+                divergence->backendTime > 0 ? divergence->shadowTime / divergence->backendTime : 0.0);
+        stringRGBA(renderer, x, currentY, text, valueColor.r, valueColor.g, valueColor.b, valueColor.a);
+        currentY += lineHeight;
+    }
+    currentY += 15;
 
     // Evolution metrics
     // sprintf(text, "EVOLUTION METRICS");
@@ -278,14 +294,14 @@ void TrainingInterface_RenderGraphs(SDL_Renderer *renderer, Map *map, int x, int
     barY += barSpacing;
 
     float scorePercent = (map->maxScore > 0) ?
-        (float)map->cells[map->currentBestCellIndex]->score / (float)map->maxScore : 0.0f;
+        (float)map->population.score[map->currentBestCellIndex] / (float)map->maxScore : 0.0f;
 
     SDL_Color scoreFgColor = (scorePercent > 0.9f) ? (SDL_Color){100, 255, 100, 255} :
                             (scorePercent > 0.7f) ? (SDL_Color){255, 200, 100, 255} :
                             (SDL_Color){255, 100, 100, 255};
 
     sprintf(barText, "Current best (%d) vs Best (%d): %.1f%%",
-            map->cells[map->currentBestCellIndex]->score, map->maxScore, scorePercent * 100.0f);
+            map->population.score[map->currentBestCellIndex], map->maxScore, scorePercent * 100.0f);
     ProgressBar_Render(renderer, x, barY, barWidth, barHeight,
                       scorePercent, barText, barBgColor, scoreFgColor);
 
@@ -294,8 +310,8 @@ void TrainingInterface_RenderGraphs(SDL_Renderer *renderer, Map *map, int x, int
 
     // Calculate alive count for this bar
     int aliveCount = 0;
-    for (int i = 0; i < map->cellCount; ++i) {
-        if (map->cells[i] != NULL && map->cells[i]->isAlive) {
+    for (int i = 0; i < map->population.count; ++i) {
+        if (map->population.alive[i]) {
             aliveCount++;
         }
     }
@@ -400,8 +416,8 @@ void TrainingInterface_HandleMouseEvents(Map *map, int mouseX, int mouseY, bool
         map->useMultithreading = !map->useMultithreading;
     }
 #endif
-    // GPU button
-    if (Button_Update(&gpuButton, mouseX, mouseY, mousePressed)) {
-        map->useGpuAcceleration = !map->useGpuAcceleration;
+    // Inference backend button
+    if (Button_Update(&inferenceButton, mouseX, mouseY, mousePressed)) {
+        Inference_SetBackend(map, (map->inferenceBackend + 1) % INFERENCE_BACKEND_COUNT);
     }
 }